@@ -0,0 +1,380 @@
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "particle_editor_lua.h"
+#include "particle_editor_float.h"
+#include "particle_editor_random.h"
+#include <ncine/TimeStamp.h>
+#include <ncine/FileSystem.h>
+
+/// A headless benchmark of the project and config loading and saving functions
+/*! It does not create an application, a window or a graphics context.
+ *  Usage: loader_benchmark [num systems] [num steps] [iterations] [output directory] */
+
+namespace {
+
+/// Heap usage of everything allocated with `operator new`, Lua allocations are not included
+struct AllocationStats
+{
+	size_t current = 0;
+	size_t peak = 0;
+};
+AllocationStats allocationStats;
+
+// The size is stored in front of every block to be able to track deallocations
+const size_t HeaderSize = alignof(std::max_align_t) > sizeof(size_t) ? alignof(std::max_align_t) : sizeof(size_t);
+
+struct Result
+{
+	const char *name;
+	float milliseconds;
+	unsigned long bytes;
+	unsigned int numSystems;
+	size_t peakAllocation;
+};
+
+void generateState(LuaLoader::State &state, unsigned int numSystems, unsigned int numSteps)
+{
+	state.normalizedAbsPosition.set(0.5f, 0.5f);
+
+	LuaLoader::State::BackgroundProperties &background = state.background;
+	background.color = nc::Colorf(0.125f, 0.25f, 0.375f, 1.0f);
+	background.imageName = "background.png";
+	background.imageNormalizedPosition.set(0.5f, 0.5f);
+	background.imageScale.set(1.25f, 1.25f);
+	background.imageLayer = 0;
+	background.imageColor = nc::Colorf(1.0f, 1.0f, 1.0f, 0.75f);
+	background.imageRect.set(0, 0, 1024, 768);
+	background.imageFlippedX = false;
+	background.imageFlippedY = true;
+
+	for (unsigned int i = 0; i < numSystems; i++)
+	{
+		state.systems.emplaceBack();
+		LuaLoader::State::ParticleSystem &s = state.systems.back();
+
+		const float fraction = i / static_cast<float>(numSystems);
+		s.name.format("system_%u", i);
+		s.numParticles = 256;
+		s.textureName = "smoke.png";
+		s.texRect.set(0, 0, 128, 128);
+		s.anchorPoint.set(0.5f, 0.5f);
+		s.flippedX = (i % 2 == 0);
+		s.flippedY = false;
+		s.blendingPreset = nc::DrawableNode::BlendingPreset::ADDITIVE;
+		s.position.set(fraction * 100.0f - 50.0f, fraction * 25.0f);
+		s.layer = 1;
+		s.inLocalSpace = (i % 3 == 0);
+		s.active = true;
+
+		s.sizeStepBaseScale.set(0.75f, 0.75f);
+		for (unsigned int j = 0; j < numSteps; j++)
+		{
+			const float age = (numSteps > 1) ? j / static_cast<float>(numSteps - 1) : 0.0f;
+			s.colorSteps.pushBack({ age, nc::Colorf(age, 1.0f - age, fraction, 1.0f - age * 0.5f) });
+			s.sizeSteps.pushBack({ age, nc::Vector2f(1.0f + age, 1.0f + age * 0.5f) });
+			s.rotationSteps.pushBack({ age, age * 360.0f });
+			s.positionSteps.pushBack({ age, nc::Vector2f(age * 10.0f, -age * 5.0f) });
+			s.velocitySteps.pushBack({ age, nc::Vector2f(-age * 3.3f, age * 7.7f) });
+		}
+
+		s.init.rndAmount.set(4, 8);
+		s.init.rndLife.set(0.85f, 1.15f);
+		s.init.rndPositionX.set(-10.0f, 10.0f);
+		s.init.rndPositionY.set(-2.5f, 2.5f);
+		s.init.rndVelocityX.set(-15.0f, 15.0f);
+		s.init.rndVelocityY.set(120.0f, 180.0f);
+		s.init.rndRotation.set(0.0f, 45.0f);
+		s.init.emitterRotation = true;
+		s.emitDelay = 0.2f + fraction;
+		s.randomSeed = CounterRandom::defaultSeed(i);
+		s.continuousEmission = (i % 2 == 1);
+		s.emissionRate = 100.0f + i;
+		s.prewarmTime = (i % 4 == 0) ? 1.5f : 0.0f;
+	}
+}
+
+unsigned long fileSize(const char *filename)
+{
+	FILE *file = fopen(filename, "rb");
+	if (file == nullptr)
+		return 0;
+	fseek(file, 0, SEEK_END);
+	const long size = ftell(file);
+	fclose(file);
+	return (size > 0) ? static_cast<unsigned long>(size) : 0;
+}
+
+/// Returns true if the two files have the same content, byte for byte
+bool sameContent(const char *firstFilename, const char *secondFilename)
+{
+	FILE *firstFile = fopen(firstFilename, "rb");
+	FILE *secondFile = fopen(secondFilename, "rb");
+	bool same = (firstFile != nullptr && secondFile != nullptr);
+	while (same)
+	{
+		char firstBuffer[4096];
+		char secondBuffer[4096];
+		const size_t firstBytes = fread(firstBuffer, 1, sizeof(firstBuffer), firstFile);
+		const size_t secondBytes = fread(secondBuffer, 1, sizeof(secondBuffer), secondFile);
+		same = (firstBytes == secondBytes && memcmp(firstBuffer, secondBuffer, firstBytes) == 0);
+		if (firstBytes == 0)
+			break;
+	}
+	if (firstFile)
+		fclose(firstFile);
+	if (secondFile)
+		fclose(secondFile);
+	return same;
+}
+
+/// Formats and parses a synthetic corpus of floats, returns the number of values that do not round-trip
+unsigned int checkFloatCorpus(unsigned int numValues)
+{
+	const float specialValues[] = { 0.0f, -0.0f, 1.0f, -1.0f, 0.1f, 0.5f, 1.0f / 3.0f, 360.0f, 1e-5f, 1e9f, 16777216.0f,
+		                            3.4028235e38f, -3.4028235e38f, 1.17549435e-38f, 1.4e-45f };
+	const unsigned int numSpecialValues = sizeof(specialValues) / sizeof(specialValues[0]);
+
+	unsigned int numFailures = 0;
+	unsigned int seed = 0x2545f491u;
+	for (unsigned int i = 0; i < numValues + numSpecialValues; i++)
+	{
+		float value = 0.0f;
+		if (i < numSpecialValues)
+			value = specialValues[i];
+		else
+		{
+			// Every other value is a random bit pattern, the others are in the range of editor properties
+			seed = seed * 1664525u + 1013904223u;
+			if (i % 2 == 0)
+			{
+				unsigned int bits = seed;
+				memcpy(&value, &bits, sizeof(value));
+				if (value != value || value - value != 0.0f)
+					continue; // NaNs and infinities are not written as numbers
+			}
+			else
+				value = (seed >> 8) / 16777216.0f * 2000.0f - 1000.0f;
+		}
+
+		const FloatString first(value);
+		const float parsedValue = static_cast<float>(FloatString::parse(first.data(), first.length()));
+		const FloatString second(parsedValue);
+		if (memcmp(&value, &parsedValue, sizeof(value)) != 0 || first.length() != second.length() ||
+		    memcmp(first.data(), second.data(), first.length()) != 0 || static_cast<float>(strtod(first.data(), nullptr)) != value)
+		{
+			if (numFailures < 8)
+				printf("Float round-trip failed: %.9g -> \"%s\" -> %.9g\n", value, first.data(), parsedValue);
+			numFailures++;
+		}
+	}
+
+	return numFailures;
+}
+
+template <class Func>
+Result measure(const char *name, unsigned int iterations, Func func)
+{
+	Result result;
+	result.name = name;
+	result.bytes = 0;
+	result.numSystems = 0;
+
+	const size_t baseAllocation = allocationStats.current;
+	allocationStats.peak = baseAllocation;
+	const nc::TimeStamp startTime = nc::TimeStamp::now();
+	for (unsigned int i = 0; i < iterations; i++)
+		func();
+	result.milliseconds = startTime.millisecondsSince();
+	result.peakAllocation = allocationStats.peak - baseAllocation;
+
+	return result;
+}
+
+void printResult(const Result &result, unsigned int iterations)
+{
+	const float seconds = result.milliseconds / 1000.0f;
+	const float megabytesPerSecond = (seconds > 0.0f) ? (result.bytes * iterations) / (seconds * 1024.0f * 1024.0f) : 0.0f;
+	const float systemsPerSecond = (seconds > 0.0f) ? (result.numSystems * iterations) / seconds : 0.0f;
+
+	printf("%-18s %10.3f ms %10.2f MB/s ", result.name, result.milliseconds / iterations, megabytesPerSecond);
+	if (result.numSystems > 0)
+		printf("%12.0f systems/s ", systemsPerSecond);
+	else
+		printf("%22s ", "-");
+	printf("%10.1f KB peak\n", result.peakAllocation / 1024.0f);
+}
+
+}
+
+void *operator new(size_t size)
+{
+	unsigned char *block = static_cast<unsigned char *>(malloc(size + HeaderSize));
+	if (block == nullptr)
+		throw std::bad_alloc();
+
+	*reinterpret_cast<size_t *>(block) = size;
+	allocationStats.current += size;
+	if (allocationStats.current > allocationStats.peak)
+		allocationStats.peak = allocationStats.current;
+
+	return block + HeaderSize;
+}
+
+void operator delete(void *ptr) noexcept
+{
+	if (ptr == nullptr)
+		return;
+
+	unsigned char *block = static_cast<unsigned char *>(ptr) - HeaderSize;
+	allocationStats.current -= *reinterpret_cast<size_t *>(block);
+	free(block);
+}
+
+void *operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+	operator delete(ptr);
+}
+
+int main(int argc, char **argv)
+{
+	const unsigned int numSystems = (argc > 1) ? static_cast<unsigned int>(atoi(argv[1])) : 64;
+	const unsigned int numSteps = (argc > 2) ? static_cast<unsigned int>(atoi(argv[2])) : 16;
+	const unsigned int iterations = (argc > 3 && atoi(argv[3]) > 0) ? static_cast<unsigned int>(atoi(argv[3])) : 20;
+	const char *outputDir = (argc > 4) ? argv[4] : ".";
+
+	const nctl::String projectFile = nc::fs::joinPath(outputDir, "benchmark_project.lua");
+	const nctl::String luaOnlyProjectFile = nc::fs::joinPath(outputDir, "benchmark_project_lua.lua");
+	const nctl::String binaryProjectFile = nc::fs::joinPath(outputDir, "benchmark_project.ncpb");
+	const nctl::String configFile = nc::fs::joinPath(outputDir, "benchmark_config.lua");
+	const nctl::String roundTripProjectFile = nc::fs::joinPath(outputDir, "benchmark_project_roundtrip.lua");
+	const nctl::String roundTripConfigFile = nc::fs::joinPath(outputDir, "benchmark_config_roundtrip.lua");
+
+	LuaLoader loader;
+	LuaLoader::State state;
+	generateState(state, numSystems, numSteps);
+
+	printf("%u systems, %u steps per affector, %u iterations\n\n", numSystems, numSteps, iterations);
+
+	Result results[9];
+	unsigned int numResults = 0;
+	unsigned int numFailures = 0;
+
+	results[numResults] = measure("save (Lua)", iterations, [&]() { loader.save(projectFile.data(), state); });
+	results[numResults].bytes = fileSize(projectFile.data());
+	results[numResults++].numSystems = numSystems;
+
+	results[numResults] = measure("load (parser)", iterations, [&]() {
+		LuaLoader::State loadedState;
+		if (loader.load(projectFile.data(), loadedState) == false)
+			numFailures++;
+	});
+	results[numResults].bytes = fileSize(projectFile.data());
+	results[numResults++].numSystems = numSystems;
+
+	// A leading block comment is not supported by the parser and makes the loader fall back to Lua
+	FILE *luaOnlyFile = fopen(luaOnlyProjectFile.data(), "wb");
+	FILE *sourceFile = fopen(projectFile.data(), "rb");
+	if (luaOnlyFile && sourceFile)
+	{
+		fputs("--[[ Loaded by Lua ]]\n", luaOnlyFile);
+		char buffer[4096];
+		size_t bytesRead = 0;
+		while ((bytesRead = fread(buffer, 1, sizeof(buffer), sourceFile)) > 0)
+			fwrite(buffer, 1, bytesRead, luaOnlyFile);
+	}
+	if (luaOnlyFile)
+		fclose(luaOnlyFile);
+	if (sourceFile)
+		fclose(sourceFile);
+
+	results[numResults] = measure("load (Lua)", iterations, [&]() {
+		LuaLoader::State loadedState;
+		if (loader.load(luaOnlyProjectFile.data(), loadedState) == false)
+			numFailures++;
+	});
+	results[numResults].bytes = fileSize(luaOnlyProjectFile.data());
+	results[numResults++].numSystems = numSystems;
+
+	results[numResults] = measure("save (binary)", iterations, [&]() { loader.save(binaryProjectFile.data(), state); });
+	results[numResults].bytes = fileSize(binaryProjectFile.data());
+	results[numResults++].numSystems = numSystems;
+
+	results[numResults] = measure("load (binary)", iterations, [&]() {
+		LuaLoader::State loadedState;
+		if (loader.load(binaryProjectFile.data(), loadedState) == false)
+			numFailures++;
+	});
+	results[numResults].bytes = fileSize(binaryProjectFile.data());
+	results[numResults++].numSystems = numSystems;
+
+	results[numResults] = measure("saveConfig", iterations, [&]() { loader.saveConfig(configFile.data()); });
+	results[numResults++].bytes = fileSize(configFile.data());
+
+	results[numResults] = measure("loadConfig", iterations, [&]() {
+		if (loader.loadConfig(configFile.data()) == false)
+			numFailures++;
+	});
+	results[numResults++].bytes = fileSize(configFile.data());
+
+	// The formatting of floats alone, with the shortest representation and with the former `%f`
+	// The throughput is measured on the characters produced, every iteration formats the same values
+	const unsigned int numFloats = 100000;
+	char floatBuffer[64];
+	unsigned long formattedBytes = 0;
+	results[numResults] = measure("format (shortest)", iterations, [&]() {
+		formattedBytes = 0;
+		for (unsigned int i = 0; i < numFloats; i++)
+			formattedBytes += FloatString::format(i * 0.37f - 1000.0f, floatBuffer);
+	});
+	results[numResults++].bytes = formattedBytes;
+	results[numResults] = measure("format (%f)", iterations, [&]() {
+		formattedBytes = 0;
+		for (unsigned int i = 0; i < numFloats; i++)
+			formattedBytes += snprintf(floatBuffer, sizeof(floatBuffer), "%f", i * 0.37f - 1000.0f);
+	});
+	results[numResults++].bytes = formattedBytes;
+
+	for (unsigned int i = 0; i < numResults; i++)
+		printResult(results[i], iterations);
+
+	// A project or a config that is saved, loaded and saved again should not change by a single byte
+	unsigned int numRoundTripFailures = checkFloatCorpus(1000000);
+	LuaLoader::State roundTripState;
+	const bool projectLoaded = loader.load(projectFile.data(), roundTripState);
+	if (projectLoaded)
+		loader.save(roundTripProjectFile.data(), roundTripState);
+	if (projectLoaded == false || sameContent(projectFile.data(), roundTripProjectFile.data()) == false)
+	{
+		printf("Project round-trip failed: %s\n", roundTripProjectFile.data());
+		numRoundTripFailures++;
+	}
+	if (loader.loadConfig(configFile.data()) == false || loader.saveConfig(roundTripConfigFile.data()) == false ||
+	    sameContent(configFile.data(), roundTripConfigFile.data()) == false)
+	{
+		printf("Config round-trip failed: %s\n", roundTripConfigFile.data());
+		numRoundTripFailures++;
+	}
+	printf("\nRound-trip failures: %u\n", numRoundTripFailures);
+
+	const LuaLoader::Statistics &stats = loader.statistics();
+	printf("\nLua states created: %u, reset: %u\n", stats.numStatesCreated, stats.numStateResets);
+
+	if (numFailures > 0)
+	{
+		printf("%u loads have failed\n", numFailures);
+		return EXIT_FAILURE;
+	}
+	else if (numRoundTripFailures > 0)
+		return EXIT_FAILURE;
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,184 @@
+#include <cstdio>
+#include <cstdlib>
+
+#include "particle_editor_packer.h"
+#include "particle_editor_random.h"
+#include <ncine/TimeStamp.h>
+
+/// A benchmark of the atlas packer that also checks the regions it produces
+/*! Every set of sizes is packed in pages as big as the editor ones. The regions are checked not to overlap,
+ *  padding included, and to fit in their pages. Rectangles bigger than a page should make the packing fail.
+ *  Usage: packer_benchmark [iterations] */
+
+namespace {
+
+const int PageSize = 2048;
+const int Padding = 2;
+const unsigned int NumRandomSets = 64;
+
+struct SizeCount
+{
+	int width;
+	int height;
+	unsigned int count;
+};
+
+/// The textures of a project with many particle systems
+const SizeCount ParticleTextures[] = {
+	{ 16, 16, 16 }, { 32, 32, 8 }, { 64, 64, 8 }, { 128, 128, 4 }, { 256, 256, 2 }, { 512, 512, 1 }
+};
+/// Squares that would exactly fill a page without padding
+const SizeCount Squares[] = { { 512, 512, 16 } };
+/// Long and thin rectangles in both directions
+const SizeCount Strips[] = { { 1024, 16, 24 }, { 16, 1024, 24 }, { 256, 32, 16 } };
+/// Rectangles that need more than one page
+const SizeCount LargeTextures[] = { { 1024, 1024, 5 }, { 1500, 600, 3 }, { 600, 1500, 3 } };
+
+void addSizes(AtlasPacker &packer, const SizeCount *sizes, unsigned int numSizes)
+{
+	packer.clear();
+	for (unsigned int i = 0; i < numSizes; i++)
+	{
+		for (unsigned int j = 0; j < sizes[i].count; j++)
+			packer.add(sizes[i].width, sizes[i].height);
+	}
+}
+
+void addRandomSizes(AtlasPacker &packer, uint32_t seed)
+{
+	CounterRandom random(seed);
+	packer.clear();
+	const int numRects = random.integer(1, 128);
+	for (int i = 0; i < numRects; i++)
+		packer.add(random.integer(1, 384), random.integer(1, 384));
+}
+
+/// Returns true if the two rectangles are closer than the padding, on the same page
+bool overlap(const AtlasPacker::Region &a, const AtlasPacker::Region &b, int padding)
+{
+	if (a.page != b.page)
+		return false;
+
+	const nc::Recti &r1 = a.rect;
+	const nc::Recti &r2 = b.rect;
+	return (r1.x < r2.x + r2.w + padding && r2.x < r1.x + r1.w + padding &&
+	        r1.y < r2.y + r2.h + padding && r2.y < r1.y + r1.h + padding);
+}
+
+/// Returns the number of regions that overlap another one or do not fit in their page
+unsigned int checkRegions(const AtlasPacker &packer)
+{
+	unsigned int numErrors = 0;
+	for (unsigned int i = 0; i < packer.size(); i++)
+	{
+		const AtlasPacker::Region &region = packer.region(i);
+		const nc::Recti &rect = region.rect;
+		if (rect.w <= 0 || rect.h <= 0)
+			continue;
+
+		if (region.page >= packer.numPages() || rect.x < 0 || rect.y < 0 ||
+		    rect.x + rect.w > packer.pageSize(region.page).x || rect.y + rect.h > packer.pageSize(region.page).y ||
+		    packer.pageSize(region.page).x > packer.pageWidth() || packer.pageSize(region.page).y > packer.pageHeight())
+		{
+			printf("Region #%u (%d, %d, %d x %d) does not fit in page #%u\n", i, rect.x, rect.y, rect.w, rect.h, region.page);
+			numErrors++;
+			continue;
+		}
+
+		for (unsigned int j = i + 1; j < packer.size(); j++)
+		{
+			const AtlasPacker::Region &other = packer.region(j);
+			if (other.rect.w > 0 && other.rect.h > 0 && overlap(region, other, packer.padding()))
+			{
+				printf("Region #%u (%d, %d, %d x %d) overlaps region #%u (%d, %d, %d x %d) in page #%u\n", i, rect.x, rect.y, rect.w, rect.h,
+				       j, other.rect.x, other.rect.y, other.rect.w, other.rect.h, region.page);
+				numErrors++;
+			}
+		}
+	}
+	return numErrors;
+}
+
+/// Packs the rectangles many times, prints the results and returns the number of errors
+unsigned int measure(const char *name, AtlasPacker &packer, unsigned int iterations)
+{
+	const nc::TimeStamp startTime = nc::TimeStamp::now();
+	bool packed = true;
+	for (unsigned int i = 0; i < iterations; i++)
+		packed = packer.pack() && packed;
+	const float milliseconds = startTime.millisecondsSince();
+
+	if (packed == false)
+	{
+		printf("%-20s could not be packed\n", name);
+		return 1;
+	}
+
+	printf("%-20s %8u %8u %11.1f%% %12.2f\n", name, packer.size(), packer.numPages(), packer.efficiency() * 100.0f, milliseconds * 1000.0f / iterations);
+	return checkRegions(packer);
+}
+
+}
+
+int main(int argc, char **argv)
+{
+	const unsigned int iterations = (argc > 1 && atoi(argv[1]) > 0) ? static_cast<unsigned int>(atoi(argv[1])) : 100;
+
+	printf("Pages of %d x %d with a padding of %d, %u iterations\n\n", PageSize, PageSize, Padding, iterations);
+	printf("%-20s %8s %8s %12s %12s\n", "Set", "Rects", "Pages", "Efficiency", "Pack us");
+
+	unsigned int numErrors = 0;
+	AtlasPacker packer(PageSize, PageSize, Padding);
+
+	addSizes(packer, ParticleTextures, sizeof(ParticleTextures) / sizeof(ParticleTextures[0]));
+	numErrors += measure("Particle textures", packer, iterations);
+	addSizes(packer, Squares, sizeof(Squares) / sizeof(Squares[0]));
+	numErrors += measure("Squares", packer, iterations);
+	addSizes(packer, Strips, sizeof(Strips) / sizeof(Strips[0]));
+	numErrors += measure("Strips", packer, iterations);
+	addSizes(packer, LargeTextures, sizeof(LargeTextures) / sizeof(LargeTextures[0]));
+	numErrors += measure("Large textures", packer, iterations);
+
+	// Random sets are only checked, their mean efficiency is reported
+	float efficiencySum = 0.0f;
+	unsigned int numPages = 0;
+	for (unsigned int i = 0; i < NumRandomSets; i++)
+	{
+		addRandomSizes(packer, i);
+		if (packer.pack() == false)
+		{
+			printf("Random set #%u could not be packed\n", i);
+			numErrors++;
+			continue;
+		}
+		numErrors += checkRegions(packer);
+		efficiencySum += packer.efficiency();
+		numPages += packer.numPages();
+	}
+	printf("%-20s %8s %8.1f %11.1f%% %12s\n", "Random (mean)", "", numPages / static_cast<float>(NumRandomSets), efficiencySum / NumRandomSets * 100.0f, "");
+
+	// A rectangle that fills a page fits, a bigger one in either direction does not
+	const int oversizedSizes[][2] = { { PageSize + 1, 1 }, { 1, PageSize + 1 }, { PageSize + 1, PageSize + 1 } };
+	for (const int(&size)[2] : oversizedSizes)
+	{
+		packer.clear();
+		packer.add(64, 64);
+		packer.add(size[0], size[1]);
+		if (packer.pack())
+		{
+			printf("A rectangle of %d x %d has been packed in pages of %d x %d\n", size[0], size[1], PageSize, PageSize);
+			numErrors++;
+		}
+	}
+	packer.clear();
+	packer.add(PageSize, PageSize);
+	if (packer.pack() == false || packer.numPages() != 1)
+	{
+		printf("A rectangle as big as a page could not be packed\n");
+		numErrors++;
+	}
+
+	if (numErrors > 0)
+		printf("\n%u errors\n", numErrors);
+	return (numErrors > 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
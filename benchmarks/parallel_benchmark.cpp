@@ -0,0 +1,153 @@
+#include <cstdio>
+#include <cstdlib>
+
+#include "particle_editor_soa.h"
+#include <ncine/TimeStamp.h>
+
+/// A scaling benchmark of the parallel update stage, from one thread to the number of processors
+/*! A scene of many small systems and a few large ones is updated by the same stage with a growing
+ *  number of threads. Particles are emitted on the main thread before every update, from the random
+ *  stream of every system, and the final states must be identical to the single threaded ones.
+ *  Usage: parallel_benchmark [max threads] [iterations] */
+
+namespace {
+
+const float Interval = 1.0f / 60.0f;
+
+const unsigned int NumSmallSystems = 48;
+const unsigned int SmallSystemCapacity = 4000;
+const unsigned int NumLargeSystems = 2;
+const unsigned int LargeSystemCapacity = 200000;
+const unsigned int NumSteps = 8;
+
+void generateSystem(LuaLoader::State::ParticleSystem &s, unsigned int index, unsigned int capacity)
+{
+	s.sizeStepBaseScale.set(1.0f, 1.0f);
+	for (unsigned int i = 0; i < NumSteps; i++)
+	{
+		const float age = i / static_cast<float>(NumSteps - 1);
+		s.colorSteps.pushBack({ age, nc::Colorf(age, 1.0f - age, 0.5f, 1.0f - age * 0.5f) });
+		s.sizeSteps.pushBack({ age, nc::Vector2f(1.0f + age, 1.0f + age * 0.5f) });
+		s.rotationSteps.pushBack({ age, age * 360.0f });
+		s.positionSteps.pushBack({ age, nc::Vector2f(age * 0.1f * index, -age * 0.05f) });
+		s.velocitySteps.pushBack({ age, nc::Vector2f(-age * 0.3f, age * 0.7f) });
+	}
+
+	// Every system emits about a sixtieth of its capacity per update and lives for about a second
+	const int amount = static_cast<int>(capacity / 60);
+	s.init.rndAmount.set(amount / 2, amount);
+	s.init.rndLife.set(0.75f, 1.25f);
+	s.init.rndPositionX.set(-10.0f, 10.0f);
+	s.init.rndPositionY.set(-2.5f, 2.5f);
+	s.init.rndVelocityX.set(-15.0f, 15.0f);
+	s.init.rndVelocityY.set(120.0f, 180.0f);
+	s.init.rndRotation.set(0.0f, 45.0f);
+	s.init.emitterRotation = false;
+	s.randomSeed = CounterRandom::defaultSeed(index);
+}
+
+struct Result
+{
+	float updateTime = 0.0f;
+	unsigned int numStolenJobs = 0;
+	double checksum = 0.0;
+	unsigned int numAlive = 0;
+};
+
+/// Emission always happens on the main thread, before the parallel update
+void step(SoaUpdateStage &stage, nctl::Array<SoaParticleSystem *> &systems, float &updateTime)
+{
+	for (SoaParticleSystem *system : systems)
+		system->emitParticles(system->init(), nc::Vector2f(0.0f, 0.0f));
+
+	const nc::TimeStamp startTime = nc::TimeStamp::now();
+	stage.update(systems.data(), systems.size(), Interval);
+	updateTime += startTime.millisecondsSince();
+}
+
+Result measure(const nctl::Array<LuaLoader::State::ParticleSystem> &scene, unsigned int numThreads, unsigned int iterations)
+{
+	nctl::Array<nctl::UniquePtr<SoaParticleSystem>> systemStorage(scene.size());
+	nctl::Array<SoaParticleSystem *> systems(scene.size());
+	for (unsigned int i = 0; i < scene.size(); i++)
+	{
+		const unsigned int capacity = (i < NumLargeSystems) ? LargeSystemCapacity : SmallSystemCapacity;
+		systemStorage.pushBack(nctl::makeUnique<SoaParticleSystem>(capacity));
+		systemStorage.back()->setup(scene[i]);
+		systems.pushBack(systemStorage.back().get());
+	}
+
+	JobPool pool(numThreads);
+	SoaUpdateStage stage(pool);
+
+	// The untimed warm-up reaches the steady state number of alive particles
+	float warmUpTime = 0.0f;
+	for (unsigned int i = 0; i < iterations; i++)
+		step(stage, systems, warmUpTime);
+
+	Result result;
+	for (unsigned int i = 0; i < iterations; i++)
+	{
+		step(stage, systems, result.updateTime);
+		result.numStolenJobs += pool.numStolenJobs();
+	}
+	result.updateTime /= iterations;
+
+	for (const SoaParticleSystem *system : systems)
+	{
+		result.numAlive += system->numAliveParticles();
+		for (unsigned int i = 0; i < system->numAliveParticles(); i++)
+			result.checksum += system->position(i).x + system->position(i).y + system->rotation(i);
+	}
+	return result;
+}
+
+/// Doubles the number of threads, the maximum is always measured last
+unsigned int nextNumThreads(unsigned int numThreads, unsigned int maxThreads)
+{
+	if (numThreads == maxThreads)
+		return maxThreads + 1;
+	return (numThreads * 2 < maxThreads) ? numThreads * 2 : maxThreads;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+	const unsigned int maxThreads = (argc > 1 && atoi(argv[1]) > 0) ? static_cast<unsigned int>(atoi(argv[1])) : JobPool::defaultNumThreads();
+	const unsigned int iterations = (argc > 2 && atoi(argv[2]) > 0) ? static_cast<unsigned int>(atoi(argv[2])) : 60;
+
+	nctl::Array<LuaLoader::State::ParticleSystem> scene(NumLargeSystems + NumSmallSystems);
+	for (unsigned int i = 0; i < NumLargeSystems + NumSmallSystems; i++)
+	{
+		scene.emplaceBack();
+		generateSystem(scene.back(), i, (i < NumLargeSystems) ? LargeSystemCapacity : SmallSystemCapacity);
+	}
+
+	printf("%u systems of %u particles and %u of %u, %u updates, ranges of %u particles, vector kernels: %s\n\n",
+	       NumSmallSystems, SmallSystemCapacity, NumLargeSystems, LargeSystemCapacity, iterations,
+	       SoaUpdateStage::RangeSize, SoaParticleSystem::simdName());
+	printf("%8s %12s %10s %12s %14s\n", "Threads", "Update ms", "Speedup", "Efficiency", "Stolen jobs");
+
+	Result singleThreaded;
+	unsigned int numMismatches = 0;
+	for (unsigned int numThreads = 1; numThreads <= maxThreads; numThreads = nextNumThreads(numThreads, maxThreads))
+	{
+		const Result result = measure(scene, numThreads, iterations);
+		if (numThreads == 1)
+			singleThreaded = result;
+
+		const float speedup = (result.updateTime > 0.0f) ? singleThreaded.updateTime / result.updateTime : 0.0f;
+		printf("%8u %12.4f %9.2fx %11.0f%% %14.1f\n", numThreads, result.updateTime, speedup,
+		       speedup * 100.0f / numThreads, result.numStolenJobs / static_cast<float>(iterations));
+
+		// Emission is sequential and every particle is updated by a single job, results must be identical
+		if (result.numAlive != singleThreaded.numAlive || result.checksum != singleThreaded.checksum)
+		{
+			printf("The results with %u threads differ from the single threaded ones\n", numThreads);
+			numMismatches++;
+		}
+	}
+
+	return (numMismatches > 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
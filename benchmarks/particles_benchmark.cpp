@@ -0,0 +1,322 @@
+#include <cstdio>
+#include <cstdlib>
+
+#include "particle_editor_soa.h"
+#include <nctl/UniquePtr.h>
+#include <ncine/TimeStamp.h>
+
+/// A microbenchmark of the particle update, comparing one particle at a time with the structure of arrays
+/*! The reference path mirrors the affector loop of `nc::ParticleSystem`: every alive particle is an object,
+ *  every affector searches its steps for each particle. It does not include the sprite nodes of the engine.
+ *  A second table shows how the cost of the step interpolation and of the baked curves grows with the number of steps.
+ *  Usage: particles_benchmark [num steps] [iterations] */
+
+namespace {
+
+const float Interval = 1.0f / 60.0f;
+const uint32_t RandomSeed = 0x7f4a7c15u;
+const unsigned int SweepStepCounts[] = { 2, 4, 8, 16, 32, 64 };
+const unsigned int SweepParticleCount = 100000;
+
+struct Particle
+{
+	nc::Vector2f position;
+	nc::Vector2f velocity;
+	float life = 0.0f;
+	float startingLife = 0.0f;
+	float rotation = 0.0f;
+	nc::Colorf color;
+	nc::Vector2f scale;
+};
+
+template <class Step, class Value>
+Value interpolateSteps(const nctl::Array<Step> &steps, float normalizedAge, Value Step::*member)
+{
+	if (normalizedAge <= steps[0].age)
+		return steps[0].*member;
+	else if (normalizedAge >= steps[steps.size() - 1].age)
+		return steps[steps.size() - 1].*member;
+
+	unsigned int index = 0;
+	for (index = 0; index < steps.size() - 1; index++)
+	{
+		if (steps[index].age > normalizedAge)
+			break;
+	}
+	const Step &prevStep = steps[index - 1];
+	const Step &nextStep = steps[index];
+	const float factor = (normalizedAge - prevStep.age) / (nextStep.age - prevStep.age);
+	return prevStep.*member + (nextStep.*member - prevStep.*member) * factor;
+}
+
+class Affector
+{
+  public:
+	virtual ~Affector() {}
+	virtual void affect(Particle &particle, float normalizedAge) = 0;
+};
+
+template <class Step, class Value>
+class ValueAffector : public Affector
+{
+  public:
+	ValueAffector(const nctl::Array<Step> &steps, Value Step::*member, Value Particle::*target, bool accumulate)
+	    : steps_(steps), member_(member), target_(target), accumulate_(accumulate) {}
+	void affect(Particle &particle, float normalizedAge) override
+	{
+		if (steps_.isEmpty())
+			return;
+		const Value value = interpolateSteps(steps_, normalizedAge, member_);
+		particle.*target_ = accumulate_ ? particle.*target_ + value : value;
+	}
+
+  private:
+	const nctl::Array<Step> &steps_;
+	Value Step::*member_;
+	Value Particle::*target_;
+	bool accumulate_;
+};
+
+/// The color steps are split in components to reuse the interpolation of the other affectors
+struct ScalarColorStep
+{
+	float age;
+	float r, g, b, a;
+};
+
+class ColorAffector : public Affector
+{
+  public:
+	explicit ColorAffector(const nctl::Array<ScalarColorStep> &steps)
+	    : steps_(steps) {}
+	void affect(Particle &particle, float normalizedAge) override
+	{
+		if (steps_.isEmpty())
+			return;
+		particle.color.set(interpolateSteps(steps_, normalizedAge, &ScalarColorStep::r), interpolateSteps(steps_, normalizedAge, &ScalarColorStep::g),
+		                   interpolateSteps(steps_, normalizedAge, &ScalarColorStep::b), interpolateSteps(steps_, normalizedAge, &ScalarColorStep::a));
+	}
+
+  private:
+	const nctl::Array<ScalarColorStep> &steps_;
+};
+
+class ReferenceParticleSystem
+{
+  public:
+	ReferenceParticleSystem(unsigned int capacity, const LuaLoader::State::ParticleSystem &system)
+	    : particles_(capacity), affectors_(5), colorSteps_(system.colorSteps.size()), sizeSteps_(system.sizeSteps), random_(system.randomSeed)
+	{
+		for (unsigned int i = 0; i < capacity; i++)
+			particles_.emplaceBack();
+		for (unsigned int i = 0; i < system.colorSteps.size(); i++)
+		{
+			const LuaLoader::State::ColorStep &step = system.colorSteps[i];
+			colorSteps_.pushBack({ step.age, step.color.r(), step.color.g(), step.color.b(), step.color.a() });
+		}
+		for (unsigned int i = 0; i < sizeSteps_.size(); i++)
+		{
+			sizeSteps_[i].scale.x *= system.sizeStepBaseScale.x;
+			sizeSteps_[i].scale.y *= system.sizeStepBaseScale.y;
+		}
+
+		affectors_.pushBack(nctl::makeUnique<ColorAffector>(colorSteps_));
+		affectors_.pushBack(nctl::makeUnique<ValueAffector<LuaLoader::State::SizeStep, nc::Vector2f>>(sizeSteps_, &LuaLoader::State::SizeStep::scale, &Particle::scale, false));
+		affectors_.pushBack(nctl::makeUnique<ValueAffector<LuaLoader::State::RotationStep, float>>(system.rotationSteps, &LuaLoader::State::RotationStep::angle, &Particle::rotation, false));
+		affectors_.pushBack(nctl::makeUnique<ValueAffector<LuaLoader::State::PositionStep, nc::Vector2f>>(system.positionSteps, &LuaLoader::State::PositionStep::position, &Particle::position, true));
+		affectors_.pushBack(nctl::makeUnique<ValueAffector<LuaLoader::State::VelocityStep, nc::Vector2f>>(system.velocitySteps, &LuaLoader::State::VelocityStep::velocity, &Particle::velocity, true));
+	}
+
+	unsigned int numAliveParticles() const { return numAlive_; }
+
+	void emitParticles(const nc::ParticleInitializer &init, const nc::Vector2f &emitterPosition)
+	{
+		// The same random numbers are drawn in the same order as `SoaParticleSystem`
+		const unsigned int amount = random_.integer(init.rndAmount.x, init.rndAmount.y + 1);
+		for (unsigned int i = 0; i < amount && numAlive_ < particles_.size(); i++)
+		{
+			Particle &particle = particles_[numAlive_++];
+			particle.life = random_.real(init.rndLife.x, init.rndLife.y);
+			particle.startingLife = particle.life;
+			particle.position.x = emitterPosition.x + random_.real(init.rndPositionX.x, init.rndPositionX.y);
+			particle.position.y = emitterPosition.y + random_.real(init.rndPositionY.x, init.rndPositionY.y);
+			particle.velocity.x = random_.real(init.rndVelocityX.x, init.rndVelocityX.y);
+			particle.velocity.y = random_.real(init.rndVelocityY.x, init.rndVelocityY.y);
+			particle.rotation = init.emitterRotation ? 0.0f : random_.real(init.rndRotation.x, init.rndRotation.y);
+			particle.color = nc::Colorf(1.0f, 1.0f, 1.0f, 1.0f);
+			particle.scale.set(1.0f, 1.0f);
+		}
+	}
+
+	void update(float interval)
+	{
+		unsigned int i = 0;
+		while (i < numAlive_)
+		{
+			Particle &particle = particles_[i];
+			const float normalizedAge = 1.0f - particle.life / particle.startingLife;
+			for (unsigned int j = 0; j < affectors_.size(); j++)
+				affectors_[j]->affect(particle, normalizedAge);
+			particle.life -= interval;
+			particle.position += particle.velocity * interval;
+
+			if (particle.life > 0.0f)
+				i++;
+			else
+				particle = particles_[--numAlive_];
+		}
+	}
+
+	double checksum() const
+	{
+		double sum = 0.0;
+		for (unsigned int i = 0; i < numAlive_; i++)
+			sum += particles_[i].position.x + particles_[i].position.y;
+		return sum;
+	}
+
+  private:
+	nctl::Array<Particle> particles_;
+	unsigned int numAlive_ = 0;
+	nctl::Array<nctl::UniquePtr<Affector>> affectors_;
+	nctl::Array<ScalarColorStep> colorSteps_;
+	nctl::Array<LuaLoader::State::SizeStep> sizeSteps_;
+	CounterRandom random_;
+};
+
+void generateSystem(LuaLoader::State::ParticleSystem &s, unsigned int numSteps, unsigned int iterations)
+{
+	s.sizeStepBaseScale.set(0.75f, 0.75f);
+	for (unsigned int i = 0; i < numSteps; i++)
+	{
+		const float age = (numSteps > 1) ? i / static_cast<float>(numSteps - 1) : 0.0f;
+		s.colorSteps.pushBack({ age, nc::Colorf(age, 1.0f - age, 0.5f, 1.0f - age * 0.5f) });
+		s.sizeSteps.pushBack({ age, nc::Vector2f(1.0f + age, 1.0f + age * 0.5f) });
+		s.rotationSteps.pushBack({ age, age * 360.0f });
+		s.positionSteps.pushBack({ age, nc::Vector2f(age * 0.1f, -age * 0.05f) });
+		s.velocitySteps.pushBack({ age, nc::Vector2f(-age * 0.3f, age * 0.7f) });
+	}
+
+	// Particles survive the warm-up and the measured updates, reaching different normalized ages
+	const float duration = iterations * Interval;
+	s.init.rndAmount.set(1, 1);
+	s.init.rndLife.set(duration * 2.0f + Interval, duration * 4.0f);
+	s.init.rndPositionX.set(-10.0f, 10.0f);
+	s.init.rndPositionY.set(-2.5f, 2.5f);
+	s.init.rndVelocityX.set(-15.0f, 15.0f);
+	s.init.rndVelocityY.set(120.0f, 180.0f);
+	s.init.rndRotation.set(0.0f, 45.0f);
+	s.init.emitterRotation = false;
+	s.randomSeed = RandomSeed;
+}
+
+double soaChecksum(const SoaParticleSystem &system)
+{
+	double sum = 0.0;
+	for (unsigned int i = 0; i < system.numAliveParticles(); i++)
+		sum += system.position(i).x + system.position(i).y;
+	return sum;
+}
+
+template <class System>
+void fill(System &system, unsigned int numParticles, const nc::ParticleInitializer &init)
+{
+	for (unsigned int i = 0; i < numParticles; i++)
+		system.emitParticles(init, nc::Vector2f(0.0f, 0.0f));
+}
+
+/// The untimed warm-up spreads the ages of the particles over the steps
+template <class System>
+float measureUpdates(System &system, unsigned int iterations)
+{
+	for (unsigned int i = 0; i < iterations; i++)
+		system.update(Interval);
+
+	const nc::TimeStamp startTime = nc::TimeStamp::now();
+	for (unsigned int i = 0; i < iterations; i++)
+		system.update(Interval);
+	return startTime.millisecondsSince() / iterations;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+	const unsigned int numSteps = (argc > 1 && atoi(argv[1]) > 0) ? static_cast<unsigned int>(atoi(argv[1])) : 8;
+	const unsigned int iterations = (argc > 2 && atoi(argv[2]) > 0) ? static_cast<unsigned int>(atoi(argv[2])) : 60;
+	const unsigned int particleCounts[] = { 1000, 10000, 100000 };
+
+	LuaLoader::State::ParticleSystem system;
+	generateSystem(system, numSteps, iterations);
+
+	printf("%u steps per affector, %u updates, vector kernels: %s (%u particles per instruction)\n\n",
+	       numSteps, iterations, SoaParticleSystem::simdName(), SoaParticleSystem::SimdWidth);
+	printf("%10s %14s %14s %14s %10s %10s\n", "Particles", "Reference ms", "SoA scalar ms", "SoA SIMD ms", "Scalar x", "SIMD x");
+
+	unsigned int numMismatches = 0;
+	for (unsigned int particleCount : particleCounts)
+	{
+		ReferenceParticleSystem reference(particleCount, system);
+		fill(reference, particleCount, system.init);
+		const float referenceTime = measureUpdates(reference, iterations);
+
+		SoaParticleSystem soaScalar(particleCount);
+		soaScalar.setup(system);
+		soaScalar.setSimdEnabled(false);
+		soaScalar.setLutEnabled(false);
+		fill(soaScalar, particleCount, system.init);
+		const float scalarTime = measureUpdates(soaScalar, iterations);
+
+		SoaParticleSystem soaSimd(particleCount);
+		soaSimd.setup(system);
+		soaSimd.setLutEnabled(false);
+		fill(soaSimd, particleCount, system.init);
+		const float simdTime = measureUpdates(soaSimd, iterations);
+
+		printf("%10u %14.4f %14.4f %14.4f %9.2fx %9.2fx\n", particleCount, referenceTime, scalarTime, simdTime,
+		       (scalarTime > 0.0f) ? referenceTime / scalarTime : 0.0f, (simdTime > 0.0f) ? referenceTime / simdTime : 0.0f);
+
+		// All paths start from the same particles and should end in the same place
+		const double referenceSum = reference.checksum();
+		const double tolerance = 1e-4 * (1.0 + (referenceSum < 0.0 ? -referenceSum : referenceSum));
+		const double scalarDiff = soaChecksum(soaScalar) - referenceSum;
+		const double simdDiff = soaChecksum(soaSimd) - referenceSum;
+		if (reference.numAliveParticles() != soaSimd.numAliveParticles() || scalarDiff > tolerance || scalarDiff < -tolerance ||
+		    simdDiff > tolerance || simdDiff < -tolerance)
+		{
+			printf("The structure of arrays results differ from the reference ones with %u particles\n", particleCount);
+			numMismatches++;
+		}
+	}
+
+	// The baked curves sample the steps, their results only approximate the reference ones
+	printf("\nStep interpolation and baked curves (%u samples) with %u particles\n\n", CurveLut::Resolution, SweepParticleCount);
+	printf("%10s %14s %14s %14s %10s %12s\n", "Steps", "Reference ms", "SoA steps ms", "SoA LUT ms", "LUT x", "LUT error");
+	for (unsigned int sweepSteps : SweepStepCounts)
+	{
+		LuaLoader::State::ParticleSystem sweepSystem;
+		generateSystem(sweepSystem, sweepSteps, iterations);
+
+		ReferenceParticleSystem reference(SweepParticleCount, sweepSystem);
+		fill(reference, SweepParticleCount, sweepSystem.init);
+		const float referenceTime = measureUpdates(reference, iterations);
+
+		SoaParticleSystem soaSteps(SweepParticleCount);
+		soaSteps.setup(sweepSystem);
+		soaSteps.setLutEnabled(false);
+		fill(soaSteps, SweepParticleCount, sweepSystem.init);
+		const float stepsTime = measureUpdates(soaSteps, iterations);
+
+		SoaParticleSystem soaLut(SweepParticleCount);
+		soaLut.setup(sweepSystem);
+		fill(soaLut, SweepParticleCount, sweepSystem.init);
+		const float lutTime = measureUpdates(soaLut, iterations);
+
+		const double referenceSum = reference.checksum();
+		const double lutError = (referenceSum != 0.0) ? (soaChecksum(soaLut) - referenceSum) / referenceSum : 0.0;
+		printf("%10u %14.4f %14.4f %14.4f %9.2fx %11.2e\n", sweepSteps, referenceTime, stepsTime, lutTime,
+		       (lutTime > 0.0f) ? stepsTime / lutTime : 0.0f, (lutError < 0.0) ? -lutError : lutError);
+	}
+
+	return (numMismatches > 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,133 @@
+#include <cstdio>
+#include <cstdlib>
+
+#include "particle_editor_scheduler.h"
+#include "particle_editor_random.h"
+#include <ncine/TimeStamp.h>
+
+namespace nc = ncine;
+
+/// A benchmark of the emission scheduler against the polling of every system on every frame
+/*! Delays grow with the number of systems and the first emissions are spread over a whole delay, so about
+ *  the same number of systems is due on every frame. The polling cost grows with the number of systems,
+ *  the scheduler one should stay close to constant.
+ *  Usage: scheduler_benchmark [frames] */
+
+namespace {
+
+const double FrameTime = 1.0 / 60.0;
+const unsigned int NumDuePerFrame = 16;
+const unsigned int SystemCounts[] = { 100, 1000, 10000, 100000 };
+
+struct Result
+{
+	float milliseconds = 0.0f;
+	unsigned long numEmissions = 0;
+};
+
+struct System
+{
+	float delay;
+	/// The first emission happens after a fraction of the delay
+	float phase;
+};
+
+/// Every system is due once every `numSystems / NumDuePerFrame` frames on average
+void generateSystems(nctl::Array<System> &systems, unsigned int numSystems)
+{
+	CounterRandom random(numSystems);
+	const float meanDelay = static_cast<float>(numSystems * FrameTime / NumDuePerFrame);
+	systems.clear();
+	for (unsigned int i = 0; i < numSystems; i++)
+	{
+		const float delay = random.real(meanDelay * 0.5f, meanDelay * 1.5f);
+		systems.pushBack({ delay, random.real(0.0f, delay) });
+	}
+}
+
+Result poll(const nctl::Array<System> &systems, unsigned int numFrames)
+{
+	nctl::Array<double> lastEmissionTimes(systems.size());
+	for (unsigned int i = 0; i < systems.size(); i++)
+		lastEmissionTimes.pushBack(systems[i].phase - systems[i].delay);
+
+	Result result;
+	const nc::TimeStamp startTime = nc::TimeStamp::now();
+	for (unsigned int frame = 1; frame <= numFrames; frame++)
+	{
+		const double time = frame * FrameTime;
+		for (unsigned int i = 0; i < systems.size(); i++)
+		{
+			if (time >= lastEmissionTimes[i] + systems[i].delay)
+			{
+				lastEmissionTimes[i] = time;
+				result.numEmissions++;
+			}
+		}
+	}
+	result.milliseconds = startTime.millisecondsSince();
+	return result;
+}
+
+Result schedule(const nctl::Array<System> &systems, unsigned int numFrames, EmissionScheduler::Statistics &lastStatistics)
+{
+	EmissionScheduler scheduler;
+	for (unsigned int i = 0; i < systems.size(); i++)
+	{
+		// Same arithmetic as the polling, so that both wake up a system on the same frame
+		const double lastEmissionTime = systems[i].phase - systems[i].delay;
+		scheduler.schedule(i, lastEmissionTime + systems[i].delay);
+	}
+	nctl::Array<unsigned int> dueIndices(NumDuePerFrame * 4);
+
+	Result result;
+	const nc::TimeStamp startTime = nc::TimeStamp::now();
+	for (unsigned int frame = 1; frame <= numFrames; frame++)
+	{
+		const double time = frame * FrameTime;
+		dueIndices.clear();
+		scheduler.popDue(time, dueIndices);
+		for (unsigned int i = 0; i < dueIndices.size(); i++)
+		{
+			const unsigned int index = dueIndices[i];
+			scheduler.schedule(index, time + systems[index].delay);
+			result.numEmissions++;
+		}
+	}
+	result.milliseconds = startTime.millisecondsSince();
+	lastStatistics = scheduler.statistics();
+	return result;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+	const unsigned int numFrames = (argc > 1 && atoi(argv[1]) > 0) ? static_cast<unsigned int>(atoi(argv[1])) : 3600;
+
+	printf("%u frames, about %u systems due per frame\n\n", numFrames, NumDuePerFrame);
+	printf("%10s %14s %14s %12s %16s %14s\n", "Systems", "Polling us", "Scheduler us", "Speedup", "Due per frame", "Heap size");
+
+	unsigned int numMismatches = 0;
+	nctl::Array<System> systems(SystemCounts[3]);
+	for (unsigned int numSystems : SystemCounts)
+	{
+		generateSystems(systems, numSystems);
+		EmissionScheduler::Statistics statistics;
+		const Result polling = poll(systems, numFrames);
+		const Result scheduled = schedule(systems, numFrames, statistics);
+
+		const float speedup = (scheduled.milliseconds > 0.0f) ? polling.milliseconds / scheduled.milliseconds : 0.0f;
+		printf("%10u %14.3f %14.3f %11.1fx %16.2f %14u\n", numSystems, polling.milliseconds * 1000.0f / numFrames,
+		       scheduled.milliseconds * 1000.0f / numFrames, speedup, scheduled.numEmissions / static_cast<float>(numFrames), statistics.heapSize);
+
+		// Both strategies wake up a system on the first frame at or after its due time
+		if (polling.numEmissions != scheduled.numEmissions)
+		{
+			printf("The scheduler emitted %lu times instead of %lu\n", scheduled.numEmissions, polling.numEmissions);
+			numMismatches++;
+		}
+	}
+
+	return (numMismatches > 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,104 @@
+option(CUSTOM_BENCHMARKS "Build the headless loader, particles, parallel update, emission scheduler and atlas packer benchmarks" OFF)
+option(CUSTOM_BENCHMARKS_AVX2 "Compile the particles benchmarks kernels with AVX2 instead of SSE" OFF)
+
+if(CUSTOM_BENCHMARKS AND NOT EMSCRIPTEN AND NOT CMAKE_SYSTEM_NAME STREQUAL "Android")
+	set(BENCHMARK_EXE_NAME ${NCPROJECT_EXE_NAME}_loader_benchmark)
+
+	# The benchmark only needs the loader, it runs without an application, a window or a graphics context
+	add_executable(${BENCHMARK_EXE_NAME}
+		benchmarks/loader_benchmark.cpp
+		src/particle_editor_lua.h
+		src/particle_editor_lua.cpp
+		src/particle_editor_binary.cpp
+		src/particle_editor_writer.h
+		src/particle_editor_writer.cpp
+		src/particle_editor_names.h
+		src/particle_editor_parser.h
+		src/particle_editor_parser.cpp
+		src/particle_editor_float.h
+		src/particle_editor_float.cpp
+		src/particle_editor_lut.h
+		src/particle_editor_lut.cpp
+		src/particle_editor_random.h
+	)
+	target_include_directories(${BENCHMARK_EXE_NAME} PRIVATE src)
+	target_link_libraries(${BENCHMARK_EXE_NAME} PRIVATE ncine::ncine)
+	set_target_properties(${BENCHMARK_EXE_NAME} PROPERTIES CXX_STANDARD 11 CXX_STANDARD_REQUIRED ON)
+	message(STATUS "Loader benchmark target: ${BENCHMARK_EXE_NAME}")
+
+	set(PARTICLES_BENCHMARK_EXE_NAME ${NCPROJECT_EXE_NAME}_particles_benchmark)
+
+	# The structure of arrays particle system does not create any scene node, it only needs the engine math and random functions
+	add_executable(${PARTICLES_BENCHMARK_EXE_NAME}
+		benchmarks/particles_benchmark.cpp
+		src/particle_editor_soa.h
+		src/particle_editor_soa.cpp
+		src/particle_editor_lut.h
+		src/particle_editor_lut.cpp
+		src/particle_editor_random.h
+		src/particle_editor_jobpool.h
+		src/particle_editor_jobpool.cpp
+	)
+	target_include_directories(${PARTICLES_BENCHMARK_EXE_NAME} PRIVATE src)
+	target_link_libraries(${PARTICLES_BENCHMARK_EXE_NAME} PRIVATE ncine::ncine)
+	set_target_properties(${PARTICLES_BENCHMARK_EXE_NAME} PROPERTIES CXX_STANDARD 11 CXX_STANDARD_REQUIRED ON)
+	if(CUSTOM_BENCHMARKS_AVX2)
+		if(MSVC)
+			target_compile_options(${PARTICLES_BENCHMARK_EXE_NAME} PRIVATE /arch:AVX2)
+		else()
+			target_compile_options(${PARTICLES_BENCHMARK_EXE_NAME} PRIVATE -mavx2)
+		endif()
+	endif()
+	message(STATUS "Particles benchmark target: ${PARTICLES_BENCHMARK_EXE_NAME}")
+
+	set(PARALLEL_BENCHMARK_EXE_NAME ${NCPROJECT_EXE_NAME}_parallel_benchmark)
+
+	add_executable(${PARALLEL_BENCHMARK_EXE_NAME}
+		benchmarks/parallel_benchmark.cpp
+		src/particle_editor_soa.h
+		src/particle_editor_soa.cpp
+		src/particle_editor_lut.h
+		src/particle_editor_lut.cpp
+		src/particle_editor_random.h
+		src/particle_editor_jobpool.h
+		src/particle_editor_jobpool.cpp
+	)
+	target_include_directories(${PARALLEL_BENCHMARK_EXE_NAME} PRIVATE src)
+	target_link_libraries(${PARALLEL_BENCHMARK_EXE_NAME} PRIVATE ncine::ncine)
+	set_target_properties(${PARALLEL_BENCHMARK_EXE_NAME} PROPERTIES CXX_STANDARD 11 CXX_STANDARD_REQUIRED ON)
+	if(CUSTOM_BENCHMARKS_AVX2)
+		if(MSVC)
+			target_compile_options(${PARALLEL_BENCHMARK_EXE_NAME} PRIVATE /arch:AVX2)
+		else()
+			target_compile_options(${PARALLEL_BENCHMARK_EXE_NAME} PRIVATE -mavx2)
+		endif()
+	endif()
+	message(STATUS "Parallel benchmark target: ${PARALLEL_BENCHMARK_EXE_NAME}")
+
+	set(SCHEDULER_BENCHMARK_EXE_NAME ${NCPROJECT_EXE_NAME}_scheduler_benchmark)
+
+	add_executable(${SCHEDULER_BENCHMARK_EXE_NAME}
+		benchmarks/scheduler_benchmark.cpp
+		src/particle_editor_scheduler.h
+		src/particle_editor_scheduler.cpp
+		src/particle_editor_random.h
+	)
+	target_include_directories(${SCHEDULER_BENCHMARK_EXE_NAME} PRIVATE src)
+	target_link_libraries(${SCHEDULER_BENCHMARK_EXE_NAME} PRIVATE ncine::ncine)
+	set_target_properties(${SCHEDULER_BENCHMARK_EXE_NAME} PROPERTIES CXX_STANDARD 11 CXX_STANDARD_REQUIRED ON)
+	message(STATUS "Scheduler benchmark target: ${SCHEDULER_BENCHMARK_EXE_NAME}")
+
+	set(PACKER_BENCHMARK_EXE_NAME ${NCPROJECT_EXE_NAME}_packer_benchmark)
+
+	# The packer only works on sizes, it does not need a graphics context
+	add_executable(${PACKER_BENCHMARK_EXE_NAME}
+		benchmarks/packer_benchmark.cpp
+		src/particle_editor_packer.h
+		src/particle_editor_packer.cpp
+		src/particle_editor_random.h
+	)
+	target_include_directories(${PACKER_BENCHMARK_EXE_NAME} PRIVATE src)
+	target_link_libraries(${PACKER_BENCHMARK_EXE_NAME} PRIVATE ncine::ncine)
+	set_target_properties(${PACKER_BENCHMARK_EXE_NAME} PROPERTIES CXX_STANDARD 11 CXX_STANDARD_REQUIRED ON)
+	message(STATUS "Packer benchmark target: ${PACKER_BENCHMARK_EXE_NAME}")
+endif()
@@ -0,0 +1,6 @@
+option(CUSTOM_PROFILER "Record the duration of the frame phases and export them as a Chrome trace" OFF)
+
+if(CUSTOM_PROFILER)
+	target_compile_definitions(${NCPROJECT_EXE_NAME} PRIVATE "WITH_PROFILER")
+	message(STATUS "Frame profiler enabled, save a trace with CTRL + P")
+endif()
@@ -0,0 +1,27 @@
+option(CUSTOM_BATCH_TOOL "Build the command line tool that validates and converts project files" ON)
+
+if(CUSTOM_BATCH_TOOL AND NOT EMSCRIPTEN AND NOT CMAKE_SYSTEM_NAME STREQUAL "Android")
+	set(BATCH_TOOL_EXE_NAME ${NCPROJECT_EXE_NAME}_batch)
+
+	# The tool only needs the loader, it runs without an application, a window or a graphics context
+	add_executable(${BATCH_TOOL_EXE_NAME}
+		tools/batch_tool.cpp
+		src/particle_editor_lua.h
+		src/particle_editor_lua.cpp
+		src/particle_editor_binary.cpp
+		src/particle_editor_writer.h
+		src/particle_editor_writer.cpp
+		src/particle_editor_names.h
+		src/particle_editor_parser.h
+		src/particle_editor_parser.cpp
+		src/particle_editor_float.h
+		src/particle_editor_float.cpp
+		src/particle_editor_lut.h
+		src/particle_editor_lut.cpp
+		src/particle_editor_random.h
+	)
+	target_include_directories(${BATCH_TOOL_EXE_NAME} PRIVATE src)
+	target_link_libraries(${BATCH_TOOL_EXE_NAME} PRIVATE ncine::ncine)
+	set_target_properties(${BATCH_TOOL_EXE_NAME} PROPERTIES CXX_STANDARD 11 CXX_STANDARD_REQUIRED ON)
+	message(STATUS "Batch tool target: ${BATCH_TOOL_EXE_NAME}")
+endif()
@@ -6,16 +6,26 @@
 	#error nCine must have ImGui integration enabled for this application to work
 #endif
 
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
 #include "particle_editor.h"
 #include "particle_editor_lua.h"
+#include "particle_editor_loadjob.h"
+#include "particle_editor_textures.h"
+#include "particle_editor_atlas.h"
+#include "particle_editor_profiler.h"
 
 #include <ncine/Application.h>
 #include <ncine/Viewport.h>
 #include <ncine/Texture.h>
 #include <ncine/Sprite.h>
 #include <ncine/ParticleSystem.h>
+#include <ncine/Particle.h>
 #include <ncine/IInputManager.h>
 #include <ncine/FileSystem.h>
+#include <ncine/Random.h>
 
 #ifdef WITH_CRASHRPT
 	#include "CrashRptWrapper.h"
@@ -24,6 +34,20 @@
 namespace {
 
 const char *ConfigFile = "config.lua";
+/// Prewarm updates are never longer than this, to keep emissions and deaths close to their real times
+const float MaxPrewarmTimeStep = 0.1f;
+
+/// The scheduler needs more precision than the seconds of a time stamp to work during long sessions
+inline double timeStampSeconds(const nc::TimeStamp &timeStamp)
+{
+	return timeStamp.nanoseconds() * 1.0e-9;
+}
+
+/// The interval between two frames, systems with no delay emit once per frame
+inline float frameInterval(const LuaLoader::Config &cfg)
+{
+	return (cfg.frameLimit > 0) ? 1.0f / cfg.frameLimit : 1.0f / 60.0f;
+}
 
 }
 
@@ -35,9 +59,10 @@ nctl::UniquePtr<nc::IAppEventHandler> createAppEventHandler()
 MyEventHandler::MyEventHandler()
     : recentFilenames_(nctl::StaticArrayMode::EXTEND_SIZE),
       loader_(nctl::makeUnique<LuaLoader>()),
-      sysStates_(4), texNames_(4),
-      textures_(4), texturesToDelete_(4),
-      particleSystems_(4)
+      projectLoadJob_(nctl::makeUnique<ProjectLoadJob>()),
+      sysStates_(4), textures_(nctl::makeUnique<TextureRegistry>()),
+      textureAtlas_(nctl::makeUnique<TextureAtlas>()), texturesToDelete_(4),
+      particleSystems_(4), frameTimes_(LuaLoader::Config::DefaultPerformanceHistory)
 {
 	nc::IInputManager::setHandler(this);
 }
@@ -70,8 +95,9 @@ void MyEventHandler::onPreInit(nc::AppConfiguration &config)
 	LuaLoader::Config &luaConfig = loader_->config();
 	if (nc::fs::isReadableFile(configFile_.data()))
 	{
+		const nc::TimeStamp loadStartTime = nc::TimeStamp::now();
 		if (loader_->loadConfig(configFile_.data()))
-			logString_.formatAppend("Loaded config file \"%s\"\n", configFile_.data());
+			logLoadTime(*loader_, configFile_.data(), loadStartTime.millisecondsSince(), false);
 		else
 			logString_.formatAppend("Could not load config file \"%s\"\n", configFile_.data());
 	}
@@ -106,6 +132,15 @@ void MyEventHandler::onPreInit(nc::AppConfiguration &config)
 	config.graphics.opengl.useBufferMapping = luaConfig.useBufferMapping;
 	config.graphics.opengl.vboSize = luaConfig.vboSize;
 	config.graphics.opengl.iboSize = luaConfig.iboSize;
+
+	// A simulation quits before the first frame, the window is only needed for the graphics context
+	simulationMode_ = parseSimulationArguments(config);
+	if (simulationMode_)
+	{
+		config.window.fullscreen = false;
+		config.window.resizable = false;
+		config.graphics.vsync = false;
+	}
 }
 
 void MyEventHandler::onInit()
@@ -119,16 +154,19 @@ void MyEventHandler::onInit()
 	nc::SceneNode &rootNode = nc::theApplication().rootNode();
 	dummy_ = nctl::makeUnique<nc::SceneNode>(&rootNode, parentPosition_.x, parentPosition_.y);
 
+	if (simulationMode_)
+	{
+		simulationFailed_ = (runSimulation() == false);
+		nc::theApplication().quit();
+		return;
+	}
+
 	const LuaLoader::Config &luaConfig = loader_->config();
 	if (luaConfig.startupScriptName.isEmpty() == false)
 	{
 		const nctl::String startupScript = luaConfig.scriptsPath + luaConfig.startupScriptName;
 		if (nc::fs::isReadableFile(startupScript.data()))
-		{
-			load(startupScript.data());
-			filename_ = luaConfig.startupScriptName;
-			pushRecentFile(filename_);
-		}
+			load(startupScript.data(), luaConfig.startupScriptName.data());
 	}
 	autoEmission_ = luaConfig.autoEmissionOnStart;
 
@@ -138,7 +176,7 @@ void MyEventHandler::onInit()
 	loader_->localFileLoad.setLoadedCallback([](const nc::EmscriptenLocalFile &localFile, void *userData) {
 		MyEventHandler *eventHandler = reinterpret_cast<MyEventHandler *>(userData);
 		if (localFile.size() > 0)
-			eventHandler->load(localFile.filename(), &localFile);
+			eventHandler->load(localFile.filename(), nullptr, &localFile);
 	}, this);
 
 	loader_->localFileLoadConfig.setLoadedCallback([](const nc::EmscriptenLocalFile &localFile, void *userData) {
@@ -151,15 +189,54 @@ void MyEventHandler::onInit()
 
 void MyEventHandler::onFrameStart()
 {
-	applyConfig();
-	deleteUnusedTextures();
+#ifdef WITH_PROFILER
+	theFrameProfiler().nextFrame();
+#endif
+	PROFILE_SCOPE("onFrameStart");
+	frameTimes_.push(nc::theApplication().frameTime() * 1000.0f);
 
-	createGuiMainWindow();
-	createGuiConfigWindow();
-	createGuiLogWindow();
+	{
+		PROFILE_SCOPE("applyConfig");
+		applyConfig();
+	}
+	{
+		PROFILE_SCOPE("deleteUnusedTextures");
+		deleteUnusedTextures();
+	}
+	// The scene has been visited once since the load, the absolute positions of the emitters are known
+	if (prewarmPending_)
+	{
+		prewarmParticleSystems();
+		prewarmPending_ = false;
+	}
+	updateProjectLoad();
+
+	{
+		PROFILE_SCOPE("createGuiMainWindow");
+		createGuiMainWindow();
+	}
+	{
+		PROFILE_SCOPE("createGuiConfigWindow");
+		createGuiConfigWindow();
+	}
+	{
+		PROFILE_SCOPE("createGuiLogWindow");
+		createGuiLogWindow();
+	}
+	{
+		PROFILE_SCOPE("createGuiPerformanceWindow");
+		createGuiPerformanceWindow();
+	}
 
 	if (autoEmission_)
-		emitParticles();
+	{
+		PROFILE_SCOPE("emitScheduledParticles");
+		emitScheduledParticles();
+	}
+	{
+		PROFILE_SCOPE("skipIdleSystems");
+		skipIdleSystems();
+	}
 }
 
 void MyEventHandler::onShutdown()
@@ -167,6 +244,10 @@ void MyEventHandler::onShutdown()
 #ifdef WITH_CRASHRPT
 	CrashRptWrapper::uninstall();
 #endif
+
+	// The engine always returns a success from `main()`, a script running a simulation needs to know it failed
+	if (simulationFailed_)
+		exit(EXIT_FAILURE);
 }
 
 void MyEventHandler::onKeyPressed(const nc::KeyboardEvent &event)
@@ -179,6 +260,12 @@ void MyEventHandler::onKeyPressed(const nc::KeyboardEvent &event)
 			showConfigWindow_ = !showConfigWindow_;
 		else if (event.sym == nc::KeySym::N3)
 			showLogWindow_ = !showLogWindow_;
+		else if (event.sym == nc::KeySym::N4)
+			showPerformanceWindow_ = !showPerformanceWindow_;
+#ifdef WITH_PROFILER
+		else if (event.sym == nc::KeySym::P)
+			menuSaveTrace();
+#endif
 		else if (event.sym == nc::KeySym::N)
 		{
 			if (menuNewEnabled())
@@ -200,14 +287,20 @@ void MyEventHandler::onKeyPressed(const nc::KeyboardEvent &event)
 
 void MyEventHandler::emitParticles(unsigned int index)
 {
-	nc::ParticleSystem *particleSystem = particleSystems_[index].get();
+	PROFILE_SYSTEM_SCOPE("emitParticles", index);
 	ParticleSystemGuiState &s = sysStates_[index];
 
-	if (s.active && (s.emitDelay == 0.0f || (s.emitDelay > 0.0f && s.lastEmissionTime.secondsSince() > s.emitDelay)))
+	if (s.active && s.continuousEmission)
 	{
-		particleSystem->emitParticles(s.init);
+		emitContinuousParticles(index, s.lastEmissionTime.secondsSince());
 		s.lastEmissionTime = nc::TimeStamp::now();
 	}
+	else if (s.active && (s.emitDelay == 0.0f || (s.emitDelay > 0.0f && s.lastEmissionTime.secondsSince() > s.emitDelay)))
+	{
+		emitSeededParticles(index, s.init);
+		s.lastEmissionTime = nc::TimeStamp::now();
+	}
+	scheduleEmission(index);
 }
 
 void MyEventHandler::emitParticles()
@@ -216,6 +309,176 @@ void MyEventHandler::emitParticles()
 		emitParticles(i);
 }
 
+void MyEventHandler::emitScheduledParticles()
+{
+	// Due systems are collected first, as a system with no delay is due again as soon as it is rescheduled
+	dueSystems_.clear();
+	emissionScheduler_.popDue(timeStampSeconds(nc::TimeStamp::now()), dueSystems_);
+	for (unsigned int i = 0; i < dueSystems_.size(); i++)
+		emitParticles(dueSystems_[i]);
+}
+
+/*! The time of a burst emission is compared with a strict inequality by `emitParticles()`, a system that
+ *  is woken up a little early is not emitted and is scheduled again for the same time. */
+void MyEventHandler::scheduleEmission(unsigned int index)
+{
+	const ParticleSystemGuiState &s = sysStates_[index];
+	const double lastEmissionTime = timeStampSeconds(s.lastEmissionTime);
+
+	if (s.active == false || (s.continuousEmission && s.emissionRate <= 0.0f) || (s.continuousEmission == false && s.emitDelay < 0.0f))
+		emissionScheduler_.unschedule(index);
+	else if (s.continuousEmission)
+		emissionScheduler_.schedule(index, lastEmissionTime + (1.0f - s.emissionAccumulator) / s.emissionRate);
+	else
+		emissionScheduler_.schedule(index, lastEmissionTime + s.emitDelay);
+}
+
+void MyEventHandler::scheduleEmissions()
+{
+	emissionScheduler_.clear();
+	for (unsigned int i = 0; i < sysStates_.size(); i++)
+		scheduleEmission(i);
+}
+
+/*! The number of particles does not depend on how the time is split in frames. All due particles are emitted at once,
+ *  then each one is aged like the update would have done: its life is reduced and it is moved by its own velocity. */
+unsigned int MyEventHandler::emitContinuousParticles(unsigned int index, float interval)
+{
+	ParticleSystemGuiState &s = sysStates_[index];
+	if (s.emissionRate <= 0.0f)
+		return 0;
+
+	// Particles that were due for longer than the maximum life would not be emitted anyway
+	if (interval > s.init.rndLife.y)
+		interval = s.init.rndLife.y;
+	s.emissionAccumulator += s.emissionRate * interval;
+	const unsigned int numParticles = static_cast<unsigned int>(s.emissionAccumulator);
+	s.emissionAccumulator -= numParticles;
+
+	// The last particle was due `accumulator * period` seconds ago, every previous one a period before
+	const float period = 1.0f / s.emissionRate;
+	unsigned int numDue = 0;
+	while (numDue < numParticles && (s.emissionAccumulator + numDue) * period < s.init.rndLife.y)
+		numDue++;
+	if (numDue == 0)
+		return 0;
+
+	// The particles that are not alive before the emission are the only ones that can be emitted
+	nc::ParticleSystem *particleSystem = particleSystems_[index].get();
+	deadParticles_.clear();
+	for (nc::SceneNode *child : particleSystem->children())
+	{
+		nc::Particle *particle = static_cast<nc::Particle *>(child);
+		if (particle->isAlive() == false)
+			deadParticles_.pushBack(particle);
+	}
+
+	nc::ParticleInitializer init = s.init;
+	init.rndAmount.set(static_cast<int>(numDue), static_cast<int>(numDue));
+	emitSeededParticles(index, init);
+
+	unsigned int numEmitted = 0;
+	for (nc::Particle *particle : deadParticles_)
+	{
+		if (particle->isAlive() == false || numEmitted >= numDue)
+			continue;
+
+		// A particle that would already be dead is left with no life and is killed by the next update
+		const float age = (s.emissionAccumulator + numEmitted) * period;
+		particle->life_ = (age < particle->startingLife) ? particle->startingLife - age : 0.0f;
+		particle->setPosition(particle->position() + particle->velocity_ * age);
+		numEmitted++;
+	}
+
+	return numEmitted;
+}
+
+/*! The engine draws from the global generator, which is seeded from the stream of the system before every emission.
+ *  Emissions only depend on the seed of the system and on how many times it has emitted since the stream restarted. */
+void MyEventHandler::emitSeededParticles(unsigned int index, const nc::ParticleInitializer &init)
+{
+	ParticleSystemGuiState &s = sysStates_[index];
+	nc::random().init(s.random.next64(), s.randomSeed);
+	particleSystems_[index]->emitParticles(init);
+}
+
+/*! Color, size and rotation steps only depend on the normalized age and velocities are integrated linearly,
+ *  so most systems are advanced in updates much longer than a frame. Position and velocity steps are applied
+ *  once per update, like the bursts of a system with no delay, those systems are advanced at the frame rate. */
+unsigned int MyEventHandler::prewarmParticleSystem(unsigned int index)
+{
+	PROFILE_SYSTEM_SCOPE("prewarmParticleSystem", index);
+	ParticleSystemGuiState &s = sysStates_[index];
+	nc::ParticleSystem *particleSystem = particleSystems_[index].get();
+	const bool burstEmission = (s.continuousEmission == false);
+	if (s.prewarmTime <= 0.0f || s.active == false || (burstEmission && s.emitDelay < 0.0f))
+		return 0;
+
+	const float frameTimeStep = frameInterval(loader_->config());
+	float timeStep = MaxPrewarmTimeStep;
+	if (s.positionAffector->steps().isEmpty() == false || s.velocityAffector->steps().isEmpty() == false || (burstEmission && s.emitDelay == 0.0f))
+		timeStep = frameTimeStep;
+	else if (burstEmission)
+	{
+		// The delay is split in equal updates, so that bursts happen on an update
+		timeStep = s.emitDelay / ceilf(s.emitDelay / MaxPrewarmTimeStep);
+	}
+	if (timeStep < frameTimeStep)
+		timeStep = frameTimeStep;
+
+	// Like after a load, the first burst happens after a whole delay. The time since the last burst is accumulated
+	// and the remainder is kept, half an update of tolerance prevents a rounding error from postponing a burst.
+	const unsigned int numUpdates = static_cast<unsigned int>(ceilf(s.prewarmTime / timeStep));
+	float burstTime = 0.0f;
+	for (unsigned int i = 0; i < numUpdates; i++)
+	{
+		if (s.continuousEmission)
+			emitContinuousParticles(index, timeStep);
+		else if (burstTime + timeStep * 0.5f >= s.emitDelay)
+		{
+			emitSeededParticles(index, s.init);
+			burstTime -= s.emitDelay;
+		}
+		particleSystem->update(timeStep);
+		burstTime += timeStep;
+	}
+
+	s.lastEmissionTime = nc::TimeStamp::now();
+	scheduleEmission(index);
+	return numUpdates;
+}
+
+void MyEventHandler::prewarmParticleSystems()
+{
+	PROFILE_SCOPE("prewarmParticleSystems");
+	const float frameTimeStep = frameInterval(loader_->config());
+	const nc::TimeStamp startTime = nc::TimeStamp::now();
+	unsigned int numSystems = 0;
+	unsigned int numUpdates = 0;
+	unsigned int numFrames = 0;
+	for (unsigned int i = 0; i < particleSystems_.size(); i++)
+	{
+		const unsigned int numSystemUpdates = prewarmParticleSystem(i);
+		if (numSystemUpdates > 0)
+		{
+			numSystems++;
+			numUpdates += numSystemUpdates;
+			numFrames += static_cast<unsigned int>(ceilf(sysStates_[i].prewarmTime / frameTimeStep));
+		}
+	}
+
+	if (numSystems > 0)
+	{
+		logString_.formatAppend("Prewarmed %u particle systems in %.2f ms with %u updates instead of %u frames\n",
+		                        numSystems, startTime.millisecondsSince(), numUpdates, numFrames);
+	}
+}
+
+uint32_t MyEventHandler::newRandomSeed()
+{
+	return static_cast<uint32_t>(CounterRandom::hash(nc::TimeStamp::now().ticks()) >> 32);
+}
+
 void MyEventHandler::killParticles(unsigned int index)
 {
 	nc::ParticleSystem *particleSystem = particleSystems_[index].get();
@@ -223,6 +486,8 @@ void MyEventHandler::killParticles(unsigned int index)
 
 	particleSystem->killParticles();
 	s.lastEmissionTime = nc::TimeStamp::now();
+	s.emissionAccumulator = 0.0f;
+	scheduleEmission(index);
 }
 
 void MyEventHandler::killParticles()
@@ -231,30 +496,95 @@ void MyEventHandler::killParticles()
 		killParticles(i);
 }
 
-bool MyEventHandler::load(const char *filename)
+bool MyEventHandler::load(const char *filename, const char *projectName)
 #ifdef __EMSCRIPTEN__
 {
-	return load(filename, nullptr);
+	return load(filename, projectName, nullptr);
 }
 
-bool MyEventHandler::load(const char *filename, const nc::EmscriptenLocalFile *localFile)
+bool MyEventHandler::load(const char *filename, const char *projectName, const nc::EmscriptenLocalFile *localFile)
 #endif
 {
-	LuaLoader::State loaderState;
+	if (projectLoadJob_->isActive())
+	{
+		logString_.formatAppend("Cannot load project file \"%s\" while \"%s\" is loading\n", filename, projectLoadJob_->filename().data());
+		return false;
+	}
+
+	const LuaLoader::Config &luaConfig = loader_->config();
 #ifndef __EMSCRIPTEN__
-	if (loader_->load(filename, loaderState) == false)
+	return projectLoadJob_->start(filename, projectName, luaConfig.texturesPath.data());
 #else
-	if (loader_->load(filename, loaderState, localFile) == false)
+	return projectLoadJob_->start(filename, projectName, luaConfig.texturesPath.data(), localFile);
 #endif
+}
+
+void MyEventHandler::updateProjectLoad()
+{
+	PROFILE_SCOPE("updateProjectLoad");
+	ProjectLoadJob &job = *projectLoadJob_;
+	if (job.status() == ProjectLoadJob::Status::FAILED)
 	{
-		logString_.formatAppend("Could not load project file \"%s\"\n", filename);
-		return false;
+		logString_.formatAppend("Could not load project file \"%s\"\n", job.filename().data());
+		job.reset();
+		return;
 	}
+	else if (job.status() != ProjectLoadJob::Status::LOADED)
+		return;
 
-	if (loaderState.systems.isEmpty())
-		return false;
-	else
+	// The previous project is destroyed only when the new one is ready to replace it
+	if (job.numCommittedTextures() == 0)
+	{
+		if (job.texturesRead() == false)
+		{
+			for (const ProjectLoadJob::TextureFile &texture : job.textures())
+			{
+				if (texture.buffer.get() == nullptr || texture.size == 0)
+					logString_.formatAppend("Cannot load texture \"%s\"\n", texture.path.data());
+			}
+			logString_.formatAppend("Could not load project file \"%s\"\n", job.filename().data());
+			job.reset();
+			return;
+		}
 		clearData();
+	}
+
+	const unsigned int textureIndex = job.numCommittedTextures();
+	if (textureIndex < job.textures().size())
+	{
+		const ProjectLoadJob::TextureFile &texture = job.textures()[textureIndex];
+		if (createTexture(texture.name, texture.path.data(), texture.buffer.get(), texture.size) == false)
+		{
+			logString_.formatAppend("Could not load project file \"%s\"\n", job.filename().data());
+			job.reset();
+			return;
+		}
+		job.textureCommitted();
+		return;
+	}
+
+	applyLoadedProject();
+	if (job.projectName().isEmpty() == false)
+	{
+		filename_ = job.projectName();
+		pushRecentFile(filename_);
+	}
+	logLoadTime(job.loader(), job.filename().data(), job.elapsedTime(), true);
+	if (job.textures().isEmpty() == false)
+	{
+		const float serialReadTime = job.texturesSerialReadTime();
+		const float readTime = job.texturesReadTime();
+		logString_.formatAppend("Read %u textures in %.2f ms with %u threads (%.2f ms serial, %.2fx speedup)\n",
+		                        job.textures().size(), readTime, job.numReaderThreads(), serialReadTime,
+		                        (readTime > 0.0f) ? serialReadTime / readTime : 1.0f);
+	}
+	job.reset();
+}
+
+void MyEventHandler::applyLoadedProject()
+{
+	PROFILE_SCOPE("applyLoadedProject");
+	LuaLoader::State &loaderState = projectLoadJob_->state();
 
 	background_ = loaderState.background.color;
 	nc::theApplication().screenViewport().setClearColor(background_);
@@ -293,24 +623,13 @@ bool MyEventHandler::load(const char *filename, const nc::EmscriptenLocalFile *l
 		dest.flippedY = src.flippedY;
 		dest.blendingPreset = src.blendingPreset;
 
-		for (unsigned int texIndex = 0; texIndex < texNames_.size(); texIndex++)
+		// Textures have already been created by `updateProjectLoad()`
+		const unsigned int texIndex = textures_->indexOf(src.textureName);
+		if (texIndex != TextureRegistry::InvalidIndex)
 		{
-			if (texNames_[texIndex] == src.textureName)
-			{
-				dest.texture = textures_[texIndex].get();
-				nctl::String texName = src.textureName;
-				break;
-			}
-		}
-		if (dest.texture == nullptr)
-		{
-			texIndex_ = textures_.size();
-			texNames_.emplaceBack(nctl::String(MaxStringLength));
-			texNames_.back() = src.textureName;
-			const bool result = createTexture(texIndex_);
-			if (result == false)
-				return false;
-			dest.texture = textures_[texIndex_].get();
+			texIndex_ = texIndex;
+			dest.texture = textures_->texture(texIndex);
+			textures_->acquire(dest.texture);
 		}
 
 		dest.position = src.position;
@@ -320,42 +639,59 @@ bool MyEventHandler::load(const char *filename, const nc::EmscriptenLocalFile *l
 
 		createParticleSystem(systemIndex);
 
+		// Curves are built before being shared, identical ones in the project are only stored once
+		nctl::UniquePtr<nc::ColorAffector> colorCurve = nctl::makeUnique<nc::ColorAffector>();
 		for (unsigned int i = 0; i < src.colorSteps.size(); i++)
 		{
 			const LuaLoader::State::ColorStep &step = src.colorSteps[i];
-			dest.colorAffector->addColorStep(step.age, step.color);
+			colorCurve->addColorStep(step.age, step.color);
 		}
+		dest.colorAffector = dest.sharedColorAffector->replace(nctl::move(colorCurve));
 
 		dest.baseScale = src.sizeStepBaseScale;
 		dest.baseScaleLock = (dest.baseScale.x == dest.baseScale.y);
-		dest.sizeAffector->setBaseScale(src.sizeStepBaseScale);
+		nctl::UniquePtr<nc::SizeAffector> sizeCurve = nctl::makeUnique<nc::SizeAffector>();
+		sizeCurve->setBaseScale(src.sizeStepBaseScale);
 		for (unsigned int i = 0; i < src.sizeSteps.size(); i++)
 		{
 			const LuaLoader::State::SizeStep &step = src.sizeSteps[i];
-			dest.sizeAffector->addSizeStep(step.age, step.scale);
+			sizeCurve->addSizeStep(step.age, step.scale);
 		}
+		dest.sizeAffector = dest.sharedSizeAffector->replace(nctl::move(sizeCurve));
 
+		nctl::UniquePtr<nc::RotationAffector> rotationCurve = nctl::makeUnique<nc::RotationAffector>();
 		for (unsigned int i = 0; i < src.rotationSteps.size(); i++)
 		{
 			const LuaLoader::State::RotationStep &step = src.rotationSteps[i];
-			dest.rotationAffector->addRotationStep(step.age, step.angle);
+			rotationCurve->addRotationStep(step.age, step.angle);
 		}
+		dest.rotationAffector = dest.sharedRotationAffector->replace(nctl::move(rotationCurve));
 
+		nctl::UniquePtr<nc::PositionAffector> positionCurve = nctl::makeUnique<nc::PositionAffector>();
 		for (unsigned int i = 0; i < src.positionSteps.size(); i++)
 		{
 			const LuaLoader::State::PositionStep &step = src.positionSteps[i];
-			dest.positionAffector->addPositionStep(step.age, step.position);
+			positionCurve->addPositionStep(step.age, step.position);
 		}
+		dest.positionAffector = dest.sharedPositionAffector->replace(nctl::move(positionCurve));
 
+		nctl::UniquePtr<nc::VelocityAffector> velocityCurve = nctl::makeUnique<nc::VelocityAffector>();
 		for (unsigned int i = 0; i < src.velocitySteps.size(); i++)
 		{
 			const LuaLoader::State::VelocityStep &step = src.velocitySteps[i];
-			dest.velocityAffector->addVelocityStep(step.age, step.velocity);
+			velocityCurve->addVelocityStep(step.age, step.velocity);
 		}
+		dest.velocityAffector = dest.sharedVelocityAffector->replace(nctl::move(velocityCurve));
 
 		dest.init = src.init;
 		dest.emitDelay = src.emitDelay;
 		dest.lastEmissionTime = nc::TimeStamp::now();
+		dest.randomSeed = src.randomSeed;
+		dest.random.init(src.randomSeed);
+		dest.continuousEmission = src.continuousEmission;
+		dest.emissionRate = src.emissionRate;
+		dest.emissionAccumulator = 0.0f;
+		dest.prewarmTime = src.prewarmTime;
 
 		if (dest.init.emitterRotation)
 			dest.rotationCurrentItem = 0;
@@ -371,12 +707,18 @@ bool MyEventHandler::load(const char *filename, const nc::EmscriptenLocalFile *l
 		}
 	}
 
-	logString_.formatAppend("Loaded project file \"%s\"\n", filename);
-	return true;
+	if (useTextureAtlas_)
+		rebuildTextureAtlas();
+	scheduleEmissions();
+
+	const unsigned int numCurves = colorCurves_.size() + sizeCurves_.size() + rotationCurves_.size() + positionCurves_.size() + velocityCurves_.size();
+	logString_.formatAppend("Stored %u distinct step curves for %u particle systems\n", numCurves, sysStates_.size());
+	prewarmPending_ = true;
 }
 
-void MyEventHandler::save(const char *filename)
+bool MyEventHandler::save(const char *filename)
 {
+	PROFILE_SCOPE("save");
 	LuaLoader::State loaderState;
 
 	loaderState.background.color = background_;
@@ -398,20 +740,12 @@ void MyEventHandler::save(const char *filename)
 		const ParticleSystemGuiState &src = sysStates_[index];
 		LuaLoader::State::ParticleSystem dest;
 
-		nctl::String *textureName = nullptr;
-		for (unsigned int i = 0; i < textures_.size(); i++)
-		{
-			if (textures_[i].get() == src.texture)
-			{
-				textureName = &texNames_[i];
-				break;
-			}
-		}
-		FATAL_ASSERT(textureName != nullptr);
+		const unsigned int texIndex = textures_->indexOf(src.texture);
+		FATAL_ASSERT(texIndex != TextureRegistry::InvalidIndex);
 
 		dest.name = src.name;
 		dest.numParticles = src.numParticles;
-		dest.textureName = *textureName;
+		dest.textureName = textures_->name(texIndex);
 		dest.texRect = src.texRect;
 		dest.anchorPoint = src.anchorPoint;
 		dest.flippedX = src.flippedX;
@@ -485,11 +819,20 @@ void MyEventHandler::save(const char *filename)
 
 		dest.init = src.init;
 		dest.emitDelay = src.emitDelay;
+		dest.randomSeed = src.randomSeed;
+		dest.continuousEmission = src.continuousEmission;
+		dest.emissionRate = src.emissionRate;
+		dest.prewarmTime = src.prewarmTime;
 		loaderState.systems.pushBack(dest);
 	}
 
-	loader_->save(filename, loaderState);
+	if (loader_->save(filename, loaderState) == false)
+	{
+		logString_.formatAppend("Could not save project file \"%s\"\n", filename);
+		return false;
+	}
 	logString_.formatAppend("Saved project file \"%s\"\n", filename);
+	return true;
 }
 
 void MyEventHandler::applyConfig()
@@ -498,21 +841,21 @@ void MyEventHandler::applyConfig()
 	nc::Application::RenderingSettings &settings = nc::theApplication().renderingSettings();
 	settings.batchingEnabled = cfg.batching;
 	settings.cullingEnabled = cfg.culling;
+	frameTimes_.setLength(cfg.performanceHistory);
 
 	applyGuiStyleConfig();
 }
 
 void MyEventHandler::clearData()
 {
-	for (unsigned int i = 0; i < textures_.size(); i++)
-		texturesToDelete_.pushBack(nctl::move(textures_[i]));
-	textures_.clear();
-	texNames_.clear();
+	textureAtlas_->clear(texturesToDelete_);
+	textures_->clear(texturesToDelete_);
 
 	for (unsigned int i = 0; i < particleSystems_.size(); i++)
 		particleSystems_[i].reset(nullptr);
 	particleSystems_.clear();
 	sysStates_.clear();
+	emissionScheduler_.clear();
 
 	logString_.formatAppend("Destroyed all textures and particle systems\n");
 }
@@ -533,6 +876,22 @@ void MyEventHandler::pushRecentFile(const nctl::String &filename)
 		recentFileIndexStart_ = (recentFileIndexStart_ + 1) % MaxRecentFiles;
 }
 
+void MyEventHandler::logLoadTime(const LuaLoader &loader, const char *filename, float milliseconds, bool isProject)
+{
+	const LuaLoader::Statistics &stats = loader.statistics();
+	logString_.formatAppend("Loaded %s file \"%s\" in %.2f ms\n", isProject ? "project" : "config", filename, milliseconds);
+
+	if (isProject && stats.lastLoadMethod == LuaLoader::LoadMethod::BINARY)
+		logString_.append("Project file read in binary format\n");
+	else if (isProject && stats.lastLoadMethod == LuaLoader::LoadMethod::PARSER)
+		logString_.append("Project file parsed without a Lua state\n");
+	else
+	{
+		logString_.formatAppend("Lua state %s in %.3f ms (%u created, %u reset)\n", stats.lastStateCreated ? "created" : "reset",
+		                        stats.lastStateTime, stats.numStatesCreated, stats.numStateResets);
+	}
+}
+
 bool MyEventHandler::loadBackgroundImage(const nctl::String &filename)
 {
 	const LuaLoader::Config &luaConfig = loader_->config();
@@ -585,49 +944,48 @@ bool MyEventHandler::applyBackgroundImageProperties()
 
 unsigned int MyEventHandler::retrieveTexture(unsigned int particleSystemIndex)
 {
-	unsigned int index = 0;
-	for (unsigned int i = 0; i < textures_.size(); i++)
-	{
-		if (textures_[i].get() == sysStates_[particleSystemIndex].texture)
-		{
-			index = i;
-			break;
-		}
-	}
-	return index;
+	const unsigned int index = textures_->indexOf(sysStates_[particleSystemIndex].texture);
+	return (index != TextureRegistry::InvalidIndex) ? index : 0;
 }
 
-bool MyEventHandler::createTexture(unsigned int index)
+bool MyEventHandler::createTexture(const nctl::String &name)
 {
 	const LuaLoader::Config &luaConfig = loader_->config();
 
 	nctl::String filepath(MaxStringLength);
-	filepath = texNames_[index];
+	filepath = name;
 	if (nc::fs::isReadableFile(filepath.data()) == false)
-		filepath = nc::fs::joinPath(luaConfig.texturesPath, texNames_[index]);
+		filepath = nc::fs::joinPath(luaConfig.texturesPath, name);
 
 	if (nc::fs::isReadableFile(filepath.data()))
 	{
-		FATAL_ASSERT(index == textures_.size());
-		textures_.pushBack(nctl::makeUnique<nc::Texture>(filepath.data()));
+		const unsigned int index = textures_->add(name, nctl::makeUnique<nc::Texture>(filepath.data()));
 		logString_.formatAppend("Loaded texture \"%s\" at index #%u\n", filepath.data(), index);
 		return true;
 	}
 
-	logString_.formatAppend("Cannot load texture \"%s\" at index #%u\n", filepath.data(), index);
+	logString_.formatAppend("Cannot load texture \"%s\"\n", filepath.data());
 	return false;
 }
 
-void MyEventHandler::destroyTexture(unsigned int index)
+bool MyEventHandler::createTexture(const nctl::String &name, const char *filepath, const unsigned char *buffer, unsigned long bufferSize)
 {
-	texturesToDelete_.pushBack(nctl::move(textures_[index]));
-	for (unsigned int i = index; i < textures_.size() - 1; i++)
-		textures_[i] = nctl::move(textures_[i + 1]);
-	textures_.setSize(textures_.size() - 1);
+	if (buffer != nullptr && bufferSize > 0)
+	{
+		const unsigned int index = textures_->add(name, nctl::makeUnique<nc::Texture>(filepath, buffer, bufferSize));
+		logString_.formatAppend("Loaded texture \"%s\" at index #%u\n", filepath, index);
+		return true;
+	}
 
-	for (unsigned int i = index; i < texNames_.size() - 1; i++)
-		texNames_[i] = texNames_[i + 1];
-	texNames_.setSize(texNames_.size() - 1);
+	logString_.formatAppend("Cannot load texture \"%s\"\n", filepath);
+	return false;
+}
+
+void MyEventHandler::destroyTexture(unsigned int index)
+{
+	texturesToDelete_.pushBack(textures_->remove(index));
+	if (useTextureAtlas_)
+		rebuildTextureAtlas();
 
 	logString_.formatAppend("Destroyed texture at index #%u\n", index);
 }
@@ -639,39 +997,127 @@ void MyEventHandler::deleteUnusedTextures()
 	texturesToDelete_.clear();
 }
 
+void MyEventHandler::rebuildTextureAtlas()
+{
+	if (useTextureAtlas_)
+	{
+		if (textureAtlas_->build(*textures_, texturesToDelete_))
+		{
+			const AtlasPacker &packer = textureAtlas_->packer();
+			logString_.formatAppend("Packed %u textures in %u atlas pages (%.1f%% efficiency)\n",
+			                        packer.size(), packer.numPages(), packer.efficiency() * 100.0f);
+		}
+		else
+		{
+			logString_.append("Cannot pack the textures in an atlas\n");
+			useTextureAtlas_ = false;
+		}
+	}
+	else
+		textureAtlas_->clear(texturesToDelete_);
+
+	for (unsigned int i = 0; i < particleSystems_.size(); i++)
+		applySystemTexture(i);
+}
+
+bool MyEventHandler::saveTextureAtlasLayout(const char *projectFilename)
+{
+	// The layout file replaces the extension of the project one
+	nctl::String layoutFilename(MaxStringLength);
+	layoutFilename = projectFilename;
+	const char *extension = strrchr(projectFilename, '.');
+	if (extension != nullptr && strchr(extension, '/') == nullptr && strchr(extension, '\\') == nullptr)
+		layoutFilename.setLength(static_cast<unsigned int>(extension - projectFilename));
+	layoutFilename.append("_atlas.lua");
+
+	if (useTextureAtlas_ == false && textureAtlas_->build(*textures_, texturesToDelete_) == false)
+	{
+		logString_.formatAppend("Cannot pack the textures in an atlas to save \"%s\"\n", layoutFilename.data());
+		return false;
+	}
+
+	const bool saved = textureAtlas_->saveLayout(layoutFilename.data());
+	if (saved)
+		logString_.formatAppend("Saved texture atlas layout \"%s\"\n", layoutFilename.data());
+	else
+		logString_.formatAppend("Cannot save texture atlas layout \"%s\"\n", layoutFilename.data());
+
+	if (useTextureAtlas_ == false)
+		textureAtlas_->clear(texturesToDelete_);
+	return saved;
+}
+
+void MyEventHandler::applySystemTexture(unsigned int index)
+{
+	const ParticleSystemGuiState &s = sysStates_[index];
+	nc::ParticleSystem *particleSystem = particleSystems_[index].get();
+
+	nc::Recti atlasRect;
+	nc::Texture *atlasPage = useTextureAtlas_ ? textureAtlas_->remap(s.texture, s.texRect, atlasRect) : nullptr;
+	if (atlasPage != nullptr)
+	{
+		particleSystem->setTexture(atlasPage);
+		particleSystem->setTexRect(atlasRect);
+	}
+	else
+	{
+		particleSystem->setTexture(s.texture);
+		particleSystem->setTexRect(s.texRect);
+	}
+}
+
 void MyEventHandler::createParticleSystem(unsigned int index)
 {
 	ParticleSystemGuiState &s = sysStates_[index];
 
-	nc::Texture *texture = textures_[texIndex_].get();
+	nc::Texture *texture = textures_->texture(texIndex_);
 	const nc::Recti texRect(0, 0, texture->width(), texture->height());
 	FATAL_ASSERT(index == particleSystems_.size());
-	particleSystems_.pushBack(nctl::makeUnique<nc::ParticleSystem>(dummy_.get(), unsigned(s.numParticles), texture, texRect));
+	particleSystems_.pushBack(nctl::makeUnique<ProfiledParticleSystem>(dummy_.get(), unsigned(s.numParticles), texture, texRect));
 	particleSystems_.back()->setPosition(s.position);
 	particleSystems_.back()->setLayer(static_cast<unsigned short>(s.layer));
 	particleSystems_.back()->setInLocalSpace(s.inLocalSpace);
 
-	nctl::UniquePtr<nc::ColorAffector> colAffector = nctl::makeUnique<nc::ColorAffector>();
-	s.colorAffector = colAffector.get();
-	particleSystems_.back()->addAffector(nctl::move(colAffector));
+	// All new systems share the same empty curves
+	s.colorAffector = colorCurves_.share(nctl::makeUnique<nc::ColorAffector>());
+	s.sizeAffector = sizeCurves_.share(nctl::makeUnique<nc::SizeAffector>());
+	s.rotationAffector = rotationCurves_.share(nctl::makeUnique<nc::RotationAffector>());
+	s.positionAffector = positionCurves_.share(nctl::makeUnique<nc::PositionAffector>());
+	s.velocityAffector = velocityCurves_.share(nctl::makeUnique<nc::VelocityAffector>());
+	addSharedAffectors(index);
+	applySystemTexture(index);
+
+	s.randomSeed = newRandomSeed();
+	s.random.init(s.randomSeed);
+	scheduleEmission(index);
+
+	logString_.formatAppend("Created a new particle system at index #%u\n", index);
+}
+
+void MyEventHandler::addSharedAffectors(unsigned int index)
+{
+	ParticleSystemGuiState &s = sysStates_[index];
+	nc::ParticleSystem *particleSystem = particleSystems_[index].get();
 
-	nctl::UniquePtr<nc::SizeAffector> sizeAffector = nctl::makeUnique<nc::SizeAffector>();
-	s.sizeAffector = sizeAffector.get();
-	particleSystems_.back()->addAffector(nctl::move(sizeAffector));
+	nctl::UniquePtr<SharedAffector<nc::ColorAffector>> colAffector = nctl::makeUnique<SharedAffector<nc::ColorAffector>>(colorCurves_, s.colorAffector);
+	s.sharedColorAffector = colAffector.get();
+	particleSystem->addAffector(nctl::move(colAffector));
 
-	nctl::UniquePtr<nc::RotationAffector> rotAffector = nctl::makeUnique<nc::RotationAffector>();
-	s.rotationAffector = rotAffector.get();
-	particleSystems_.back()->addAffector(nctl::move(rotAffector));
+	nctl::UniquePtr<SharedAffector<nc::SizeAffector>> sizeAffector = nctl::makeUnique<SharedAffector<nc::SizeAffector>>(sizeCurves_, s.sizeAffector);
+	s.sharedSizeAffector = sizeAffector.get();
+	particleSystem->addAffector(nctl::move(sizeAffector));
 
-	nctl::UniquePtr<nc::PositionAffector> posAffector = nctl::makeUnique<nc::PositionAffector>();
-	s.positionAffector = posAffector.get();
-	particleSystems_.back()->addAffector(nctl::move(posAffector));
+	nctl::UniquePtr<SharedAffector<nc::RotationAffector>> rotAffector = nctl::makeUnique<SharedAffector<nc::RotationAffector>>(rotationCurves_, s.rotationAffector);
+	s.sharedRotationAffector = rotAffector.get();
+	particleSystem->addAffector(nctl::move(rotAffector));
 
-	nctl::UniquePtr<nc::VelocityAffector> velAffector = nctl::makeUnique<nc::VelocityAffector>();
-	s.velocityAffector = velAffector.get();
-	particleSystems_.back()->addAffector(nctl::move(velAffector));
+	nctl::UniquePtr<SharedAffector<nc::PositionAffector>> posAffector = nctl::makeUnique<SharedAffector<nc::PositionAffector>>(positionCurves_, s.positionAffector);
+	s.sharedPositionAffector = posAffector.get();
+	particleSystem->addAffector(nctl::move(posAffector));
 
-	logString_.formatAppend("Created a new particle system at index #%u\n", index);
+	nctl::UniquePtr<SharedAffector<nc::VelocityAffector>> velAffector = nctl::makeUnique<SharedAffector<nc::VelocityAffector>>(velocityCurves_, s.velocityAffector);
+	s.sharedVelocityAffector = velAffector.get();
+	particleSystem->addAffector(nctl::move(velAffector));
 }
 
 void MyEventHandler::cloneParticleSystem(unsigned int srcIndex, unsigned int destIndex, unsigned int numParticles)
@@ -683,9 +1129,12 @@ void MyEventHandler::cloneParticleSystem(unsigned int srcIndex, unsigned int des
 	dest.name = src.name;
 	dest.active = src.active;
 
+	textures_->release(dest.texture);
 	dest.texture = src.texture;
+	textures_->acquire(dest.texture);
 	dest.texRect = src.texRect;
-	particleSystems_[destIndex] = nctl::makeUnique<nc::ParticleSystem>(dummy_.get(), numParticles, dest.texture, dest.texRect);
+	particleSystems_[destIndex] = nctl::makeUnique<ProfiledParticleSystem>(dummy_.get(), numParticles, dest.texture, dest.texRect);
+	applySystemTexture(destIndex);
 	dest.position = src.position;
 	particleSystems_[destIndex]->setPosition(dest.position);
 	dest.layer = src.layer;
@@ -701,47 +1150,171 @@ void MyEventHandler::cloneParticleSystem(unsigned int srcIndex, unsigned int des
 	dest.blendingPreset = src.blendingPreset;
 	particleSystems_[destIndex]->setBlendingPreset(dest.blendingPreset);
 
-	nctl::UniquePtr<nc::ColorAffector> colAffector = nctl::makeUnique<nc::ColorAffector>();
-	dest.colorAffector = colAffector.get();
-	particleSystems_[destIndex]->addAffector(nctl::move(colAffector));
-	for (unsigned int i = 0; i < src.colorAffector->steps().size(); i++)
-		dest.colorAffector->steps()[i] = src.colorAffector->steps()[i];
-
-	nctl::UniquePtr<nc::SizeAffector> sizeAffector = nctl::makeUnique<nc::SizeAffector>();
-	dest.sizeAffector = sizeAffector.get();
-	particleSystems_[destIndex]->addAffector(nctl::move(sizeAffector));
-	dest.sizeAffector->setBaseScale(src.sizeAffector->baseScale());
+	// The clone shares the step curves until one of the two systems edits them
+	dest.colorAffector = src.colorAffector;
+	colorCurves_.acquire(dest.colorAffector);
+	dest.sizeAffector = src.sizeAffector;
+	sizeCurves_.acquire(dest.sizeAffector);
+	dest.rotationAffector = src.rotationAffector;
+	rotationCurves_.acquire(dest.rotationAffector);
+	dest.positionAffector = src.positionAffector;
+	positionCurves_.acquire(dest.positionAffector);
+	dest.velocityAffector = src.velocityAffector;
+	velocityCurves_.acquire(dest.velocityAffector);
+	addSharedAffectors(destIndex);
+	dest.baseScale = src.baseScale;
 	dest.baseScaleLock = src.baseScaleLock;
 	dest.sizeValueLock = src.sizeValueLock;
-	for (unsigned int i = 0; i < src.sizeAffector->steps().size(); i++)
-		dest.sizeAffector->steps()[i] = src.sizeAffector->steps()[i];
-
-	nctl::UniquePtr<nc::RotationAffector> rotAffector = nctl::makeUnique<nc::RotationAffector>();
-	dest.rotationAffector = rotAffector.get();
-	particleSystems_[destIndex]->addAffector(nctl::move(rotAffector));
-	for (unsigned int i = 0; i < src.rotationAffector->steps().size(); i++)
-		dest.rotationAffector->steps()[i] = src.rotationAffector->steps()[i];
-
-	nctl::UniquePtr<nc::PositionAffector> posAffector = nctl::makeUnique<nc::PositionAffector>();
-	dest.positionAffector = posAffector.get();
-	particleSystems_[destIndex]->addAffector(nctl::move(posAffector));
-	for (unsigned int i = 0; i < src.positionAffector->steps().size(); i++)
-		dest.positionAffector->steps()[i] = src.positionAffector->steps()[i];
-
-	nctl::UniquePtr<nc::VelocityAffector> velAffector = nctl::makeUnique<nc::VelocityAffector>();
-	dest.velocityAffector = velAffector.get();
-	particleSystems_[destIndex]->addAffector(nctl::move(velAffector));
-	for (unsigned int i = 0; i < src.velocityAffector->steps().size(); i++)
-		dest.velocityAffector->steps()[i] = src.velocityAffector->steps()[i];
 
 	dest.init = src.init;
 	dest.emitDelay = src.emitDelay;
+	dest.continuousEmission = src.continuousEmission;
+	dest.emissionRate = src.emissionRate;
+	dest.emissionAccumulator = 0.0f;
+	dest.prewarmTime = src.prewarmTime;
+	// A clone emits its own particles instead of repeating the ones of the source
+	dest.randomSeed = newRandomSeed();
+	dest.random.init(dest.randomSeed);
+	scheduleEmission(destIndex);
 
 	logString_.formatAppend("Cloned particle system at index #%u to index #%u\n", srcIndex, destIndex);
 }
 
+/*! The engine allocates the particles of a system when it is constructed, the pool is replaced by a single new system.
+ *  The affectors are moved to it, so that the pointers of the GUI state stay valid, and alive particles are emitted
+ *  again with their state. When shrinking, the particles with the least remaining life are the ones left out. */
+void MyEventHandler::resizeParticleSystem(unsigned int index, unsigned int numParticles)
+{
+	const ParticleSystemGuiState &s = sysStates_[index];
+	nctl::UniquePtr<nc::ParticleSystem> &oldSystem = particleSystems_[index];
+	const unsigned int oldNumParticles = oldSystem->numParticles();
+
+	nctl::UniquePtr<nc::ParticleSystem> newSystem = nctl::makeUnique<ProfiledParticleSystem>(dummy_.get(), numParticles, s.texture, s.texRect);
+	newSystem->setPosition(s.position);
+	newSystem->setLayer(static_cast<unsigned short>(s.layer));
+	newSystem->setInLocalSpace(s.inLocalSpace);
+	newSystem->setAnchorPoint(s.anchorPoint);
+	newSystem->setFlippedX(s.flippedX);
+	newSystem->setFlippedY(s.flippedY);
+	newSystem->setBlendingPreset(s.blendingPreset);
+
+	nctl::Array<nctl::UniquePtr<nc::ParticleAffector>> &affectors = oldSystem->affectors();
+	for (unsigned int i = 0; i < affectors.size(); i++)
+		newSystem->addAffector(nctl::move(affectors[i]));
+	affectors.clear();
+
+	nctl::Array<nc::Particle *> aliveParticles(oldSystem->numAliveParticles());
+	float maxLife = 0.0f;
+	for (nc::SceneNode *child : oldSystem->children())
+	{
+		nc::Particle *particle = static_cast<nc::Particle *>(child);
+		if (particle->isAlive())
+		{
+			aliveParticles.pushBack(particle);
+			if (maxLife < particle->life_)
+				maxLife = particle->life_;
+		}
+	}
+
+	// A histogram of the remaining life finds the bucket where the particles stop fitting in the new pool
+	const unsigned int NumBuckets = 64;
+	const float bucketScale = (maxLife > 0.0f) ? (NumBuckets - 1) / maxLife : 0.0f;
+	unsigned int lastBucket = 0;
+	unsigned int numLastBucket = aliveParticles.size();
+	if (aliveParticles.size() > numParticles)
+	{
+		unsigned int histogram[NumBuckets] = {};
+		for (const nc::Particle *particle : aliveParticles)
+			histogram[static_cast<unsigned int>(particle->life_ * bucketScale)]++;
+
+		unsigned int numKept = 0;
+		lastBucket = NumBuckets - 1;
+		while (numKept + histogram[lastBucket] < numParticles)
+			numKept += histogram[lastBucket--];
+		numLastBucket = numParticles - numKept;
+	}
+
+	unsigned int numKept = 0;
+	for (unsigned int i = 0; i < aliveParticles.size(); i++)
+	{
+		const unsigned int bucket = static_cast<unsigned int>(aliveParticles[i]->life_ * bucketScale);
+		if (bucket > lastBucket || (bucket == lastBucket && numLastBucket > 0))
+		{
+			if (bucket == lastBucket)
+				numLastBucket--;
+			aliveParticles[numKept++] = aliveParticles[i];
+		}
+	}
+	aliveParticles.setSize(numKept);
+
+	if (numKept > 0)
+	{
+		// Any particle is emitted, then its state is replaced by the one of a kept particle
+		nc::ParticleInitializer init;
+		init.rndAmount.set(static_cast<int>(numKept), static_cast<int>(numKept));
+		newSystem->emitParticles(init);
+
+		unsigned int keptIndex = 0;
+		for (nc::SceneNode *child : newSystem->children())
+		{
+			nc::Particle *particle = static_cast<nc::Particle *>(child);
+			if (particle->isAlive() == false || keptIndex >= numKept)
+				continue;
+
+			const nc::Particle *keptParticle = aliveParticles[keptIndex++];
+			particle->life_ = keptParticle->life_;
+			particle->startingLife = keptParticle->startingLife;
+			particle->startingRotation = keptParticle->startingRotation;
+			particle->velocity_ = keptParticle->velocity_;
+			particle->setPosition(keptParticle->position());
+			particle->setRotation(keptParticle->rotation());
+		}
+	}
+
+	oldSystem = nctl::move(newSystem);
+	applySystemTexture(index);
+
+	logString_.formatAppend("Resized particle system at index #%u from %u to %u particles, keeping %u alive\n", index, oldNumParticles, numParticles, numKept);
+}
+
+/*! Systems with no delay emit once per frame, their advice assumes the frame limit or sixty frames per second */
+const PoolAdvisor::Advice &MyEventHandler::poolAdvice(unsigned int index)
+{
+	ParticleSystemGuiState &s = sysStates_[index];
+	const LuaLoader::Config &cfg = loader_->config();
+
+	PoolAdvisor::Settings settings;
+	settings.init = s.init;
+	settings.emitDelay = s.emitDelay;
+	settings.continuousEmission = s.continuousEmission;
+	settings.emissionRate = s.emissionRate;
+	settings.frameInterval = frameInterval(cfg);
+	settings.randomSeed = s.randomSeed;
+
+	if (s.hasAdvice == false || s.adviceSettings.equals(settings) == false)
+	{
+		s.advice = poolAdvisor_.advise(settings);
+		s.adviceSettings = settings;
+		s.hasAdvice = true;
+	}
+	return s.advice;
+}
+
+void MyEventHandler::fitParticleSystem(unsigned int index)
+{
+	ParticleSystemGuiState &s = sysStates_[index];
+	const PoolAdvisor::Advice &advice = poolAdvice(index);
+	if (advice.verified == false)
+		logString_.formatAppend("The simulated peak of system #%u exceeds its worst case estimate\n", index);
+
+	s.numParticles = static_cast<int>(advice.suggestedSize);
+	if (advice.suggestedSize != particleSystems_[index]->numParticles())
+		resizeParticleSystem(index, advice.suggestedSize);
+}
+
 void MyEventHandler::destroyParticleSystem(unsigned int index)
 {
+	textures_->release(sysStates_[index].texture);
 	particleSystems_[index].reset(nullptr);
 	for (unsigned int i = index; i < particleSystems_.size() - 1; i++)
 		particleSystems_[i] = nctl::move(particleSystems_[i + 1]);
@@ -750,6 +1323,8 @@ void MyEventHandler::destroyParticleSystem(unsigned int index)
 	for (unsigned int i = index; i < sysStates_.size() - 1; i++)
 		sysStates_[i] = sysStates_[i + 1];
 	sysStates_.setSize(sysStates_.size() - 1);
+	// Indices have changed for all the systems that followed the destroyed one
+	scheduleEmissions();
 
 	logString_.formatAppend("Destroyed particle system at index #%u\n", index);
 }
@@ -13,6 +13,11 @@
 #include <ncine/ParticleAffectors.h>
 #include <ncine/ParticleInitializer.h>
 #include <ncine/TimeStamp.h>
+#include "particle_editor_random.h"
+#include "particle_editor_scheduler.h"
+#include "particle_editor_advisor.h"
+#include "particle_editor_steps.h"
+#include "particle_editor_performance.h"
 
 #ifdef __EMSCRIPTEN__
 	#include <ncine/EmscriptenLocalFile.h>
@@ -22,12 +27,16 @@ namespace ncine {
 
 class Sprite;
 class Texture;
+class Particle;
 class ParticleSystem;
 class SceneNode;
 
 }
 
 class LuaLoader;
+class ProjectLoadJob;
+class TextureRegistry;
+class TextureAtlas;
 
 namespace nc = ncine;
 
@@ -62,6 +71,14 @@ class MyEventHandler :
 	nc::Vector2f parentPosition_ = nc::Vector2f::Zero;
 	int systemIndex_ = 0;
 	bool autoEmission_ = false;
+	/// Set when a project has been loaded, its systems are prewarmed on the next frame
+	bool prewarmPending_ = false;
+	/// An axis-aligned box
+	struct Bounds
+	{
+		nc::Vector2f min;
+		nc::Vector2f max;
+	};
 	struct ParticleSystemGuiState
 	{
 		nctl::String name = nctl::String(MaxStringLength);
@@ -78,11 +95,14 @@ class MyEventHandler :
 		bool flippedY = false;
 		nc::DrawableNode::BlendingPreset blendingPreset = nc::DrawableNode::BlendingPreset::ALPHA;
 
+		/// The shared step curves, they should only be modified after `edit()` on the affector of the system
 		nc::ColorAffector *colorAffector = nullptr;
+		SharedAffector<nc::ColorAffector> *sharedColorAffector = nullptr;
 		nc::Colorf colorValue = nc::Colorf(1.0f, 1.0f, 1.0f, 1.0f);
 		float colorAge = 0.0f;
 
 		nc::SizeAffector *sizeAffector = nullptr;
+		SharedAffector<nc::SizeAffector> *sharedSizeAffector = nullptr;
 		nc::Vector2f baseScale = nc::Vector2f(1.0f, 1.0f);
 		bool baseScaleLock = true;
 		nc::Vector2f sizeValue = nc::Vector2f(1.0f, 1.0f);
@@ -90,14 +110,17 @@ class MyEventHandler :
 		float sizeAge = 0.0f;
 
 		nc::RotationAffector *rotationAffector = nullptr;
+		SharedAffector<nc::RotationAffector> *sharedRotationAffector = nullptr;
 		float rotValue = 0.0f;
 		float rotAge = 0.0f;
 
 		nc::PositionAffector *positionAffector = nullptr;
+		SharedAffector<nc::PositionAffector> *sharedPositionAffector = nullptr;
 		nc::Vector2f positionValue = nc::Vector2f::Zero;
 		float positionAge = 0.0f;
 
 		nc::VelocityAffector *velocityAffector = nullptr;
+		SharedAffector<nc::VelocityAffector> *sharedVelocityAffector = nullptr;
 		nc::Vector2f velocityValue = nc::Vector2f::Zero;
 		float velocityAge = 0.0f;
 
@@ -109,10 +132,32 @@ class MyEventHandler :
 		int rotationCurrentItem = 0;
 		float emitDelay = (init.rndLife.x + init.rndLife.y) * 0.5f;
 		nc::TimeStamp lastEmissionTime;
+		/// Emits particles at a constant rate instead of a burst after every delay
+		bool continuousEmission = false;
+		/// Particles emitted every second in continuous mode
+		float emissionRate = 60.0f;
+		/// The fraction of a particle left over by the last continuous emission
+		float emissionAccumulator = 0.0f;
+		/// Seconds of simulation run when the project is loaded, so that looping effects do not start empty
+		float prewarmTime = 0.0f;
+		uint32_t randomSeed = 0;
+		/// The stream of random numbers used by the emissions, it restarts when the seed changes
+		CounterRandom random;
+		/// The last pool size advice and the settings it was computed for
+		PoolAdvisor::Settings adviceSettings;
+		PoolAdvisor::Advice advice;
+		bool hasAdvice = false;
+		/// Particles not in local space stay where they were emitted, the area around the previous emitter positions
+		Bounds trailBounds;
+		/// Number of updates before the particles emitted around the previous emitter positions are all dead
+		unsigned int trailFrames = 0;
+		nc::Vector2f lastEmitterPosition = nc::Vector2f::Zero;
 	};
 
 	nctl::String configFile_ = nctl::String(MaxStringLength);
 	nctl::String filename_ = nctl::String(MaxStringLength);
+	/// The name of the project when the open modal was shown, the modal edits `filename_` directly
+	nctl::String previousFilename_ = nctl::String(MaxStringLength);
 	nctl::String texFilename_ = nctl::String(MaxStringLength);
 	static const unsigned int MaxRecentFiles = 6;
 	nctl::StaticArray<nctl::String, MaxRecentFiles> recentFilenames_;
@@ -133,19 +178,36 @@ class MyEventHandler :
 	nctl::String logString_ = nctl::String(4096);
 
 	nctl::UniquePtr<LuaLoader> loader_;
+	nctl::UniquePtr<ProjectLoadJob> projectLoadJob_;
 
 	nctl::Array<ParticleSystemGuiState> sysStates_;
 	int texIndex_ = 0;
-	nctl::Array<nctl::String> texNames_;
 	SpriteGuiState spriteState_;
 
 	nctl::UniquePtr<nc::SceneNode> dummy_;
-	nctl::Array<nctl::UniquePtr<nc::Texture>> textures_;
+	nctl::UniquePtr<TextureRegistry> textures_;
+	nctl::UniquePtr<TextureAtlas> textureAtlas_;
+	bool useTextureAtlas_ = false;
 	nctl::Array<nctl::UniquePtr<nc::Texture>> texturesToDelete_;
 	nctl::Array<nc::Rectf> rects_;
 	nctl::UniquePtr<nc::Texture> backgroundTexture_;
 	nctl::UniquePtr<nc::Sprite> backgroundSprite_;
+	/// Step curves shared by the systems, they outlive the affectors that reference them
+	StepCurves<nc::ColorAffector> colorCurves_;
+	StepCurves<nc::SizeAffector> sizeCurves_;
+	StepCurves<nc::RotationAffector> rotationCurves_;
+	StepCurves<nc::PositionAffector> positionCurves_;
+	StepCurves<nc::VelocityAffector> velocityCurves_;
 	nctl::Array<nctl::UniquePtr<nc::ParticleSystem>> particleSystems_;
+	/// The next emission time of every active system, used by the automatic emission
+	EmissionScheduler emissionScheduler_;
+	nctl::Array<unsigned int> dueSystems_;
+	/// The particles of a system that were not alive before a continuous emission, to age the emitted ones
+	nctl::Array<nc::Particle *> deadParticles_;
+	PoolAdvisor poolAdvisor_;
+	/// The frame times shown by the performance window, sampled even when it is hidden
+	FrameTimeHistory frameTimes_;
+	DrawCallEstimator drawCallEstimator_;
 	nctl::String widgetName_ = nctl::String(MaxStringLength);
 	nctl::String comboString_ = nctl::String(4096);
 
@@ -154,12 +216,17 @@ class MyEventHandler :
 	bool showMainWindow_ = true;
 	bool showConfigWindow_ = false;
 	bool showLogWindow_ = false;
+	bool showPerformanceWindow_ = false;
 
 	bool menuNewEnabled();
 	void menuNew();
 	void menuOpen();
 	bool menuSaveEnabled();
 	void menuSave();
+#ifdef WITH_PROFILER
+	/// Saves the events of the frame profiler as a Chrome trace
+	void menuSaveTrace();
+#endif
 	void menuQuit();
 	void closeModalsAndAbout();
 
@@ -183,21 +250,45 @@ class MyEventHandler :
 	void createGuiVelocityPlot(const ParticleSystemGuiState &s);
 	void createGuiEmission();
 	void sanitizeParticleInit(nc::ParticleInitializer &init);
-	void createGuiEmissionPlot();
 	void createGuiConfigWindow();
 	void createGuiLogWindow();
+	void createGuiPerformanceWindow();
+	void createGuiLoadingProgress();
 
 	void emitParticles(unsigned int index);
 	void emitParticles();
+	/// Emits from the systems that are due according to the scheduler, without looking at the other ones
+	void emitScheduledParticles();
+	/// Updates the next emission time of a system, it should be called whenever its emission settings change
+	void scheduleEmission(unsigned int index);
+	/// Schedules every system again, after systems have been added, removed or replaced
+	void scheduleEmissions();
+	/// Emits the particles that were due in a time interval, each one aged by the time passed since it was due
+	/*! \returns The number of emitted particles */
+	unsigned int emitContinuousParticles(unsigned int index, float interval);
+	/// Emits particles from a system with the next numbers of its random stream, regardless of its delay
+	void emitSeededParticles(unsigned int index, const nc::ParticleInitializer &init);
+	/// Advances a system by its prewarm time without rendering, returns the number of updates
+	unsigned int prewarmParticleSystem(unsigned int index);
+	/// Prewarms all systems and logs the cost
+	void prewarmParticleSystems();
+	/// Returns a seed for a new system, based on the current time
+	static uint32_t newRandomSeed();
 	void killParticles(unsigned int index);
 	void killParticles();
 
-	bool load(const char *filename);
+	/// Starts loading a project, once it is loaded its name becomes `projectName` and it joins the recent files
+	bool load(const char *filename, const char *projectName);
 #ifdef __EMSCRIPTEN__
-	bool load(const char *filename, const nc::EmscriptenLocalFile *localFile);
+	bool load(const char *filename, const char *projectName, const nc::EmscriptenLocalFile *localFile);
 #endif
-	void save(const char *filename);
+	/// Creates textures and particle systems from a project loaded by the worker thread, one texture per frame
+	void updateProjectLoad();
+	void applyLoadedProject();
+	bool save(const char *filename);
 	void pushRecentFile(const nctl::String &filename);
+	/// Appends to the log the loading time of a project or config file and the Lua state counters
+	void logLoadTime(const LuaLoader &loader, const char *filename, float milliseconds, bool isProject);
 
 	void applyConfig();
 	void applyGuiStyleConfig();
@@ -207,13 +298,67 @@ class MyEventHandler :
 	void deleteBackgroundImage();
 	bool applyBackgroundImageProperties();
 	unsigned int retrieveTexture(unsigned int particleSystemIndex);
-	bool createTexture(unsigned int index);
+	bool createTexture(const nctl::String &name);
+	bool createTexture(const nctl::String &name, const char *filepath, const unsigned char *buffer, unsigned long bufferSize);
 	void destroyTexture(unsigned int index);
 	void deleteUnusedTextures();
+	/// Packs all textures in atlas pages when the atlas is enabled, then updates every particle system
+	void rebuildTextureAtlas();
+	/// Writes the atlas layout next to the project file, the atlas is built if it is not in use
+	bool saveTextureAtlasLayout(const char *projectFilename);
+	/// Sets the texture and the texture rectangle of a particle system, remapped to the atlas if enabled
+	void applySystemTexture(unsigned int index);
 
 	void createParticleSystem(unsigned int index);
+	/// Adds to a system the affectors of the step curves in its GUI state, the curves should have already been acquired
+	void addSharedAffectors(unsigned int index);
 	void cloneParticleSystem(unsigned int srcIndex, unsigned int destIndex, unsigned int numParticles);
+	/// Changes the number of particles of a system, keeping its affectors and as many alive particles as fit
+	void resizeParticleSystem(unsigned int index, unsigned int numParticles);
+	/// Returns the pool size advice for a system, computed again only when its emission settings have changed
+	const PoolAdvisor::Advice &poolAdvice(unsigned int index);
+	/// Resizes a system to its advised pool size
+	void fitParticleSystem(unsigned int index);
 	void destroyParticleSystem(unsigned int index);
+
+	/// The options of a simulation requested from the command line with `--simulate`
+	struct SimulationSettings
+	{
+		nctl::String projectFile = nctl::String(MaxStringLength);
+		nctl::String outputFile = nctl::String(MaxStringLength);
+		float seconds = 10.0f;
+		float timeStep = 1.0f / 60.0f;
+		bool valid = true;
+	};
+	bool simulationMode_ = false;
+	/// A failed simulation ends the process with a failure exit status on shutdown
+	bool simulationFailed_ = false;
+	SimulationSettings simulation_;
+
+	/// The number of systems updated and skipped in the current frame
+	struct SkipStatistics
+	{
+		unsigned int numUpdated = 0;
+		/// Active systems with no alive particles
+		unsigned int numIdle = 0;
+		/// Inactive systems with no alive particles
+		unsigned int numInactive = 0;
+		/// Systems whose particles cannot reach the viewport
+		unsigned int numCulled = 0;
+	};
+	SkipStatistics skipStatistics_;
+
+	/// Reads the simulation options, returns false if the editor should start normally
+	bool parseSimulationArguments(const nc::AppConfiguration &config);
+	/// Loads the project, steps its particle systems at a fixed time step and writes a JSON report
+	bool runSimulation();
+
+	/// Returns the area that a particle can reach during its life, relative to the emitter
+	Bounds particleReach(unsigned int index, float interval) const;
+	/// Returns the area that the alive particles of a system can occupy, in scene coordinates
+	Bounds systemBounds(unsigned int index, float interval);
+	/// Disables the update and the drawing of the systems with no alive particles or outside of the viewport
+	void skipIdleSystems();
 };
 
 #endif
@@ -0,0 +1,164 @@
+#include <cmath>
+#include "particle_editor_advisor.h"
+#include "particle_editor_random.h"
+
+namespace {
+
+/// Number of frames a particle stays in the pool, it dies during the update that brings its life to zero
+inline unsigned int lifeFrames(float life, float frameInterval)
+{
+	const unsigned int numFrames = static_cast<unsigned int>(ceilf(life / frameInterval));
+	return (numFrames > 0) ? numFrames : 1;
+}
+
+/// Number of frames between two burst emissions, a burst happens on the first frame after the delay has passed
+inline unsigned int periodFrames(float emitDelay, float frameInterval)
+{
+	return (emitDelay > 0.0f) ? static_cast<unsigned int>(emitDelay / frameInterval) + 1 : 1;
+}
+
+}
+
+///////////////////////////////////////////////////////////
+// CONSTRUCTORS and DESTRUCTOR
+///////////////////////////////////////////////////////////
+
+PoolAdvisor::PoolAdvisor()
+    : deaths_(64)
+{
+}
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+bool PoolAdvisor::Settings::equals(const Settings &other) const
+{
+	return init.rndAmount.x == other.init.rndAmount.x && init.rndAmount.y == other.init.rndAmount.y &&
+	       init.rndLife.x == other.init.rndLife.x && init.rndLife.y == other.init.rndLife.y &&
+	       emitDelay == other.emitDelay && continuousEmission == other.continuousEmission &&
+	       emissionRate == other.emissionRate && frameInterval == other.frameInterval && randomSeed == other.randomSeed;
+}
+
+const PoolAdvisor::Advice &PoolAdvisor::advise(const Settings &settings)
+{
+	advice_ = Advice();
+	if (settings.frameInterval > 0.0f)
+	{
+		estimate(settings);
+		simulate(settings);
+	}
+
+	advice_.verified = (advice_.simulatedPeak <= advice_.worstAlive);
+	advice_.suggestedSize = (advice_.simulatedPeak > advice_.worstAlive) ? advice_.simulatedPeak : advice_.worstAlive;
+	if (advice_.suggestedSize == 0)
+		advice_.suggestedSize = 1;
+	return advice_;
+}
+
+///////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+///////////////////////////////////////////////////////////
+
+/*! The bounds count frames like the simulation: a particle occupies the pool from the frame it is emitted
+ *  to the one before its life runs out, the particles alive at the same time are the ones emitted in that span. */
+void PoolAdvisor::estimate(const Settings &settings)
+{
+	const nc::ParticleInitializer &init = settings.init;
+	const int maxAmount = (init.rndAmount.x > init.rndAmount.y) ? init.rndAmount.x : init.rndAmount.y;
+	const float maxLife = (init.rndLife.x > init.rndLife.y) ? init.rndLife.x : init.rndLife.y;
+	const float meanLife = (init.rndLife.x + init.rndLife.y) * 0.5f;
+	if (maxLife <= 0.0f)
+		return;
+
+	const unsigned int maxLifeFrames = lifeFrames(maxLife, settings.frameInterval);
+	if (settings.continuousEmission)
+	{
+		if (settings.emissionRate <= 0.0f)
+			return;
+		advice_.steadyAlive = settings.emissionRate * meanLife;
+		advice_.worstAlive = static_cast<unsigned int>(settings.emissionRate * maxLifeFrames * settings.frameInterval) + 1;
+	}
+	else if (maxAmount <= 0)
+		return;
+	else if (settings.emitDelay < 0.0f)
+	{
+		// Only emitted by hand
+		advice_.worstAlive = static_cast<unsigned int>(maxAmount);
+	}
+	else
+	{
+		const unsigned int numPeriodFrames = periodFrames(settings.emitDelay, settings.frameInterval);
+		const float meanAmount = (init.rndAmount.x + init.rndAmount.y) * 0.5f;
+		advice_.steadyAlive = meanAmount * meanLife / (numPeriodFrames * settings.frameInterval);
+		advice_.worstAlive = static_cast<unsigned int>(maxAmount) * ((maxLifeFrames + numPeriodFrames - 1) / numPeriodFrames);
+	}
+}
+
+/*! Only the number of alive particles matters, so the simulation keeps the number of deaths of every
+ *  future frame in a ring buffer instead of updating the life of every particle. */
+void PoolAdvisor::simulate(const Settings &settings)
+{
+	const nc::ParticleInitializer &init = settings.init;
+	const float maxLife = (init.rndLife.x > init.rndLife.y) ? init.rndLife.x : init.rndLife.y;
+	if (maxLife <= 0.0f || (settings.continuousEmission && settings.emissionRate <= 0.0f))
+		return;
+
+	const float frameInterval = settings.frameInterval;
+	const unsigned int maxLifeFrames = lifeFrames(maxLife, frameInterval);
+	const unsigned int numPeriodFrames = periodFrames(settings.emitDelay, frameInterval);
+	// Two whole lives after the first emission cover the steady state and the worst overlap of emissions
+	unsigned int numSteps = 2 * (maxLifeFrames + numPeriodFrames);
+	if (numSteps > MaxSimulationSteps)
+		numSteps = MaxSimulationSteps;
+
+	// The ring buffer spans the frames that a particle can live
+	deaths_.clear();
+	for (unsigned int i = 0; i <= maxLifeFrames; i++)
+		deaths_.pushBack(0);
+	unsigned int *deaths = deaths_.data();
+	const unsigned int ringSize = deaths_.size();
+
+	CounterRandom random(settings.randomSeed);
+	float accumulator = 0.0f;
+	unsigned int lastEmissionStep = 0;
+	unsigned int numAlive = 0;
+	for (unsigned int step = 0; step < numSteps; step++)
+	{
+		numAlive -= deaths[step % ringSize];
+		deaths[step % ringSize] = 0;
+
+		if (settings.continuousEmission)
+		{
+			accumulator += settings.emissionRate * frameInterval;
+			const unsigned int numParticles = static_cast<unsigned int>(accumulator);
+			accumulator -= numParticles;
+			for (unsigned int i = 0; i < numParticles; i++)
+			{
+				const float age = (accumulator + (numParticles - 1 - i)) / settings.emissionRate;
+				if (age >= maxLife)
+					continue;
+				// An aged particle keeps its whole life, one already dead still takes a slot until the next update
+				float life = random.real(init.rndLife.x, init.rndLife.y) - age;
+				if (life < 0.0f)
+					life = 0.0f;
+				deaths[(step + lifeFrames(life, frameInterval)) % ringSize]++;
+				numAlive++;
+			}
+		}
+		else if (step == 0 || (settings.emitDelay >= 0.0f && step - lastEmissionStep >= numPeriodFrames))
+		{
+			const int amount = random.integer(init.rndAmount.x, init.rndAmount.y);
+			for (int i = 0; i < amount; i++)
+			{
+				const float life = random.real(init.rndLife.x, init.rndLife.y);
+				deaths[(step + lifeFrames(life, frameInterval)) % ringSize]++;
+				numAlive++;
+			}
+			lastEmissionStep = step;
+		}
+
+		if (advice_.simulatedPeak < numAlive)
+			advice_.simulatedPeak = numAlive;
+	}
+}
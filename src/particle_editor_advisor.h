@@ -0,0 +1,61 @@
+#ifndef CLASS_POOLADVISOR
+#define CLASS_POOLADVISOR
+
+#include <cstdint>
+#include <nctl/Array.h>
+#include <ncine/ParticleInitializer.h>
+
+namespace nc = ncine;
+
+/// Works out the smallest particle pool that a system never fills, from its emission settings
+/*! The worst case is derived from the maximum amount and life, then checked by a headless
+ *  simulation of the lives of the particles with the same emission rules of the editor. */
+class PoolAdvisor
+{
+  public:
+	/// The emission settings a system is advised for
+	struct Settings
+	{
+		nc::ParticleInitializer init;
+		float emitDelay = 0.0f;
+		bool continuousEmission = false;
+		float emissionRate = 0.0f;
+		/// A system with no delay emits once per frame
+		float frameInterval = 1.0f / 60.0f;
+		uint32_t randomSeed = 0;
+
+		bool equals(const Settings &other) const;
+	};
+
+	struct Advice
+	{
+		/// Mean number of alive particles once emission and deaths balance
+		float steadyAlive = 0.0f;
+		/// Upper bound of alive particles, every emission at its maximum amount and life
+		unsigned int worstAlive = 0;
+		/// Peak of alive particles in the simulation
+		unsigned int simulatedPeak = 0;
+		/// The smallest pool that holds the worst case and the simulated peak
+		unsigned int suggestedSize = 0;
+		/// False if the simulation exceeded the worst case, which would mean the bound is wrong
+		bool verified = false;
+	};
+
+	/// Maximum number of simulated frames
+	static const unsigned int MaxSimulationSteps = 4096;
+
+	PoolAdvisor();
+
+	/// Computes the bounds and runs the simulation, the returned advice stays valid until the next call
+	const Advice &advise(const Settings &settings);
+
+  private:
+	Advice advice_;
+	/// A ring buffer with the number of simulated particles that die on every future frame
+	nctl::Array<unsigned int> deaths_;
+
+	void estimate(const Settings &settings);
+	void simulate(const Settings &settings);
+};
+
+#endif
@@ -0,0 +1,173 @@
+#include <cstring>
+
+#include "particle_editor_atlas.h"
+#include "particle_editor_textures.h"
+#include "particle_editor_float.h"
+#include "particle_editor_writer.h"
+#include "particle_editor_hashmaps.h"
+#include <ncine/Texture.h>
+
+///////////////////////////////////////////////////////////
+// CONSTRUCTORS and DESTRUCTOR
+///////////////////////////////////////////////////////////
+
+TextureAtlas::TextureAtlas()
+    : packer_(MaxPageSize, MaxPageSize, Padding), pages_(1), names_(16), regionIndices_(32)
+{
+}
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+bool TextureAtlas::build(const TextureRegistry &registry, nctl::Array<nctl::UniquePtr<nc::Texture>> &removedTextures)
+{
+	clear(removedTextures);
+
+	for (unsigned int i = 0; i < registry.size(); i++)
+	{
+		const nc::Texture *texture = registry.texture(i);
+		packer_.add(texture->width(), texture->height());
+		names_.pushBack(registry.name(i));
+	}
+	if (packer_.pack() == false)
+	{
+		clear(removedTextures);
+		return false;
+	}
+
+	nctl::String pageName(32);
+	for (unsigned int page = 0; page < packer_.numPages(); page++)
+	{
+		const nc::Vector2i &pageSize = packer_.pageSize(page);
+		const unsigned long bufferSize = static_cast<unsigned long>(pageSize.x) * pageSize.y * 4;
+		nctl::UniquePtr<unsigned char[]> pageTexels = nctl::makeUnique<unsigned char[]>(bufferSize);
+		memset(pageTexels.get(), 0, bufferSize);
+
+		for (unsigned int i = 0; i < packer_.size(); i++)
+		{
+			const AtlasPacker::Region &region = packer_.region(i);
+			if (region.page == page && copyTexels(*registry.texture(i), pageTexels.get(), pageSize.x, region.rect) == false)
+			{
+				clear(removedTextures);
+				return false;
+			}
+		}
+
+		pageName.format("Atlas page #%u", page);
+		pages_.pushBack(nctl::makeUnique<nc::Texture>(pageName.data(), nc::Texture::Format::RGBA8, pageSize.x, pageSize.y));
+		pages_.back()->loadFromTexels(pageTexels.get());
+	}
+
+	HashMaps::reserve(regionIndices_, registry.size());
+	for (unsigned int i = 0; i < registry.size(); i++)
+		regionIndices_.insert(registry.texture(i), i);
+
+	return true;
+}
+
+void TextureAtlas::clear(nctl::Array<nctl::UniquePtr<nc::Texture>> &removedTextures)
+{
+	for (unsigned int i = 0; i < pages_.size(); i++)
+		removedTextures.pushBack(nctl::move(pages_[i]));
+	pages_.clear();
+	names_.clear();
+	regionIndices_.clear();
+	packer_.clear();
+}
+
+nc::Texture *TextureAtlas::remap(const nc::Texture *texture, const nc::Recti &texRect, nc::Recti &atlasRect) const
+{
+	const unsigned int *regionIndex = regionIndices_.find(texture);
+	if (regionIndex == nullptr)
+		return nullptr;
+
+	const AtlasPacker::Region &region = packer_.region(*regionIndex);
+	atlasRect.set(region.rect.x + texRect.x, region.rect.y + texRect.y, texRect.w, texRect.h);
+	return pages_[region.page].get();
+}
+
+bool TextureAtlas::saveLayout(const char *filename) const
+{
+	BufferedWriter file(filename);
+	if (file.isOpened() == false)
+		return false;
+
+	file.append("atlas =\n{\n");
+	file.formatAppend("\tpadding = %d,\n", packer_.padding());
+	file.formatAppend("\tefficiency = %s,\n", FloatString(packer_.efficiency()).data());
+
+	file.append("\tpages =\n\t{\n");
+	for (unsigned int i = 0; i < packer_.numPages(); i++)
+	{
+		const nc::Vector2i &pageSize = packer_.pageSize(i);
+		file.formatAppend("\t\t{width = %d, height = %d},\n", pageSize.x, pageSize.y);
+	}
+	file.append("\t},\n");
+
+	// Lua arrays start from index 1
+	file.append("\ttextures =\n\t{\n");
+	for (unsigned int i = 0; i < packer_.size(); i++)
+	{
+		const AtlasPacker::Region &region = packer_.region(i);
+		file.formatAppend("\t\t{name = \"%s\", page = %u, rect = {x = %d, y = %d, w = %d, h = %d}},\n",
+		                  names_[i].data(), region.page + 1, region.rect.x, region.rect.y, region.rect.w, region.rect.h);
+	}
+	file.append("\t},\n");
+	file.append("}\n");
+
+	return file.close();
+}
+
+///////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+///////////////////////////////////////////////////////////
+
+bool TextureAtlas::copyTexels(nc::Texture &texture, unsigned char *pageTexels, int pageWidth, const nc::Recti &rect)
+{
+	const unsigned int numChannels = texture.numChannels();
+	nctl::UniquePtr<unsigned char[]> texels = nctl::makeUnique<unsigned char[]>(texture.dataSize());
+	// Compressed formats and OpenGL ES cannot read texels back
+	if (numChannels == 0 || numChannels > 4 || texture.saveToMemory(texels.get()) == false)
+		return false;
+
+	for (int y = 0; y < rect.h; y++)
+	{
+		const unsigned char *src = texels.get() + static_cast<unsigned long>(y) * rect.w * numChannels;
+		unsigned char *dest = pageTexels + (static_cast<unsigned long>(rect.y + y) * pageWidth + rect.x) * 4;
+		for (int x = 0; x < rect.w; x++)
+		{
+			switch (numChannels)
+			{
+				case 1: // Treated as an alpha mask
+					dest[0] = 255;
+					dest[1] = 255;
+					dest[2] = 255;
+					dest[3] = src[0];
+					break;
+				case 2: // Luminance and alpha
+					dest[0] = src[0];
+					dest[1] = src[0];
+					dest[2] = src[0];
+					dest[3] = src[1];
+					break;
+				case 3:
+					dest[0] = src[0];
+					dest[1] = src[1];
+					dest[2] = src[2];
+					dest[3] = 255;
+					break;
+				case 4:
+					dest[0] = src[0];
+					dest[1] = src[1];
+					dest[2] = src[2];
+					dest[3] = src[3];
+					break;
+			}
+			src += numChannels;
+			dest += 4;
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,57 @@
+#ifndef CLASS_TEXTUREATLAS
+#define CLASS_TEXTUREATLAS
+
+#include <nctl/Array.h>
+#include <nctl/HashMap.h>
+#include <nctl/String.h>
+#include <nctl/UniquePtr.h>
+#include "particle_editor_packer.h"
+
+namespace ncine {
+
+class Texture;
+
+}
+
+class TextureRegistry;
+
+/// The atlas pages that contain all the loaded textures
+/*! The pages are built by reading back the texels of every texture, then particle systems
+ *  can use a page and a remapped texture rectangle in place of their own texture. */
+class TextureAtlas
+{
+  public:
+	static const int MaxPageSize = 2048;
+	/// Transparent texels between two textures to avoid bleeding when filtering
+	static const int Padding = 2;
+
+	TextureAtlas();
+
+	inline bool isEmpty() const { return pages_.isEmpty(); }
+	inline unsigned int numPages() const { return pages_.size(); }
+	inline nc::Texture *page(unsigned int index) const { return pages_[index].get(); }
+	inline const AtlasPacker &packer() const { return packer_; }
+
+	/// Packs all the textures of the registry in new pages, the old ones are moved to the specified array
+	bool build(const TextureRegistry &registry, nctl::Array<nctl::UniquePtr<nc::Texture>> &removedTextures);
+	/// Moves all pages to the specified array to delay their destruction
+	void clear(nctl::Array<nctl::UniquePtr<nc::Texture>> &removedTextures);
+
+	/// Returns the page that contains the texture and remaps the rectangle, or null if the texture is not packed
+	nc::Texture *remap(const nc::Texture *texture, const nc::Recti &texRect, nc::Recti &atlasRect) const;
+
+	/// Writes a Lua file with the size of every page and the region of every texture
+	bool saveLayout(const char *filename) const;
+
+  private:
+	AtlasPacker packer_;
+	nctl::Array<nctl::UniquePtr<nc::Texture>> pages_;
+	/// The texture name of every packer region
+	nctl::Array<nctl::String> names_;
+	nctl::HashMap<const nc::Texture *, unsigned int> regionIndices_;
+
+	/// Reads back the texels of a texture and copies them as RGBA in the page buffer
+	static bool copyTexels(nc::Texture &texture, unsigned char *pageTexels, int pageWidth, const nc::Recti &rect);
+};
+
+#endif
@@ -0,0 +1,409 @@
+#include "particle_editor_lua.h"
+#include "particle_editor_writer.h"
+#include "particle_editor_random.h"
+#include <ncine/Colorf.h>
+#include <cstring>
+
+const char *LuaLoader::BinaryExtension = "ncpb";
+
+namespace {
+
+/// Binary project layout, values are stored in the byte order of the host that wrote the file:
+/// - header: magic, version, number of particle systems
+/// - normalized absolute position and background properties
+/// - one block per system: properties, packed step arrays and emission block
+/// - since version 2, every system block ends with the resolution and the samples of its affector curves
+/// - since version 3, the random seed of the system follows them
+/// - since version 4, the continuous emission flag and rate follow the seed
+/// - since version 5, the prewarm time follows the rate
+/// The version doubles as a byte order mark: read with the other byte order it is larger than any known version.
+const char Magic[4] = { 'N', 'C', 'P', 'B' };
+const uint32_t BinaryProjectFileVersion = 5;
+/// Color curves have the most components
+const uint32_t MaxLutComponents = 4;
+
+static_assert(sizeof(LuaLoader::State::ColorStep) == 5 * sizeof(float), "Color steps must be tightly packed");
+static_assert(sizeof(LuaLoader::State::SizeStep) == 3 * sizeof(float), "Size steps must be tightly packed");
+static_assert(sizeof(LuaLoader::State::RotationStep) == 2 * sizeof(float), "Rotation steps must be tightly packed");
+static_assert(sizeof(LuaLoader::State::PositionStep) == 3 * sizeof(float), "Position steps must be tightly packed");
+static_assert(sizeof(LuaLoader::State::VelocityStep) == 3 * sizeof(float), "Velocity steps must be tightly packed");
+
+class BinaryReader
+{
+  public:
+	BinaryReader(const char *buffer, unsigned long size)
+	    : buffer_(buffer), size_(size), offset_(0), isValid_(true) {}
+
+	inline bool isValid() const { return isValid_; }
+
+	bool canRead(unsigned long bytes)
+	{
+		if (isValid_ && size_ - offset_ < bytes)
+			isValid_ = false;
+		return isValid_;
+	}
+
+	/// Checks the size of an array by dividing the remaining bytes, as the size in bytes could overflow
+	bool canReadArray(unsigned long count, unsigned long elementSize)
+	{
+		if (isValid_ && elementSize > 0 && count > (size_ - offset_) / elementSize)
+			isValid_ = false;
+		return isValid_;
+	}
+
+	void skip(unsigned long bytes)
+	{
+		if (canRead(bytes))
+			offset_ += bytes;
+	}
+
+	void read(void *dest, unsigned long bytes)
+	{
+		if (canRead(bytes))
+		{
+			memcpy(dest, buffer_ + offset_, bytes);
+			offset_ += bytes;
+		}
+	}
+
+	template <class T>
+	void read(T &value) { read(&value, sizeof(T)); }
+
+	void read(bool &value)
+	{
+		uint8_t byte = 0;
+		read(&byte, sizeof(uint8_t));
+		value = (byte != 0);
+	}
+
+	void read(nc::Vector2f &value) { read(value.data(), 2 * sizeof(float)); }
+	void read(nc::Vector2i &value) { read(value.data(), 2 * sizeof(int)); }
+	void read(nc::Colorf &value) { read(value.data(), 4 * sizeof(float)); }
+
+	void read(nc::Recti &value)
+	{
+		read(value.x);
+		read(value.y);
+		read(value.w);
+		read(value.h);
+	}
+
+	void read(nctl::String &string)
+	{
+		uint32_t length = 0;
+		read(length);
+		if (canRead(length))
+		{
+			string.format("%.*s", static_cast<int>(length), buffer_ + offset_);
+			offset_ += length;
+		}
+	}
+
+	template <class T>
+	void readSteps(nctl::Array<T> &steps)
+	{
+		uint32_t numSteps = 0;
+		read(numSteps);
+		steps.clear();
+		if (numSteps > 0 && canReadArray(numSteps, sizeof(T)))
+		{
+			if (steps.capacity() < numSteps)
+				steps.setCapacity(numSteps);
+			steps.setSize(numSteps);
+			read(steps.data(), numSteps * sizeof(T));
+		}
+	}
+
+	/// Curves sampled at a different resolution are skipped, they are baked again from the steps when needed
+	void readLut(CurveLut &lut, uint32_t resolution)
+	{
+		uint32_t numComponents = 0;
+		read(numComponents);
+		lut.clear();
+		if (numComponents > MaxLutComponents)
+			isValid_ = false;
+		else if (numComponents > 0 && canReadArray(resolution, numComponents * sizeof(float)))
+		{
+			const unsigned long numBytes = numComponents * resolution * sizeof(float);
+			if (resolution != CurveLut::Resolution)
+				skip(numBytes);
+			else
+			{
+				lut.setNumComponents(numComponents);
+				read(lut.data(0), numBytes);
+			}
+		}
+	}
+
+  private:
+	const char *buffer_;
+	unsigned long size_;
+	unsigned long offset_;
+	bool isValid_;
+};
+
+class BinaryWriter
+{
+  public:
+	explicit BinaryWriter(BufferedWriter &writer)
+	    : writer_(writer) {}
+
+	void write(const void *src, unsigned long bytes) { writer_.write(src, bytes); }
+
+	template <class T>
+	void write(const T &value) { write(&value, sizeof(T)); }
+
+	void write(bool value)
+	{
+		const uint8_t byte = value ? 1 : 0;
+		write(&byte, sizeof(uint8_t));
+	}
+
+	void write(const nc::Vector2f &value) { write(value.data(), 2 * sizeof(float)); }
+	void write(const nc::Vector2i &value) { write(value.data(), 2 * sizeof(int)); }
+	void write(const nc::Colorf &value) { write(value.data(), 4 * sizeof(float)); }
+
+	void write(const nc::Recti &value)
+	{
+		write(value.x);
+		write(value.y);
+		write(value.w);
+		write(value.h);
+	}
+
+	void write(const nctl::String &string)
+	{
+		write(static_cast<uint32_t>(string.length()));
+		write(string.data(), string.length());
+	}
+
+	template <class T>
+	void writeSteps(const nctl::Array<T> &steps)
+	{
+		write(static_cast<uint32_t>(steps.size()));
+		if (steps.isEmpty() == false)
+			write(steps.data(), steps.size() * sizeof(T));
+	}
+
+	void writeLut(const CurveLut &lut)
+	{
+		write(static_cast<uint32_t>(lut.numComponents()));
+		if (lut.isEmpty() == false)
+			write(lut.data(0), lut.numComponents() * CurveLut::Resolution * sizeof(float));
+	}
+
+  private:
+	BufferedWriter &writer_;
+};
+
+/// Gathers the values of every step component by component, as expected by `CurveLut::bake()`
+template <class T, class ValueFunc>
+void bakeSteps(const nctl::Array<T> &steps, unsigned int numComponents, ValueFunc value, CurveLut &lut)
+{
+	nctl::Array<float> ages(steps.size());
+	nctl::Array<float> values(steps.size() * numComponents);
+	for (unsigned int i = 0; i < steps.size(); i++)
+		ages.pushBack(steps[i].age);
+	for (unsigned int c = 0; c < numComponents; c++)
+	{
+		for (unsigned int i = 0; i < steps.size(); i++)
+			values.pushBack(value(steps[i], c));
+	}
+	lut.bake(ages.data(), values.data(), steps.size(), numComponents);
+}
+
+void bakeCurveLuts(const LuaLoader::State::ParticleSystem &s, LuaLoader::State::CurveLuts &luts)
+{
+	typedef LuaLoader::State State;
+	bakeSteps(s.colorSteps, 4, [](const State::ColorStep &step, unsigned int c) { return step.color.data()[c]; }, luts.color);
+	const nc::Vector2f &baseScale = s.sizeStepBaseScale;
+	bakeSteps(s.sizeSteps, 2, [&baseScale](const State::SizeStep &step, unsigned int c) { return baseScale.data()[c] * step.scale.data()[c]; }, luts.size);
+	bakeSteps(s.rotationSteps, 1, [](const State::RotationStep &step, unsigned int) { return step.angle; }, luts.rotation);
+	bakeSteps(s.positionSteps, 2, [](const State::PositionStep &step, unsigned int c) { return step.position.data()[c]; }, luts.position);
+	bakeSteps(s.velocitySteps, 2, [](const State::VelocityStep &step, unsigned int c) { return step.velocity.data()[c]; }, luts.velocity);
+}
+
+}
+
+///////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+///////////////////////////////////////////////////////////
+
+bool LuaLoader::loadBinary(const char *buffer, unsigned long bufferSize, State &state)
+{
+	BinaryReader reader(buffer, bufferSize);
+
+	char magic[4];
+	reader.read(magic, sizeof(magic));
+	if (reader.isValid() == false || memcmp(magic, Magic, sizeof(Magic)) != 0)
+		return false;
+
+	uint32_t version = 0;
+	reader.read(version);
+	// Files written by a host with the other byte order are rejected here, values are not swapped
+	if (version == 0 || version > BinaryProjectFileVersion)
+		return false;
+
+	uint32_t numSystems = 0;
+	reader.read(numSystems);
+
+	reader.read(state.normalizedAbsPosition);
+
+	State::BackgroundProperties &background = state.background;
+	reader.read(background.color);
+	reader.read(background.imageName);
+	reader.read(background.imageNormalizedPosition);
+	reader.read(background.imageScale);
+	reader.read(background.imageLayer);
+	reader.read(background.imageColor);
+	reader.read(background.imageRect);
+	reader.read(background.imageFlippedX);
+	reader.read(background.imageFlippedY);
+
+	if (reader.isValid() == false)
+		return false;
+
+	for (unsigned int systemIndex = 0; systemIndex < numSystems; systemIndex++)
+	{
+		state.systems.emplaceBack();
+		State::ParticleSystem &s = state.systems.back();
+
+		reader.read(s.name);
+		reader.read(s.numParticles);
+		reader.read(s.textureName);
+		reader.read(s.texRect);
+		reader.read(s.anchorPoint);
+		reader.read(s.flippedX);
+		reader.read(s.flippedY);
+		uint8_t blendingPreset = 0;
+		reader.read(blendingPreset);
+		if (blendingPreset > static_cast<uint8_t>(nc::DrawableNode::BlendingPreset::MULTIPLY))
+			return false;
+		s.blendingPreset = static_cast<nc::DrawableNode::BlendingPreset>(blendingPreset);
+		reader.read(s.position);
+		reader.read(s.layer);
+		reader.read(s.inLocalSpace);
+		reader.read(s.active);
+
+		reader.readSteps(s.colorSteps);
+		reader.read(s.sizeStepBaseScale);
+		reader.readSteps(s.sizeSteps);
+		reader.readSteps(s.rotationSteps);
+		reader.readSteps(s.positionSteps);
+		reader.readSteps(s.velocitySteps);
+
+		reader.read(s.init.rndAmount);
+		reader.read(s.init.rndLife);
+		reader.read(s.init.rndPositionX);
+		reader.read(s.init.rndPositionY);
+		reader.read(s.init.rndVelocityX);
+		reader.read(s.init.rndVelocityY);
+		reader.read(s.init.rndRotation);
+		reader.read(s.init.emitterRotation);
+		reader.read(s.emitDelay);
+
+		if (version >= 2)
+		{
+			uint32_t lutResolution = 0;
+			reader.read(lutResolution);
+			reader.readLut(s.luts.color, lutResolution);
+			reader.readLut(s.luts.size, lutResolution);
+			reader.readLut(s.luts.rotation, lutResolution);
+			reader.readLut(s.luts.position, lutResolution);
+			reader.readLut(s.luts.velocity, lutResolution);
+		}
+
+		s.randomSeed = CounterRandom::defaultSeed(systemIndex);
+		if (version >= 3)
+			reader.read(s.randomSeed);
+		s.continuousEmission = false;
+		s.emissionRate = 60.0f;
+		if (version >= 4)
+		{
+			reader.read(s.continuousEmission);
+			reader.read(s.emissionRate);
+		}
+		s.prewarmTime = 0.0f;
+		if (version >= 5)
+			reader.read(s.prewarmTime);
+
+		if (reader.isValid() == false)
+			return false;
+	}
+
+	return true;
+}
+
+bool LuaLoader::saveBinary(const char *filename, const State &state)
+{
+	BufferedWriter file(filename);
+	if (file.isOpened() == false)
+		return false;
+	BinaryWriter writer(file);
+
+	writer.write(Magic, sizeof(Magic));
+	writer.write(BinaryProjectFileVersion);
+	writer.write(static_cast<uint32_t>(state.systems.size()));
+
+	writer.write(state.normalizedAbsPosition);
+
+	const State::BackgroundProperties &background = state.background;
+	writer.write(background.color);
+	writer.write(background.imageName);
+	writer.write(background.imageNormalizedPosition);
+	writer.write(background.imageScale);
+	writer.write(background.imageLayer);
+	writer.write(background.imageColor);
+	writer.write(background.imageRect);
+	writer.write(background.imageFlippedX);
+	writer.write(background.imageFlippedY);
+
+	// The curves are baked from the current steps, the ones read from a file could be outdated
+	State::CurveLuts luts;
+	for (const State::ParticleSystem &s : state.systems)
+	{
+		writer.write(s.name);
+		writer.write(s.numParticles);
+		writer.write(s.textureName);
+		writer.write(s.texRect);
+		writer.write(s.anchorPoint);
+		writer.write(s.flippedX);
+		writer.write(s.flippedY);
+		writer.write(static_cast<uint8_t>(s.blendingPreset));
+		writer.write(s.position);
+		writer.write(s.layer);
+		writer.write(s.inLocalSpace);
+		writer.write(s.active);
+
+		writer.writeSteps(s.colorSteps);
+		writer.write(s.sizeStepBaseScale);
+		writer.writeSteps(s.sizeSteps);
+		writer.writeSteps(s.rotationSteps);
+		writer.writeSteps(s.positionSteps);
+		writer.writeSteps(s.velocitySteps);
+
+		writer.write(s.init.rndAmount);
+		writer.write(s.init.rndLife);
+		writer.write(s.init.rndPositionX);
+		writer.write(s.init.rndPositionY);
+		writer.write(s.init.rndVelocityX);
+		writer.write(s.init.rndVelocityY);
+		writer.write(s.init.rndRotation);
+		writer.write(s.init.emitterRotation);
+		writer.write(s.emitDelay);
+
+		bakeCurveLuts(s, luts);
+		writer.write(static_cast<uint32_t>(CurveLut::Resolution));
+		writer.writeLut(luts.color);
+		writer.writeLut(luts.size);
+		writer.writeLut(luts.rotation);
+		writer.writeLut(luts.position);
+		writer.writeLut(luts.velocity);
+		writer.write(s.randomSeed);
+		writer.write(s.continuousEmission);
+		writer.write(s.emissionRate);
+		writer.write(s.prewarmTime);
+	}
+
+	return file.close();
+}
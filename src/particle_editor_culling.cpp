@@ -0,0 +1,170 @@
+#include <cmath>
+
+#include "particle_editor.h"
+#include "particle_editor_lua.h"
+#include "particle_editor_profiler.h"
+#include <ncine/Application.h>
+#include <ncine/ParticleSystem.h>
+
+namespace {
+
+inline float minOf(float a, float b)
+{
+	return (a < b) ? a : b;
+}
+
+inline float maxOf(float a, float b)
+{
+	return (a > b) ? a : b;
+}
+
+}
+
+///////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+///////////////////////////////////////////////////////////
+
+/*! Affectors are applied once per update, without scaling by the interval: the position steps move
+ *  a particle on every frame and the velocity steps accelerate it. The bounds assume the maximum life,
+ *  the most extreme step value on every frame and a sprite of any rotation with the largest size. */
+MyEventHandler::Bounds MyEventHandler::particleReach(unsigned int index, float interval) const
+{
+	const ParticleSystemGuiState &s = sysStates_[index];
+	const nc::ParticleInitializer &init = s.init;
+
+	const float maxLife = maxOf(init.rndLife.x, init.rndLife.y);
+	const float numFrames = (maxLife > 0.0f && interval > 0.0f) ? ceilf(maxLife / interval) : 0.0f;
+
+	nc::Vector2f minPositionStep(0.0f, 0.0f);
+	nc::Vector2f maxPositionStep(0.0f, 0.0f);
+	for (const nc::PositionAffector::PositionStep &step : s.positionAffector->steps())
+	{
+		minPositionStep.set(minOf(minPositionStep.x, step.position.x), minOf(minPositionStep.y, step.position.y));
+		maxPositionStep.set(maxOf(maxPositionStep.x, step.position.x), maxOf(maxPositionStep.y, step.position.y));
+	}
+
+	nc::Vector2f minVelocityStep(0.0f, 0.0f);
+	nc::Vector2f maxVelocityStep(0.0f, 0.0f);
+	for (const nc::VelocityAffector::VelocityStep &step : s.velocityAffector->steps())
+	{
+		minVelocityStep.set(minOf(minVelocityStep.x, step.velocity.x), minOf(minVelocityStep.y, step.velocity.y));
+		maxVelocityStep.set(maxOf(maxVelocityStep.x, step.velocity.x), maxOf(maxVelocityStep.y, step.velocity.y));
+	}
+
+	float maxScale = s.sizeAffector->steps().isEmpty() ? 1.0f : 0.0f;
+	for (const nc::SizeAffector::SizeStep &step : s.sizeAffector->steps())
+		maxScale = maxOf(maxScale, maxOf(fabsf(step.scale.x), fabsf(step.scale.y)));
+	const nc::Vector2f baseScale = s.sizeAffector->baseScale();
+	if (s.sizeAffector->steps().isEmpty() == false)
+		maxScale *= maxOf(fabsf(baseScale.x), fabsf(baseScale.y));
+	// The diagonal covers the sprite with any anchor point and rotation
+	const float extent = sqrtf(static_cast<float>(s.texRect.w * s.texRect.w + s.texRect.h * s.texRect.h)) * maxScale;
+
+	// After `n` updates the velocity has been accelerated `n` times, the sum of the velocities is `n(n+1)/2` steps
+	const float frameTime = numFrames * interval;
+	const float accelerationTime = numFrames * (numFrames + 1.0f) * 0.5f * interval;
+
+	Bounds reach;
+	reach.min.x = minOf(init.rndPositionX.x, init.rndPositionX.y) + minOf(0.0f, minOf(init.rndVelocityX.x, init.rndVelocityX.y) * frameTime) +
+	              minVelocityStep.x * accelerationTime + minPositionStep.x * numFrames - extent;
+	reach.min.y = minOf(init.rndPositionY.x, init.rndPositionY.y) + minOf(0.0f, minOf(init.rndVelocityY.x, init.rndVelocityY.y) * frameTime) +
+	              minVelocityStep.y * accelerationTime + minPositionStep.y * numFrames - extent;
+	reach.max.x = maxOf(init.rndPositionX.x, init.rndPositionX.y) + maxOf(0.0f, maxOf(init.rndVelocityX.x, init.rndVelocityX.y) * frameTime) +
+	              maxVelocityStep.x * accelerationTime + maxPositionStep.x * numFrames + extent;
+	reach.max.y = maxOf(init.rndPositionY.x, init.rndPositionY.y) + maxOf(0.0f, maxOf(init.rndVelocityY.x, init.rndVelocityY.y) * frameTime) +
+	              maxVelocityStep.y * accelerationTime + maxPositionStep.y * numFrames + extent;
+	return reach;
+}
+
+/*! Particles in local space follow the emitter. The other ones stay where they have been emitted, so the
+ *  bounds also cover the previous emitter positions until the particles emitted there have died. */
+MyEventHandler::Bounds MyEventHandler::systemBounds(unsigned int index, float interval)
+{
+	ParticleSystemGuiState &s = sysStates_[index];
+	const Bounds reach = particleReach(index, interval);
+	const nc::Vector2f emitterPosition = dummy_->position() + particleSystems_[index]->position();
+
+	Bounds bounds;
+	bounds.min = emitterPosition + reach.min;
+	bounds.max = emitterPosition + reach.max;
+	if (s.inLocalSpace)
+	{
+		s.trailFrames = 0;
+		s.lastEmitterPosition = emitterPosition;
+		return bounds;
+	}
+
+	if (emitterPosition.x != s.lastEmitterPosition.x || emitterPosition.y != s.lastEmitterPosition.y)
+	{
+		const Bounds previous = { s.lastEmitterPosition + reach.min, s.lastEmitterPosition + reach.max };
+		if (s.trailFrames == 0)
+			s.trailBounds = previous;
+		else
+		{
+			s.trailBounds.min.set(minOf(s.trailBounds.min.x, previous.min.x), minOf(s.trailBounds.min.y, previous.min.y));
+			s.trailBounds.max.set(maxOf(s.trailBounds.max.x, previous.max.x), maxOf(s.trailBounds.max.y, previous.max.y));
+		}
+		const float maxLife = maxOf(s.init.rndLife.x, s.init.rndLife.y);
+		s.trailFrames = (maxLife > 0.0f && interval > 0.0f) ? static_cast<unsigned int>(ceilf(maxLife / interval)) + 1 : 1;
+		s.lastEmitterPosition = emitterPosition;
+	}
+
+	if (s.trailFrames > 0)
+	{
+		bounds.min.set(minOf(bounds.min.x, s.trailBounds.min.x), minOf(bounds.min.y, s.trailBounds.min.y));
+		bounds.max.set(maxOf(bounds.max.x, s.trailBounds.max.x), maxOf(bounds.max.y, s.trailBounds.max.y));
+	}
+	return bounds;
+}
+
+/*! A system that is not updated does not age its particles, they are frozen until it is visible again.
+ *  Inactive systems keep being updated until their last particles die. */
+void MyEventHandler::skipIdleSystems()
+{
+	const LuaLoader::Config &cfg = loader_->config();
+	const float interval = nc::theApplication().interval();
+	const float width = static_cast<float>(nc::theApplication().width());
+	const float height = static_cast<float>(nc::theApplication().height());
+
+	skipStatistics_ = SkipStatistics();
+	for (unsigned int i = 0; i < particleSystems_.size(); i++)
+	{
+		nc::ParticleSystem *particleSystem = particleSystems_[i].get();
+		ParticleSystemGuiState &s = sysStates_[i];
+		// Every system is created as a profiled one, its index changes when a previous system is destroyed
+		ProfiledParticleSystem *profiledSystem = static_cast<ProfiledParticleSystem *>(particleSystem);
+		profiledSystem->setProfileIndex(i);
+
+		bool update = true;
+		if (particleSystem->numAliveParticles() == 0)
+		{
+			if (s.active)
+				skipStatistics_.numIdle++;
+			else
+				skipStatistics_.numInactive++;
+			update = false;
+			s.trailFrames = 0;
+			s.lastEmitterPosition = dummy_->position() + particleSystem->position();
+		}
+		else if (cfg.culling)
+		{
+			const Bounds bounds = systemBounds(i, interval);
+			if (bounds.max.x < 0.0f || bounds.min.x > width || bounds.max.y < 0.0f || bounds.min.y > height)
+			{
+				skipStatistics_.numCulled++;
+				update = false;
+			}
+		}
+
+		particleSystem->setUpdateEnabled(update);
+		particleSystem->setDrawEnabled(update);
+		if (update)
+		{
+			skipStatistics_.numUpdated++;
+			if (s.trailFrames > 0)
+				s.trailFrames--;
+		}
+		else
+			profiledSystem->clearUpdateTime();
+	}
+}
@@ -0,0 +1,488 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "particle_editor_float.h"
+
+namespace {
+
+// The tables and constants of the Ryu algorithm for single precision values (Ulf Adams, PLDI 2018)
+const int MantissaBits = 23;
+const int ExponentBits = 8;
+const int ExponentBias = 127;
+const int Pow5InvBitCount = 61;
+const int Pow5BitCount = 61;
+
+/// Rounded up values of 2^(pow5Bits(i) - 1 + 61) / 5^i
+const uint64_t Pow5InvSplit[31] = {
+	0x2000000000000001ull, 0x199999999999999aull, 0x147ae147ae147ae2ull,
+	0x10624dd2f1a9fbe8ull, 0x1a36e2eb1c432ca6ull, 0x14f8b588e368f085ull,
+	0x10c6f7a0b5ed8d37ull, 0x1ad7f29abcaf4858ull, 0x15798ee2308c39e0ull,
+	0x112e0be826d694b3ull, 0x1b7cdfd9d7bdbab8ull, 0x15fd7fe179649560ull,
+	0x119799812dea111aull, 0x1c25c268497681c3ull, 0x16849b86a12b9b02ull,
+	0x1203af9ee756159cull, 0x1cd2b297d889bc2cull, 0x170ef54646d4968aull,
+	0x12725dd1d243aba1ull, 0x1d83c94fb6d2ac35ull, 0x179ca10c9242235eull,
+	0x12e3b40a0e9b4f7eull, 0x1e392010175ee597ull, 0x182db34012b25145ull,
+	0x1357c299a88ea76bull, 0x1ef2d0f5da7dd8abull, 0x18c240c4aecb13bcull,
+	0x13ce9a36f23c0fcaull, 0x1fb0f6be50601942ull, 0x195a5efea6b34768ull,
+	0x14484bfeebc29f87ull,
+};
+
+/// The 61 most significant bits of 5^i
+const uint64_t Pow5Split[47] = {
+	0x1000000000000000ull, 0x1400000000000000ull, 0x1900000000000000ull,
+	0x1f40000000000000ull, 0x1388000000000000ull, 0x186a000000000000ull,
+	0x1e84800000000000ull, 0x1312d00000000000ull, 0x17d7840000000000ull,
+	0x1dcd650000000000ull, 0x12a05f2000000000ull, 0x174876e800000000ull,
+	0x1d1a94a200000000ull, 0x12309ce540000000ull, 0x16bcc41e90000000ull,
+	0x1c6bf52634000000ull, 0x11c37937e0800000ull, 0x16345785d8a00000ull,
+	0x1bc16d674ec80000ull, 0x1158e460913d0000ull, 0x15af1d78b58c4000ull,
+	0x1b1ae4d6e2ef5000ull, 0x10f0cf064dd59200ull, 0x152d02c7e14af680ull,
+	0x1a784379d99db420ull, 0x108b2a2c28029094ull, 0x14adf4b7320334b9ull,
+	0x19d971e4fe8401e7ull, 0x1027e72f1f128130ull, 0x1431e0fae6d7217cull,
+	0x193e5939a08ce9dbull, 0x1f8def8808b02452ull, 0x13b8b5b5056e16b3ull,
+	0x18a6e32246c99c60ull, 0x1ed09bead87c0378ull, 0x13426172c74d822bull,
+	0x1812f9cf7920e2b6ull, 0x1e17b84357691b64ull, 0x12ced32a16a1b11eull,
+	0x178287f49c4a1d66ull, 0x1d6329f1c35ca4bfull, 0x125dfa371a19e6f7ull,
+	0x16f578c4e0a060b5ull, 0x1cb2d6f618c878e3ull, 0x11efc659cf7d4b8dull,
+	0x166bb7f0435c9e71ull, 0x1c06a5ec5433c60dull,
+};
+
+/// Returns `ceil(log2(5^e))` for `e` in [1, 3528], and one for zero
+inline int pow5Bits(int e)
+{
+	return static_cast<int>((static_cast<uint32_t>(e) * 1217359) >> 19) + 1;
+}
+
+/// Returns `floor(log10(2^e))` for `e` in [0, 1650]
+inline uint32_t log10Pow2(int e)
+{
+	return (static_cast<uint32_t>(e) * 78913) >> 18;
+}
+
+/// Returns `floor(log10(5^e))` for `e` in [0, 2620]
+inline uint32_t log10Pow5(int e)
+{
+	return (static_cast<uint32_t>(e) * 732923) >> 20;
+}
+
+inline uint32_t pow5Factor(uint32_t value)
+{
+	uint32_t count = 0;
+	while (value % 5 == 0)
+	{
+		value /= 5;
+		count++;
+	}
+	return count;
+}
+
+inline bool isMultipleOfPow5(uint32_t value, uint32_t p)
+{
+	return pow5Factor(value) >= p;
+}
+
+inline bool isMultipleOfPow2(uint32_t value, uint32_t p)
+{
+	return (value & ((1u << p) - 1)) == 0;
+}
+
+inline uint32_t mulShift(uint32_t m, uint64_t factor, int shift)
+{
+	const uint64_t low = static_cast<uint64_t>(m) * static_cast<uint32_t>(factor);
+	const uint64_t high = static_cast<uint64_t>(m) * static_cast<uint32_t>(factor >> 32);
+	const uint64_t sum = (low >> 32) + high;
+	return static_cast<uint32_t>(sum >> (shift - 32));
+}
+
+unsigned int numDecimalDigits(uint32_t value)
+{
+	unsigned int numDigits = 1;
+	while (value >= 10)
+	{
+		value /= 10;
+		numDigits++;
+	}
+	return numDigits;
+}
+
+/// Finds the shortest decimal mantissa and exponent that round to the same float
+void shortestDecimal(uint32_t ieeeMantissa, uint32_t ieeeExponent, uint32_t &mantissa, int &exponent)
+{
+	int e2 = 0;
+	uint32_t m2 = 0;
+	if (ieeeExponent == 0)
+	{
+		e2 = 1 - ExponentBias - MantissaBits - 2;
+		m2 = ieeeMantissa;
+	}
+	else
+	{
+		e2 = static_cast<int>(ieeeExponent) - ExponentBias - MantissaBits - 2;
+		m2 = (1u << MantissaBits) | ieeeMantissa;
+	}
+	// Round to nearest even accepts the interval bounds when the mantissa is even
+	const bool acceptBounds = (m2 & 1) == 0;
+
+	// The interval of valid representations, multiplied by four to keep the bounds integral
+	const uint32_t mv = 4 * m2;
+	const uint32_t mp = 4 * m2 + 2;
+	const uint32_t mmShift = (ieeeMantissa != 0 || ieeeExponent <= 1) ? 1 : 0;
+	const uint32_t mm = 4 * m2 - 1 - mmShift;
+
+	uint32_t vr, vp, vm;
+	int e10 = 0;
+	bool vmIsTrailingZeros = false;
+	bool vrIsTrailingZeros = false;
+	uint32_t lastRemovedDigit = 0;
+	if (e2 >= 0)
+	{
+		const uint32_t q = log10Pow2(e2);
+		e10 = static_cast<int>(q);
+		const int k = Pow5InvBitCount + pow5Bits(static_cast<int>(q)) - 1;
+		const int i = -e2 + static_cast<int>(q) + k;
+		vr = mulShift(mv, Pow5InvSplit[q], i);
+		vp = mulShift(mp, Pow5InvSplit[q], i);
+		vm = mulShift(mm, Pow5InvSplit[q], i);
+		if (q != 0 && (vp - 1) / 10 <= vm / 10)
+		{
+			// One removed digit is needed even if the loop below does not run
+			const int l = Pow5InvBitCount + pow5Bits(static_cast<int>(q - 1)) - 1;
+			lastRemovedDigit = mulShift(mv, Pow5InvSplit[q - 1], -e2 + static_cast<int>(q) - 1 + l) % 10;
+		}
+		if (q <= 9)
+		{
+			// Only one of `mp`, `mv` and `mm` can be a multiple of five
+			if (mv % 5 == 0)
+				vrIsTrailingZeros = isMultipleOfPow5(mv, q);
+			else if (acceptBounds)
+				vmIsTrailingZeros = isMultipleOfPow5(mm, q);
+			else
+				vp -= isMultipleOfPow5(mp, q) ? 1 : 0;
+		}
+	}
+	else
+	{
+		const uint32_t q = log10Pow5(-e2);
+		e10 = static_cast<int>(q) + e2;
+		const int i = -e2 - static_cast<int>(q);
+		const int k = pow5Bits(i) - Pow5BitCount;
+		int j = static_cast<int>(q) - k;
+		vr = mulShift(mv, Pow5Split[i], j);
+		vp = mulShift(mp, Pow5Split[i], j);
+		vm = mulShift(mm, Pow5Split[i], j);
+		if (q != 0 && (vp - 1) / 10 <= vm / 10)
+		{
+			j = static_cast<int>(q) - 1 - (pow5Bits(i + 1) - Pow5BitCount);
+			lastRemovedDigit = mulShift(mv, Pow5Split[i + 1], j) % 10;
+		}
+		if (q <= 1)
+		{
+			// `mv` always has at least two trailing zero bits
+			vrIsTrailingZeros = true;
+			if (acceptBounds)
+				vmIsTrailingZeros = (mmShift == 1);
+			else
+				vp--;
+		}
+		else if (q < 31)
+			vrIsTrailingZeros = isMultipleOfPow2(mv, q - 1);
+	}
+
+	// Removes digits as long as the shortened values stay inside the interval
+	int removed = 0;
+	if (vmIsTrailingZeros || vrIsTrailingZeros)
+	{
+		while (vp / 10 > vm / 10)
+		{
+			vmIsTrailingZeros &= (vm % 10 == 0);
+			vrIsTrailingZeros &= (lastRemovedDigit == 0);
+			lastRemovedDigit = vr % 10;
+			vr /= 10;
+			vp /= 10;
+			vm /= 10;
+			removed++;
+		}
+		if (vmIsTrailingZeros)
+		{
+			while (vm % 10 == 0)
+			{
+				vrIsTrailingZeros &= (lastRemovedDigit == 0);
+				lastRemovedDigit = vr % 10;
+				vr /= 10;
+				vp /= 10;
+				vm /= 10;
+				removed++;
+			}
+		}
+		// Rounds to even if the exact value ends with 50...0
+		if (vrIsTrailingZeros && lastRemovedDigit == 5 && vr % 2 == 0)
+			lastRemovedDigit = 4;
+		const bool roundUp = (vr == vm && (acceptBounds == false || vmIsTrailingZeros == false)) || lastRemovedDigit >= 5;
+		mantissa = vr + (roundUp ? 1 : 0);
+	}
+	else
+	{
+		// The common case does not need to track trailing zeros
+		while (vp / 10 > vm / 10)
+		{
+			lastRemovedDigit = vr % 10;
+			vr /= 10;
+			vp /= 10;
+			vm /= 10;
+			removed++;
+		}
+		const bool roundUp = (vr == vm || lastRemovedDigit >= 5);
+		mantissa = vr + (roundUp ? 1 : 0);
+	}
+	exponent = e10 + removed;
+}
+
+/// Writes the digits of a decimal number in plain or scientific notation and returns the length
+unsigned int writeDecimal(bool negative, uint32_t mantissa, int exponent, char *buffer)
+{
+	unsigned int length = 0;
+	char digits[10];
+	const unsigned int numDigits = numDecimalDigits(mantissa);
+	for (unsigned int i = numDigits; i > 0; i--)
+	{
+		digits[i - 1] = static_cast<char>('0' + mantissa % 10);
+		mantissa /= 10;
+	}
+
+	if (negative)
+		buffer[length++] = '-';
+
+	// The number of digits before the decimal point, like `%g` the plain notation is used for moderate magnitudes
+	const int pointPosition = static_cast<int>(numDigits) + exponent;
+	if (pointPosition > 9 || pointPosition < -3)
+	{
+		buffer[length++] = digits[0];
+		if (numDigits > 1)
+		{
+			buffer[length++] = '.';
+			memcpy(buffer + length, digits + 1, numDigits - 1);
+			length += numDigits - 1;
+		}
+		buffer[length++] = 'e';
+		int scientificExponent = pointPosition - 1;
+		if (scientificExponent < 0)
+		{
+			buffer[length++] = '-';
+			scientificExponent = -scientificExponent;
+		}
+		if (scientificExponent >= 10)
+			buffer[length++] = static_cast<char>('0' + scientificExponent / 10);
+		buffer[length++] = static_cast<char>('0' + scientificExponent % 10);
+	}
+	else if (pointPosition <= 0)
+	{
+		buffer[length++] = '0';
+		buffer[length++] = '.';
+		for (int i = pointPosition; i < 0; i++)
+			buffer[length++] = '0';
+		memcpy(buffer + length, digits, numDigits);
+		length += numDigits;
+	}
+	else if (pointPosition >= static_cast<int>(numDigits))
+	{
+		memcpy(buffer + length, digits, numDigits);
+		length += numDigits;
+		for (int i = numDigits; i < pointPosition; i++)
+			buffer[length++] = '0';
+	}
+	else
+	{
+		memcpy(buffer + length, digits, pointPosition);
+		length += pointPosition;
+		buffer[length++] = '.';
+		memcpy(buffer + length, digits + pointPosition, numDigits - pointPosition);
+		length += numDigits - pointPosition;
+	}
+
+	buffer[length] = '\0';
+	return length;
+}
+
+/// Rounds a positive float to the specified number of significant digits
+void roundedDecimal(float value, unsigned int numDigits, uint32_t &mantissa, int &exponent)
+{
+	char string[32];
+	snprintf(string, sizeof(string), "%.*e", static_cast<int>(numDigits) - 1, static_cast<double>(value));
+
+	mantissa = 0;
+	const char *current = string;
+	for (; *current != 'e'; current++)
+	{
+		if (*current != '.')
+			mantissa = mantissa * 10 + static_cast<uint32_t>(*current - '0');
+	}
+	exponent = atoi(current + 1) - static_cast<int>(numDigits - 1);
+}
+
+/// Exactly representable powers of ten for the parsing fast path
+const double Pow10[23] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/// Integers up to 2^53 are exactly representable as doubles
+const uint64_t MaxExactInteger = 1ull << 53;
+
+double parseSlow(const char *string, unsigned int length)
+{
+	char number[64];
+	if (length >= sizeof(number))
+		length = sizeof(number) - 1;
+	memcpy(number, string, length);
+	number[length] = '\0';
+	return strtod(number, nullptr);
+}
+
+}
+
+///////////////////////////////////////////////////////////
+// CONSTRUCTORS and DESTRUCTOR
+///////////////////////////////////////////////////////////
+
+FloatString::FloatString(float value)
+    : length_(format(value, buffer_))
+{
+}
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+unsigned int FloatString::format(float value, char *buffer)
+{
+	uint32_t bits = 0;
+	memcpy(&bits, &value, sizeof(bits));
+	const bool negative = (bits >> 31) != 0;
+	const uint32_t ieeeMantissa = bits & ((1u << MantissaBits) - 1);
+	const uint32_t ieeeExponent = (bits >> MantissaBits) & ((1u << ExponentBits) - 1);
+
+	unsigned int length = 0;
+	// Lua reads infinities from overflowing literals and NaNs from a division
+	if (ieeeExponent == (1u << ExponentBits) - 1)
+	{
+		const char *string = (ieeeMantissa != 0) ? "0/0" : (negative ? "-1e999" : "1e999");
+		length = static_cast<unsigned int>(strlen(string));
+		memcpy(buffer, string, length + 1);
+		return length;
+	}
+	else if (ieeeExponent == 0 && ieeeMantissa == 0)
+	{
+		// Lua would read "-0" as an integer and lose the sign
+		const char *string = negative ? "-0.0" : "0";
+		length = static_cast<unsigned int>(strlen(string));
+		memcpy(buffer, string, length + 1);
+		return length;
+	}
+
+	uint32_t mantissa = 0;
+	int exponent = 0;
+	shortestDecimal(ieeeMantissa, ieeeExponent, mantissa, exponent);
+
+	length = writeDecimal(negative, mantissa, exponent, buffer);
+
+	// Lua and the project parser read a double that is then narrowed, a shortest representation can round twice to another float
+	for (unsigned int numDigits = numDecimalDigits(mantissa) + 1; numDigits <= 9; numDigits++)
+	{
+		if (static_cast<float>(parse(buffer, length)) == value)
+			break;
+		roundedDecimal(negative ? -value : value, numDigits, mantissa, exponent);
+		length = writeDecimal(negative, mantissa, exponent, buffer);
+	}
+
+	return length;
+}
+
+double FloatString::parse(const char *string, unsigned int length)
+{
+	const char *current = string;
+	const char *end = string + length;
+
+	bool negative = false;
+	if (current < end && (*current == '-' || *current == '+'))
+	{
+		negative = (*current == '-');
+		current++;
+	}
+
+	// Up to nineteen significant digits fit in the 64 bits mantissa
+	uint64_t mantissa = 0;
+	unsigned int numSignificantDigits = 0;
+	int exponent = 0;
+	bool truncated = false;
+	bool hasDigits = false;
+	while (current < end && *current >= '0' && *current <= '9')
+	{
+		hasDigits = true;
+		if (numSignificantDigits < 19)
+		{
+			mantissa = mantissa * 10 + static_cast<uint64_t>(*current - '0');
+			if (mantissa > 0)
+				numSignificantDigits++;
+		}
+		else
+		{
+			exponent++;
+			truncated |= (*current != '0');
+		}
+		current++;
+	}
+	if (current < end && *current == '.')
+	{
+		current++;
+		while (current < end && *current >= '0' && *current <= '9')
+		{
+			hasDigits = true;
+			if (numSignificantDigits < 19)
+			{
+				mantissa = mantissa * 10 + static_cast<uint64_t>(*current - '0');
+				if (mantissa > 0)
+					numSignificantDigits++;
+				exponent--;
+			}
+			else
+				truncated |= (*current != '0');
+			current++;
+		}
+	}
+	if (hasDigits && current < end && (*current == 'e' || *current == 'E'))
+	{
+		current++;
+		bool negativeExponent = false;
+		if (current < end && (*current == '-' || *current == '+'))
+		{
+			negativeExponent = (*current == '-');
+			current++;
+		}
+		int explicitExponent = 0;
+		while (current < end && *current >= '0' && *current <= '9')
+		{
+			if (explicitExponent < 10000)
+				explicitExponent = explicitExponent * 10 + (*current - '0');
+			current++;
+		}
+		exponent += negativeExponent ? -explicitExponent : explicitExponent;
+	}
+
+	if (hasDigits == false || current != end || truncated)
+		return parseSlow(string, length);
+
+	if (mantissa == 0)
+		return negative ? -0.0 : 0.0;
+
+	// Both the mantissa and the power of ten are exact, a single operation rounds correctly (Clinger's fast path)
+	if (mantissa <= MaxExactInteger && exponent >= -22 && exponent <= 22)
+	{
+		double value = static_cast<double>(mantissa);
+		value = (exponent < 0) ? value / Pow10[-exponent] : value * Pow10[exponent];
+		return negative ? -value : value;
+	}
+
+	return parseSlow(string, length);
+}
@@ -0,0 +1,30 @@
+#ifndef CLASS_FLOATSTRING
+#define CLASS_FLOATSTRING
+
+/// The shortest decimal representation of a float that reads back as the same value
+/*! The digits are generated with the Ryu algorithm, without the trailing zeros of `%f`.
+ *  The value also reads back when parsed as a double and then narrowed, a digit is added in the rare cases that need it.
+ *  A temporary object can be passed to a formatting function: `FloatString(value).data()` */
+class FloatString
+{
+  public:
+	/// Enough for a sign, nine digits, a decimal point, an exponent and the terminator
+	static const unsigned int MaxLength = 16;
+
+	explicit FloatString(float value);
+
+	inline const char *data() const { return buffer_; }
+	inline unsigned int length() const { return length_; }
+
+	/// Writes the null terminated representation in a buffer of at least `MaxLength` characters and returns its length
+	static unsigned int format(float value, char *buffer);
+	/// Converts a decimal number to the same double returned by `strtod()`, the string does not need to be null terminated
+	/*! Most numbers are converted exactly with a single floating point operation, only the others go through `strtod()` */
+	static double parse(const char *string, unsigned int length);
+
+  private:
+	char buffer_[MaxLength];
+	unsigned int length_;
+};
+
+#endif
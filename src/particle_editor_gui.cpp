@@ -4,11 +4,16 @@
 #include "particle_editor.h"
 #include "particle_editor_gui_labels.h"
 #include "particle_editor_lua.h"
+#include "particle_editor_loadjob.h"
+#include "particle_editor_textures.h"
+#include "particle_editor_atlas.h"
+#include "particle_editor_profiler.h"
 #include <ncine/Application.h>
 #include <ncine/Viewport.h>
 #include <ncine/Texture.h>
 #include <ncine/Sprite.h>
 #include <ncine/ParticleSystem.h>
+#include <ncine/Particle.h>
 #include <ncine/FileSystem.h>
 
 #include "version.h"
@@ -26,12 +31,20 @@ const char *lifeItems[] = { "Constant", "Min/Max" };
 const char *positionItems[] = { "Constant", "Min/Max", "Radius" };
 const char *velocityItems[] = { "Constant", "Min/Max", "Scale" };
 const char *rotationItems[] = { "Emitter", "Constant", "Min/Max" };
+/// Memory used by every particle of a pool: the particle node and the pointers of the system arrays
+const unsigned int ParticleBytes = sizeof(nc::Particle) + 2 * sizeof(nc::Particle *);
+/// Prewarm updates are cheap, but a whole minute of simulation is more than any looping effect needs
+const float MaxPrewarmTime = 60.0f;
+#ifdef WITH_PROFILER
+const char *TraceFile = "trace.json";
+#endif
 
 static bool requestCloseModal = false;
 static bool openModal = false;
 static bool saveAsModal = false;
 static bool showAboutWindow = false;
 static bool allowOverwrite = false;
+static bool exportAtlasLayout = false;
 
 void showHelpMarker(const char *description)
 {
@@ -63,8 +76,8 @@ int inputTextCallback(ImGuiInputTextCallbackData *data)
 
 bool MyEventHandler::menuNewEnabled()
 {
-	return (particleSystems_.isEmpty() == false ||
-	        textures_.isEmpty() == false);
+	return (projectLoadJob_->isActive() == false &&
+	        (particleSystems_.isEmpty() == false || textures_->isEmpty() == false));
 }
 
 void MyEventHandler::menuNew()
@@ -75,16 +88,19 @@ void MyEventHandler::menuNew()
 void MyEventHandler::menuOpen()
 {
 #ifndef __EMSCRIPTEN__
+	if (openModal == false)
+		previousFilename_ = filename_;
 	openModal = true;
 #else
 	if (loader_->localFileLoad.isLoading() == false)
-		loader_->localFileLoad.load(".lua");
+		loader_->localFileLoad.load(".lua,.ncpb");
 #endif
 }
 
 bool MyEventHandler::menuSaveEnabled()
 {
-	return (particleSystems_.isEmpty() == false &&
+	return (projectLoadJob_->isActive() == false &&
+	        particleSystems_.isEmpty() == false &&
 	        filename_.isEmpty() == false);
 }
 
@@ -99,6 +115,20 @@ void MyEventHandler::menuSave()
 #endif
 }
 
+#ifdef WITH_PROFILER
+void MyEventHandler::menuSaveTrace()
+{
+	const FrameProfiler &profiler = theFrameProfiler();
+	if (profiler.saveChromeTrace(TraceFile))
+	{
+		const uint32_t firstFrame = (profiler.size() > 0) ? profiler[0].frame : profiler.frame();
+		logString_.formatAppend("Saved %u profiler events of %u frames to \"%s\"\n", profiler.size(), profiler.frame() - firstFrame + 1, TraceFile);
+	}
+	else
+		logString_.formatAppend("Could not save profiler trace \"%s\"\n", TraceFile);
+}
+#endif
+
 void MyEventHandler::menuQuit()
 {
 	nc::theApplication().quit();
@@ -138,19 +168,25 @@ void MyEventHandler::createGuiMainWindow()
 
 		createGuiMenus();
 
-		createGuiBackground();
-		createGuiTextures();
-		createGuiParticleSystems();
-
-		if (particleSystems_.size() > 0)
+		// The project data cannot be edited while a new project is replacing it
+		if (projectLoadJob_->isActive())
+			createGuiLoadingProgress();
+		else
 		{
-			createGuiSprite();
-			createGuiColorAffector();
-			createGuiSizeAffector();
-			createGuiRotationAffector();
-			createGuiPositionAffector();
-			createGuiVelocityAffector();
-			createGuiEmission();
+			createGuiBackground();
+			createGuiTextures();
+			createGuiParticleSystems();
+
+			if (particleSystems_.size() > 0)
+			{
+				createGuiSprite();
+				createGuiColorAffector();
+				createGuiSizeAffector();
+				createGuiRotationAffector();
+				createGuiPositionAffector();
+				createGuiVelocityAffector();
+				createGuiEmission();
+			}
 		}
 
 		ImGui::Separator();
@@ -181,8 +217,7 @@ void MyEventHandler::createGuiMenus()
 					{
 						const LuaLoader::Config &luaConfig = loader_->config();
 						nctl::String filePath = nc::fs::joinPath(luaConfig.scriptsPath, recentFilenames_[i]);
-						if (load(filePath.data()))
-							filename_ = recentFilenames_[i];
+						load(filePath.data(), recentFilenames_[i].data());
 						break;
 					}
 					i = (i + 1) % MaxRecentFiles;
@@ -208,11 +243,7 @@ void MyEventHandler::createGuiMenus()
 					{
 						const LuaLoader::Config &luaConfig = loader_->config();
 						nctl::String filePath = nc::fs::joinPath(luaConfig.scriptsPath, ScriptStrings::Names[i]);
-						if (load(filePath.data()))
-						{
-							filename_ = ScriptStrings::Names[i];
-							pushRecentFile(filename_);
-						}
+						load(filePath.data(), ScriptStrings::Names[i]);
 					}
 				}
 				ImGui::EndMenu();
@@ -225,6 +256,11 @@ void MyEventHandler::createGuiMenus()
 			if (ImGui::MenuItem(Labels::SaveAs, nullptr, false, saveAsEnabled))
 				saveAsModal = true;
 
+#ifdef WITH_PROFILER
+			if (ImGui::MenuItem(Labels::SaveTrace, "CTRL + P"))
+				menuSaveTrace();
+#endif
+
 			ImGui::Separator();
 
 			if (ImGui::MenuItem(Labels::Quit, "CTRL + Q"))
@@ -238,6 +274,7 @@ void MyEventHandler::createGuiMenus()
 			ImGui::MenuItem(Labels::Main, "CTRL + 1", &showMainWindow_);
 			ImGui::MenuItem(Labels::Config, "CTRL + 2", &showConfigWindow_);
 			ImGui::MenuItem(Labels::Log, "CTRL + 3", &showLogWindow_);
+			ImGui::MenuItem(Labels::Performance, "CTRL + 4", &showPerformanceWindow_);
 			ImGui::EndMenu();
 		}
 
@@ -286,9 +323,10 @@ void MyEventHandler::createGuiPopups()
 		{
 			const LuaLoader::Config &luaConfig = loader_->config();
 			nctl::String filePath = nc::fs::joinPath(luaConfig.scriptsPath, filename_);
-			if (nc::fs::isReadableFile(filePath.data()) && load(filePath.data()))
+			if (nc::fs::isReadableFile(filePath.data()) && load(filePath.data(), filename_.data()))
 			{
-				pushRecentFile(filename_);
+				// The name changes when the project has been loaded, a failed load keeps the current one
+				filename_ = previousFilename_;
 				requestCloseModal = true;
 			}
 			else
@@ -301,7 +339,10 @@ void MyEventHandler::createGuiPopups()
 
 		ImGui::SameLine();
 		if (ImGui::Button(Labels::Cancel))
+		{
+			filename_ = previousFilename_;
 			requestCloseModal = true;
+		}
 
 		if (requestCloseModal)
 		{
@@ -335,11 +376,15 @@ void MyEventHandler::createGuiPopups()
 			else
 			{
 				save(filePath.data());
+				if (exportAtlasLayout)
+					saveTextureAtlasLayout(filePath.data());
 				pushRecentFile(filename_);
 				requestCloseModal = true;
 			}
 #else
 			save(filename_.data());
+			if (exportAtlasLayout)
+				saveTextureAtlasLayout(filename_.data());
 			requestCloseModal = true;
 #endif
 		}
@@ -352,6 +397,10 @@ void MyEventHandler::createGuiPopups()
 		ImGui::SameLine();
 		ImGui::Checkbox("Allow Overwrite", &allowOverwrite);
 #endif
+		ImGui::SameLine();
+		ImGui::Checkbox("Export Atlas", &exportAtlasLayout);
+		ImGui::SameLine();
+		showHelpMarker("Also saves the layout of all textures packed in atlas pages");
 
 		if (requestCloseModal)
 		{
@@ -442,8 +491,8 @@ void MyEventHandler::createGuiBackground()
 void MyEventHandler::createGuiTextures()
 {
 	widgetName_.format(Labels::Textures);
-	if (textures_.isEmpty() == false)
-		widgetName_.formatAppend(" (#%u of %u)", texIndex_, textures_.size());
+	if (textures_->isEmpty() == false)
+		widgetName_.formatAppend(" (#%u of %u)", texIndex_, textures_->size());
 	widgetName_.append("###Textures");
 	ImGui::PushID("Textures");
 	if (ImGui::CollapsingHeader(widgetName_.data()))
@@ -459,24 +508,31 @@ void MyEventHandler::createGuiTextures()
 		ImGui::SameLine();
 		if (ImGui::Button(Labels::Load) && texFilename_.isEmpty() == false)
 		{
-			texIndex_ = textures_.size();
-			texNames_[texIndex_] = texFilename_;
-
-			if (createTexture(texIndex_) == false)
+			const unsigned int loadedIndex = textures_->indexOf(texFilename_);
+			if (loadedIndex != TextureRegistry::InvalidIndex)
 			{
-				texIndex_ = textures_.size() - 1;
-				texFilename_ = Labels::LoadingError;
+				texIndex_ = loadedIndex;
+				logString_.formatAppend("Texture \"%s\" is already loaded at index #%u\n", texFilename_.data(), loadedIndex);
+				texFilename_.clear();
 			}
-			else
+			else if (createTexture(texFilename_))
+			{
+				texIndex_ = textures_->size() - 1;
 				texFilename_.clear();
+				if (useTextureAtlas_)
+					rebuildTextureAtlas();
+			}
+			else
+				texFilename_ = Labels::LoadingError;
 		}
 
-		if (textures_.isEmpty() == false)
+		if (textures_->isEmpty() == false)
 		{
 			comboString_.clear();
-			for (unsigned int i = 0; i < textures_.size(); i++)
+			for (unsigned int i = 0; i < textures_->size(); i++)
 			{
-				comboString_.formatAppend("#%u: %s (%d x %d)", i, texNames_[i].data(), textures_[i]->width(), textures_[i]->height());
+				const nc::Texture *tex = textures_->texture(i);
+				comboString_.formatAppend("#%u: %s (%d x %d)", i, textures_->name(i).data(), tex->width(), tex->height());
 				comboString_.setLength(comboString_.length() + 1);
 			}
 			comboString_.setLength(comboString_.length() + 1);
@@ -486,20 +542,12 @@ void MyEventHandler::createGuiTextures()
 			ImGui::Combo("Loaded Textures", &texIndex_, comboString_.data());
 
 			ImGui::SameLine();
-			if (ImGui::Button(Labels::Delete) && texIndex_ < textures_.size())
+			if (ImGui::Button(Labels::Delete) && texIndex_ < textures_->size())
 			{
-				// Check if the texture is in use by some system
-				bool canDelete = true;
-				for (const ParticleSystemGuiState &state : sysStates_)
-				{
-					if (state.texture == textures_[texIndex_].get())
-					{
-						canDelete = false;
-						break;
-					}
-				}
-
-				if (canDelete)
+				// A texture in use by some system cannot be deleted
+				if (textures_->isInUse(texIndex_))
+					logString_.formatAppend("Texture at index #%u is used by %u particle systems\n", texIndex_, textures_->refCount(texIndex_));
+				else
 				{
 					destroyTexture(texIndex_);
 					texIndex_--;
@@ -507,10 +555,21 @@ void MyEventHandler::createGuiTextures()
 			}
 		}
 
+		if (ImGui::Checkbox("Use Atlas", &useTextureAtlas_))
+			rebuildTextureAtlas();
+		if (useTextureAtlas_ && textureAtlas_->isEmpty() == false)
+		{
+			const AtlasPacker &packer = textureAtlas_->packer();
+			ImGui::SameLine();
+			ImGui::Text("%u pages, %.1f%% efficiency", packer.numPages(), packer.efficiency() * 100.0f);
+		}
+		ImGui::SameLine();
+		showHelpMarker("Packs all textures in atlas pages to let particle systems with different textures be batched together");
+
 		// Needs to check again as the last texture might have just been deleted
-		if (textures_.isEmpty() == false)
+		if (textures_->isEmpty() == false)
 		{
-			nc::Texture &tex = *textures_[texIndex_];
+			nc::Texture &tex = *textures_->texture(texIndex_);
 			const ImVec2 size(tex.width(), tex.height());
 			ImGui::Image(static_cast<ImTextureID>(reinterpret_cast<intptr_t>(tex.guiTexId())), size);
 		}
@@ -534,7 +593,7 @@ void MyEventHandler::createGuiParticleSystems()
 	ImGui::PushID("ParticleSystems");
 	if (ImGui::CollapsingHeader(widgetName_.data()))
 	{
-		if (textures_.isEmpty())
+		if (textures_->isEmpty())
 			ImGui::Text("Load at least one texture before creating a particle system");
 
 		ImGui::SliderFloat("Pos X", &parentPosition_.x, 0.0f, nc::theApplication().width());
@@ -548,12 +607,13 @@ void MyEventHandler::createGuiParticleSystems()
 		ImGui::Separator();
 		if (ImGui::Button(Labels::New))
 		{
-			if (textures_.isEmpty() == false)
+			if (textures_->isEmpty() == false)
 			{
 				systemIndex_ = particleSystems_.size();
 				sysStates_[systemIndex_] = {};
-				nc::Texture *tex = textures_[texIndex_].get();
+				nc::Texture *tex = textures_->texture(texIndex_);
 				sysStates_[systemIndex_].texture = tex;
+				textures_->acquire(tex);
 				sysStates_[systemIndex_].texRect.set(0, 0, tex->width(), tex->height());
 				createParticleSystem(systemIndex_);
 			}
@@ -586,7 +646,8 @@ void MyEventHandler::createGuiParticleSystems()
 		if (particleSystems_.isEmpty() == false)
 		{
 			ImGui::SameLine();
-			ImGui::Checkbox("Active", &sysStates_[systemIndex_].active);
+			if (ImGui::Checkbox("Active", &sysStates_[systemIndex_].active))
+				scheduleEmission(systemIndex_);
 		}
 
 		static int lastSystemIndex = -1;
@@ -618,17 +679,25 @@ void MyEventHandler::createGuiParticleSystems()
 			ImGui::SliderInt("Particles", &s.numParticles, 1, cfg.maxNumParticles);
 			if (ImGui::Button(Labels::Apply) && s.numParticles != particleSystem->numParticles())
 			{
-				unsigned int tempSystemIndex = particleSystems_.size();
-				cloneParticleSystem(systemIndex_, tempSystemIndex, 1);
-				cloneParticleSystem(tempSystemIndex, systemIndex_, s.numParticles);
-				destroyParticleSystem(tempSystemIndex);
+				resizeParticleSystem(systemIndex_, s.numParticles);
 				particleSystem = particleSystems_[systemIndex_].get();
 			}
 			ImGui::SameLine();
 			if (ImGui::Button(Labels::Reset))
 				s.numParticles = particleSystem->numParticles();
 			ImGui::SameLine();
-			showHelpMarker("Applies the new number by creating a temporary clone and thus preserving the system state");
+			showHelpMarker("Applies the new number keeping the affectors and as many alive particles as fit");
+
+			const PoolAdvisor::Advice &advice = poolAdvice(systemIndex_);
+			ImGui::Text("Advised: %u (steady %.0f, simulated peak %u)", advice.suggestedSize, advice.steadyAlive, advice.simulatedPeak);
+			ImGui::SameLine();
+			if (ImGui::Button("Fit"))
+			{
+				fitParticleSystem(systemIndex_);
+				particleSystem = particleSystems_[systemIndex_].get();
+			}
+			ImGui::SameLine();
+			showHelpMarker("Resizes the pool to the worst case of alive particles, derived from the amount, the life and the delay or rate");
 
 			ImGui::SliderFloat("Rel Pos X", &s.position.x, -cfg.systemPositionRange, cfg.systemPositionRange);
 			ImGui::SameLine();
@@ -671,15 +740,15 @@ void MyEventHandler::createGuiSprite()
 		ParticleSystemGuiState &s = sysStates_[systemIndex_];
 
 		static int selectedTextureIndex = -1;
-		unsigned int currentTextureIndex = 0;
+		unsigned int currentTextureIndex = textures_->indexOf(spriteState_.texture);
+		if (currentTextureIndex == TextureRegistry::InvalidIndex)
+			currentTextureIndex = 0;
 		comboString_.clear();
-		for (unsigned int i = 0; i < textures_.size(); i++)
+		for (unsigned int i = 0; i < textures_->size(); i++)
 		{
-			comboString_.formatAppend("#%u: %s (%d x %d)", i, texNames_[i].data(), textures_[i]->width(), textures_[i]->height());
+			const nc::Texture *tex = textures_->texture(i);
+			comboString_.formatAppend("#%u: %s (%d x %d)", i, textures_->name(i).data(), tex->width(), tex->height());
 			comboString_.setLength(comboString_.length() + 1);
-
-			if (textures_[i].get() == spriteState_.texture)
-				currentTextureIndex = i;
 		}
 		comboString_.setLength(comboString_.length() + 1);
 		// Append a second '\0' to signal the end of the combo item list
@@ -687,7 +756,7 @@ void MyEventHandler::createGuiSprite()
 
 		selectedTextureIndex = currentTextureIndex;
 		ImGui::Combo("Texture", &selectedTextureIndex, comboString_.data());
-		spriteState_.texture = textures_[selectedTextureIndex].get();
+		spriteState_.texture = textures_->texture(selectedTextureIndex);
 		if (s.texture != spriteState_.texture)
 		{
 			if (s.texture != nullptr &&
@@ -695,10 +764,12 @@ void MyEventHandler::createGuiSprite()
 			    s.texture->height() != spriteState_.texture->height()))
 			{
 				spriteState_.texRect.set(0, 0, spriteState_.texture->width(), spriteState_.texture->height());
-				particleSystem->setTexRect(spriteState_.texRect);
+				s.texRect = spriteState_.texRect;
 			}
-			particleSystem->setTexture(spriteState_.texture);
+			textures_->release(s.texture);
 			s.texture = spriteState_.texture;
+			textures_->acquire(s.texture);
+			applySystemTexture(systemIndex_);
 		}
 
 		nc::Texture &tex = *spriteState_.texture;
@@ -742,8 +813,8 @@ void MyEventHandler::createGuiSprite()
 		if (s.texRect.x != spriteState_.texRect.x || s.texRect.y != spriteState_.texRect.y ||
 		    s.texRect.w != spriteState_.texRect.w || s.texRect.h != spriteState_.texRect.h)
 		{
-			particleSystem->setTexRect(spriteState_.texRect);
 			s.texRect = spriteState_.texRect;
+			applySystemTexture(systemIndex_);
 		}
 
 		ImGui::Checkbox("Flipped X", &spriteState_.flippedX);
@@ -824,22 +895,32 @@ void MyEventHandler::createGuiColorAffector()
 			ImGui::Separator();
 		}
 
+		// Steps are edited as copies, the curve is only detached from the other systems when a step changes
 		int stepId = 0;
-		for (nc::ColorAffector::ColorStep &step : s.colorAffector->steps())
+		for (; stepId < static_cast<int>(s.colorAffector->steps().size()); stepId++)
 		{
+			nc::ColorAffector::ColorStep step = s.colorAffector->steps()[stepId];
 			widgetName_.format("Step %d", stepId);
 			if (ImGui::TreeNodeEx(widgetName_.data(), ImGuiTreeNodeFlags_DefaultOpen))
 			{
+				bool stepChanged = false;
 				if (stepId > 0 && step.age < s.colorAffector->steps()[stepId - 1].age)
+				{
 					step.age = s.colorAffector->steps()[stepId - 1].age;
+					stepChanged = true;
+				}
 
 				widgetName_.format("Color##%d", stepId);
-				ImGui::ColorEdit4(widgetName_.data(), step.color.data(), ImGuiColorEditFlags_AlphaBar | ImGuiColorEditFlags_AlphaPreviewHalf);
+				stepChanged |= ImGui::ColorEdit4(widgetName_.data(), step.color.data(), ImGuiColorEditFlags_AlphaBar | ImGuiColorEditFlags_AlphaPreviewHalf);
 				widgetName_.format("Age##%d", stepId);
-				ImGui::SliderFloat(widgetName_.data(), &step.age, 0.0f, 1.0f);
+				stepChanged |= ImGui::SliderFloat(widgetName_.data(), &step.age, 0.0f, 1.0f);
+				if (stepChanged)
+				{
+					s.colorAffector = s.sharedColorAffector->edit();
+					s.colorAffector->steps()[stepId] = step;
+				}
 				ImGui::TreePop();
 			}
-			stepId++;
 		}
 
 		if (s.colorAffector->steps().isEmpty() == false)
@@ -853,6 +934,7 @@ void MyEventHandler::createGuiColorAffector()
 
 			if (ImGui::Button(Labels::Add))
 			{
+				s.colorAffector = s.sharedColorAffector->edit();
 				for (int i = static_cast<int>(s.colorAffector->steps().size()) - 1; i >= -1; i--)
 				{
 					const bool placeNotFound = (i > -1) ? s.colorAffector->steps()[i].age > s.colorAge : false;
@@ -868,10 +950,16 @@ void MyEventHandler::createGuiColorAffector()
 			}
 			ImGui::SameLine();
 			if (ImGui::Button(Labels::Remove) && s.colorAffector->steps().size() > 0)
+			{
+				s.colorAffector = s.sharedColorAffector->edit();
 				s.colorAffector->steps().setSize(s.colorAffector->steps().size() - 1);
+			}
 			ImGui::SameLine();
 			if (ImGui::Button(Labels::RemoveAll) && s.colorAffector->steps().size() > 0)
+			{
+				s.colorAffector = s.sharedColorAffector->edit();
 				s.colorAffector->steps().clear();
+			}
 			ImGui::TreePop();
 		}
 	}
@@ -952,7 +1040,11 @@ void MyEventHandler::createGuiSizeAffector()
 		ImGui::SameLine();
 		if (ImGui::Button(Labels::Reset))
 			s.baseScale.set(1.0f, 1.0f);
-		s.sizeAffector->setBaseScale(s.baseScale);
+		if (s.baseScale.x != s.sizeAffector->baseScale().x || s.baseScale.y != s.sizeAffector->baseScale().y)
+		{
+			s.sizeAffector = s.sharedSizeAffector->edit();
+			s.sizeAffector->setBaseScale(s.baseScale);
+		}
 		ImGui::Separator();
 
 		if (s.sizeAffector->steps().isEmpty() == false)
@@ -962,21 +1054,30 @@ void MyEventHandler::createGuiSizeAffector()
 		}
 
 		int stepId = 0;
-		for (nc::SizeAffector::SizeStep &step : s.sizeAffector->steps())
+		for (; stepId < static_cast<int>(s.sizeAffector->steps().size()); stepId++)
 		{
+			nc::SizeAffector::SizeStep step = s.sizeAffector->steps()[stepId];
 			widgetName_.format("Step %d", stepId);
 			if (ImGui::TreeNodeEx(widgetName_.data(), ImGuiTreeNodeFlags_DefaultOpen))
 			{
+				bool stepChanged = false;
 				if (stepId > 0 && step.age < s.sizeAffector->steps()[stepId - 1].age)
+				{
 					step.age = s.sizeAffector->steps()[stepId - 1].age;
+					stepChanged = true;
+				}
 
 				widgetName_.format("Scale##%d", stepId);
-				ImGui::SliderFloat2(widgetName_.data(), step.scale.data(), cfg.minParticleScale, cfg.maxParticleScale);
+				stepChanged |= ImGui::SliderFloat2(widgetName_.data(), step.scale.data(), cfg.minParticleScale, cfg.maxParticleScale);
 				widgetName_.format("Age##%d", stepId);
-				ImGui::SliderFloat(widgetName_.data(), &step.age, 0.0f, 1.0f);
+				stepChanged |= ImGui::SliderFloat(widgetName_.data(), &step.age, 0.0f, 1.0f);
+				if (stepChanged)
+				{
+					s.sizeAffector = s.sharedSizeAffector->edit();
+					s.sizeAffector->steps()[stepId] = step;
+				}
 				ImGui::TreePop();
 			}
-			stepId++;
 		}
 
 		if (s.sizeAffector->steps().isEmpty() == false)
@@ -1003,6 +1104,7 @@ void MyEventHandler::createGuiSizeAffector()
 
 			if (ImGui::Button(Labels::Add))
 			{
+				s.sizeAffector = s.sharedSizeAffector->edit();
 				for (int i = static_cast<int>(s.sizeAffector->steps().size()) - 1; i >= -1; i--)
 				{
 					const bool placeNotFound = (i > -1) ? s.sizeAffector->steps()[i].age > s.sizeAge : false;
@@ -1018,10 +1120,16 @@ void MyEventHandler::createGuiSizeAffector()
 			}
 			ImGui::SameLine();
 			if (ImGui::Button(Labels::Remove) && s.sizeAffector->steps().size() > 0)
+			{
+				s.sizeAffector = s.sharedSizeAffector->edit();
 				s.sizeAffector->steps().setSize(s.sizeAffector->steps().size() - 1);
+			}
 			ImGui::SameLine();
 			if (ImGui::Button(Labels::RemoveAll) && s.sizeAffector->steps().size() > 0)
+			{
+				s.sizeAffector = s.sharedSizeAffector->edit();
 				s.sizeAffector->steps().clear();
+			}
 			ImGui::TreePop();
 		}
 	}
@@ -1082,21 +1190,30 @@ void MyEventHandler::createGuiRotationAffector()
 		}
 
 		int stepId = 0;
-		for (nc::RotationAffector::RotationStep &step : s.rotationAffector->steps())
+		for (; stepId < static_cast<int>(s.rotationAffector->steps().size()); stepId++)
 		{
+			nc::RotationAffector::RotationStep step = s.rotationAffector->steps()[stepId];
 			widgetName_.format("Step %d", stepId);
 			if (ImGui::TreeNodeEx(widgetName_.data(), ImGuiTreeNodeFlags_DefaultOpen))
 			{
+				bool stepChanged = false;
 				if (stepId > 0 && step.age < s.rotationAffector->steps()[stepId - 1].age)
+				{
 					step.age = s.rotationAffector->steps()[stepId - 1].age;
+					stepChanged = true;
+				}
 
 				widgetName_.format("Angle##%d", stepId);
-				ImGui::SliderFloat(widgetName_.data(), &step.angle, cfg.minParticleAngle, cfg.maxParticleAngle);
+				stepChanged |= ImGui::SliderFloat(widgetName_.data(), &step.angle, cfg.minParticleAngle, cfg.maxParticleAngle);
 				widgetName_.format("Age##%d", stepId);
-				ImGui::SliderFloat(widgetName_.data(), &step.age, 0.0f, 1.0f);
+				stepChanged |= ImGui::SliderFloat(widgetName_.data(), &step.age, 0.0f, 1.0f);
+				if (stepChanged)
+				{
+					s.rotationAffector = s.sharedRotationAffector->edit();
+					s.rotationAffector->steps()[stepId] = step;
+				}
 				ImGui::TreePop();
 			}
-			stepId++;
 		}
 
 		if (s.rotationAffector->steps().isEmpty() == false)
@@ -1114,6 +1231,7 @@ void MyEventHandler::createGuiRotationAffector()
 
 			if (ImGui::Button(Labels::Add))
 			{
+				s.rotationAffector = s.sharedRotationAffector->edit();
 				for (int i = static_cast<int>(s.rotationAffector->steps().size()) - 1; i >= -1; i--)
 				{
 					const bool placeNotFound = (i > -1) ? s.rotationAffector->steps()[i].age > s.rotAge : false;
@@ -1129,10 +1247,16 @@ void MyEventHandler::createGuiRotationAffector()
 			}
 			ImGui::SameLine();
 			if (ImGui::Button(Labels::Remove) && s.rotationAffector->steps().size() > 0)
+			{
+				s.rotationAffector = s.sharedRotationAffector->edit();
 				s.rotationAffector->steps().setSize(s.rotationAffector->steps().size() - 1);
+			}
 			ImGui::SameLine();
 			if (ImGui::Button(Labels::RemoveAll) && s.rotationAffector->steps().size() > 0)
+			{
+				s.rotationAffector = s.sharedRotationAffector->edit();
 				s.rotationAffector->steps().clear();
+			}
 			ImGui::TreePop();
 		}
 	}
@@ -1186,23 +1310,32 @@ void MyEventHandler::createGuiPositionAffector()
 		}
 
 		int stepId = 0;
-		for (nc::PositionAffector::PositionStep &step : s.positionAffector->steps())
+		for (; stepId < static_cast<int>(s.positionAffector->steps().size()); stepId++)
 		{
+			nc::PositionAffector::PositionStep step = s.positionAffector->steps()[stepId];
 			widgetName_.format("Step %d", stepId);
 			if (ImGui::TreeNodeEx(widgetName_.data(), ImGuiTreeNodeFlags_DefaultOpen))
 			{
+				bool stepChanged = false;
 				if (stepId > 0 && step.age < s.positionAffector->steps()[stepId - 1].age)
+				{
 					step.age = s.positionAffector->steps()[stepId - 1].age;
+					stepChanged = true;
+				}
 
 				widgetName_.format("Position X##%d", stepId);
-				ImGui::SliderFloat(widgetName_.data(), &step.position.x, -cfg.positionRange, cfg.positionRange);
+				stepChanged |= ImGui::SliderFloat(widgetName_.data(), &step.position.x, -cfg.positionRange, cfg.positionRange);
 				widgetName_.format("Position Y##%d", stepId);
-				ImGui::SliderFloat(widgetName_.data(), &step.position.y, -cfg.positionRange, cfg.positionRange);
+				stepChanged |= ImGui::SliderFloat(widgetName_.data(), &step.position.y, -cfg.positionRange, cfg.positionRange);
 				widgetName_.format("Age##%d", stepId);
-				ImGui::SliderFloat(widgetName_.data(), &step.age, 0.0f, 1.0f);
+				stepChanged |= ImGui::SliderFloat(widgetName_.data(), &step.age, 0.0f, 1.0f);
+				if (stepChanged)
+				{
+					s.positionAffector = s.sharedPositionAffector->edit();
+					s.positionAffector->steps()[stepId] = step;
+				}
 				ImGui::TreePop();
 			}
-			stepId++;
 		}
 
 		if (s.positionAffector->steps().isEmpty() == false)
@@ -1222,6 +1355,7 @@ void MyEventHandler::createGuiPositionAffector()
 
 			if (ImGui::Button(Labels::Add))
 			{
+				s.positionAffector = s.sharedPositionAffector->edit();
 				for (int i = static_cast<int>(s.positionAffector->steps().size()) - 1; i >= -1; i--)
 				{
 					const bool placeNotFound = (i > -1) ? s.positionAffector->steps()[i].age > s.positionAge : false;
@@ -1237,10 +1371,16 @@ void MyEventHandler::createGuiPositionAffector()
 			}
 			ImGui::SameLine();
 			if (ImGui::Button(Labels::Remove) && s.positionAffector->steps().size() > 0)
+			{
+				s.positionAffector = s.sharedPositionAffector->edit();
 				s.positionAffector->steps().setSize(s.positionAffector->steps().size() - 1);
+			}
 			ImGui::SameLine();
 			if (ImGui::Button(Labels::RemoveAll) && s.positionAffector->steps().size() > 0)
+			{
+				s.positionAffector = s.sharedPositionAffector->edit();
 				s.positionAffector->steps().clear();
+			}
 			ImGui::TreePop();
 		}
 	}
@@ -1301,23 +1441,32 @@ void MyEventHandler::createGuiVelocityAffector()
 		}
 
 		int stepId = 0;
-		for (nc::VelocityAffector::VelocityStep &step : s.velocityAffector->steps())
+		for (; stepId < static_cast<int>(s.velocityAffector->steps().size()); stepId++)
 		{
+			nc::VelocityAffector::VelocityStep step = s.velocityAffector->steps()[stepId];
 			widgetName_.format("Step %d", stepId);
 			if (ImGui::TreeNodeEx(widgetName_.data(), ImGuiTreeNodeFlags_DefaultOpen))
 			{
+				bool stepChanged = false;
 				if (stepId > 0 && step.age < s.velocityAffector->steps()[stepId - 1].age)
+				{
 					step.age = s.velocityAffector->steps()[stepId - 1].age;
+					stepChanged = true;
+				}
 
 				widgetName_.format("Velocity X##%d", stepId);
-				ImGui::SliderFloat(widgetName_.data(), &step.velocity.x, -cfg.velocityRange, cfg.velocityRange);
+				stepChanged |= ImGui::SliderFloat(widgetName_.data(), &step.velocity.x, -cfg.velocityRange, cfg.velocityRange);
 				widgetName_.format("Velocity Y##%d", stepId);
-				ImGui::SliderFloat(widgetName_.data(), &step.velocity.y, -cfg.velocityRange, cfg.velocityRange);
+				stepChanged |= ImGui::SliderFloat(widgetName_.data(), &step.velocity.y, -cfg.velocityRange, cfg.velocityRange);
 				widgetName_.format("Age##%d", stepId);
-				ImGui::SliderFloat(widgetName_.data(), &step.age, 0.0f, 1.0f);
+				stepChanged |= ImGui::SliderFloat(widgetName_.data(), &step.age, 0.0f, 1.0f);
+				if (stepChanged)
+				{
+					s.velocityAffector = s.sharedVelocityAffector->edit();
+					s.velocityAffector->steps()[stepId] = step;
+				}
 				ImGui::TreePop();
 			}
-			stepId++;
 		}
 
 		if (s.velocityAffector->steps().isEmpty() == false)
@@ -1337,6 +1486,7 @@ void MyEventHandler::createGuiVelocityAffector()
 
 			if (ImGui::Button(Labels::Add))
 			{
+				s.velocityAffector = s.sharedVelocityAffector->edit();
 				for (int i = static_cast<int>(s.velocityAffector->steps().size()) - 1; i >= -1; i--)
 				{
 					const bool placeNotFound = (i > -1) ? s.velocityAffector->steps()[i].age > s.velocityAge : false;
@@ -1352,10 +1502,16 @@ void MyEventHandler::createGuiVelocityAffector()
 			}
 			ImGui::SameLine();
 			if (ImGui::Button(Labels::Remove) && s.velocityAffector->steps().size() > 0)
+			{
+				s.velocityAffector = s.sharedVelocityAffector->edit();
 				s.velocityAffector->steps().setSize(s.velocityAffector->steps().size() - 1);
+			}
 			ImGui::SameLine();
 			if (ImGui::Button(Labels::RemoveAll) && s.velocityAffector->steps().size() > 0)
+			{
+				s.velocityAffector = s.sharedVelocityAffector->edit();
 				s.velocityAffector->steps().clear();
+			}
 			ImGui::TreePop();
 		}
 	}
@@ -1563,10 +1719,74 @@ void MyEventHandler::createGuiEmission()
 		ImGui::PushID("Delay");
 		ImGui::Columns(2);
 		ImGui::SetColumnWidth(0, columnWidth);
-		ImGui::SliderFloat("Delay", &s.emitDelay, 0.0f, cfg.maxDelay, "%.2fs");
+		bool emissionChanged = false;
+		if (s.continuousEmission)
+			emissionChanged |= ImGui::DragFloat("Rate", &s.emissionRate, 1.0f, 0.0f, 10000.0f, "%.1f/s");
+		else
+			emissionChanged |= ImGui::SliderFloat("Delay", &s.emitDelay, 0.0f, cfg.maxDelay, "%.2fs");
 		ImGui::NextColumn();
-		if (ImGui::Button("As life"))
+		if (s.continuousEmission)
+		{
+			// The rate that keeps the whole pool alive in the steady state
+			if (ImGui::Button("As pool"))
+			{
+				const float meanLife = (s.init.rndLife.x + s.init.rndLife.y) * 0.5f;
+				if (meanLife > 0.0f)
+					s.emissionRate = particleSystems_[systemIndex_]->numParticles() / meanLife;
+				emissionChanged = true;
+			}
+		}
+		else if (ImGui::Button("As life"))
+		{
 			s.emitDelay = (s.init.rndLife.x + s.init.rndLife.y) * 0.5f;
+			emissionChanged = true;
+		}
+		ImGui::SameLine();
+		if (ImGui::Checkbox("Continuous", &s.continuousEmission))
+		{
+			s.emissionAccumulator = 0.0f;
+			emissionChanged = true;
+		}
+		if (emissionChanged)
+			scheduleEmission(systemIndex_);
+		ImGui::Columns(1);
+		ImGui::PopID();
+
+		ImGui::Spacing();
+		ImGui::PushID("Prewarm");
+		ImGui::Columns(2);
+		ImGui::SetColumnWidth(0, columnWidth);
+		ImGui::DragFloat("Prewarm", &s.prewarmTime, 0.05f, 0.0f, MaxPrewarmTime, "%.2fs");
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("Seconds of simulation run when the project is loaded");
+		ImGui::NextColumn();
+		// Shows the system as it will look after a load
+		if (ImGui::Button(Labels::Apply))
+		{
+			killParticles(systemIndex_);
+			const nc::TimeStamp startTime = nc::TimeStamp::now();
+			const unsigned int numUpdates = prewarmParticleSystem(systemIndex_);
+			logString_.formatAppend("Prewarmed particle system at index #%u in %.2f ms with %u updates\n", systemIndex_, startTime.millisecondsSince(), numUpdates);
+		}
+		ImGui::Columns(1);
+		ImGui::PopID();
+
+		ImGui::Spacing();
+		ImGui::PushID("Seed");
+		ImGui::Columns(2);
+		ImGui::SetColumnWidth(0, columnWidth);
+		if (ImGui::InputScalar("Seed", ImGuiDataType_U32, &s.randomSeed))
+			s.random.init(s.randomSeed);
+		ImGui::NextColumn();
+		// Restarting the stream repeats the same emissions
+		if (ImGui::Button("Restart"))
+			s.random.init(s.randomSeed);
+		ImGui::SameLine();
+		if (ImGui::Button("New"))
+		{
+			s.randomSeed = newRandomSeed();
+			s.random.init(s.randomSeed);
+		}
 		ImGui::Columns(1);
 		ImGui::PopID();
 	}
@@ -1582,12 +1802,52 @@ void MyEventHandler::createGuiEmission()
 		killParticles();
 	ImGui::SameLine();
 	ImGui::Checkbox("Auto", &autoEmission_);
-	createGuiEmissionPlot();
+	if (autoEmission_)
+	{
+		// The scheduler only looks at the due systems, plus the outdated entries it discards
+		const EmissionScheduler::Statistics &stats = emissionScheduler_.statistics();
+		ImGui::SameLine();
+		ImGui::Text("Due: %u/%u", stats.numDue, particleSystems_.size());
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("Scheduled systems: %u\nDiscarded entries: %u\nHeap size: %u", stats.numScheduled, stats.numStale, stats.heapSize);
+	}
+	ImGui::Text("Updated: %u, skipped: %u idle, %u inactive, %u culled", skipStatistics_.numUpdated,
+	            skipStatistics_.numIdle, skipStatistics_.numInactive, skipStatistics_.numCulled);
+
+	unsigned int aliveParticles = 0;
+	unsigned int totalParticles = 0;
+	for (const nctl::UniquePtr<nc::ParticleSystem> &particleSystem : particleSystems_)
+	{
+		aliveParticles += particleSystem->numAliveParticles();
+		totalParticles += particleSystem->numParticles();
+	}
+	const float frameTime = nc::theApplication().frameTime();
+	ImGui::Text("FPS: %.0f (%.2f ms), alive: %u/%u", (frameTime > 0.0f) ? 1.0f / frameTime : 0.0f, frameTime * 1000.0f, aliveParticles, totalParticles);
+	if (ImGui::IsItemHovered())
+		ImGui::SetTooltip("Frame time distribution, pool usage and update costs are in the performance window (CTRL + 4)");
 
 	if (particleSystems_.size() > 1)
 	{
 		if (ImGui::TreeNode("Particle Systems"))
 		{
+			long int savedBytes = 0;
+			for (unsigned int i = 0; i < particleSystems_.size(); i++)
+				savedBytes += (static_cast<long int>(particleSystems_[i]->numParticles()) - poolAdvice(i).suggestedSize) * ParticleBytes;
+			ImGui::Text("Advised pool sizes would save %.1f KiB", savedBytes / 1024.0f);
+			ImGui::SameLine();
+			if (ImGui::Button("Fit All"))
+			{
+				for (unsigned int i = 0; i < particleSystems_.size(); i++)
+					fitParticleSystem(i);
+			}
+			const unsigned int numCurves = colorCurves_.size() + sizeCurves_.size() + rotationCurves_.size() + positionCurves_.size() + velocityCurves_.size();
+			ImGui::Text("Step curves: %u for %u affectors", numCurves, particleSystems_.size() * 5);
+			if (ImGui::IsItemHovered())
+			{
+				ImGui::SetTooltip("Color: %u\nSize: %u\nRotation: %u\nPosition: %u\nVelocity: %u", colorCurves_.size(),
+				                  sizeCurves_.size(), rotationCurves_.size(), positionCurves_.size(), velocityCurves_.size());
+			}
+
 			for (unsigned int i = 0; i < particleSystems_.size(); i++)
 			{
 				widgetName_ = Labels::Emit;
@@ -1601,13 +1861,17 @@ void MyEventHandler::createGuiEmission()
 					killParticles(i);
 				ImGui::SameLine();
 				widgetName_.format("Active##%u", i);
-				ImGui::Checkbox(widgetName_.data(), &sysStates_[i].active);
+				if (ImGui::Checkbox(widgetName_.data(), &sysStates_[i].active))
+					scheduleEmission(i);
 				ImGui::SameLine();
 				ImGui::Text("#%u", i);
 				ImGui::SameLine();
 				ImGui::Text("Layer: %d", sysStates_[i].layer);
 				ImGui::SameLine();
 				ImGui::Text("Alive: %u/%u", particleSystems_[i]->numAliveParticles(), particleSystems_[i]->numParticles());
+				ImGui::SameLine();
+				const long int systemSavedBytes = (static_cast<long int>(particleSystems_[i]->numParticles()) - sysStates_[i].advice.suggestedSize) * ParticleBytes;
+				ImGui::Text("Advised: %u (%.1f KiB)", sysStates_[i].advice.suggestedSize, systemSavedBytes / 1024.0f);
 				if (sysStates_[i].name.isEmpty() == false)
 				{
 					ImGui::SameLine();
@@ -1689,38 +1953,6 @@ void MyEventHandler::sanitizeParticleInit(nc::ParticleInitializer &init)
 		init.rndRotation.y = 180.0f;
 }
 
-void MyEventHandler::createGuiEmissionPlot()
-{
-	static nc::TimeStamp lastUpdateTime;
-
-	static unsigned int index = 0;
-	static float values[NumPlotValues];
-	static float frameTime = nc::theApplication().frameTime();
-	static unsigned int aliveParticles = 0;
-	static unsigned int totalParticles = 0;
-
-	if (lastUpdateTime.secondsSince() > 0.1f)
-	{
-		frameTime = nc::theApplication().frameTime();
-		aliveParticles = 0;
-		totalParticles = 0;
-		for (nctl::UniquePtr<nc::ParticleSystem> &particleSystem : particleSystems_)
-		{
-			aliveParticles += particleSystem->numAliveParticles();
-			totalParticles += particleSystem->numParticles();
-		}
-		values[index] = aliveParticles;
-		index = (index + 1) % NumPlotValues;
-		lastUpdateTime = nc::TimeStamp::now();
-	}
-
-	ImGui::SameLine();
-	ImGui::Text("FPS: %.0f (%.3fs)", 1.0f / frameTime, frameTime);
-	ImGui::PlotLines("", values, NumPlotValues, 0, nullptr, 0, totalParticles, ImVec2(0.0f, 25.0f));
-	ImGui::SameLine();
-	ImGui::Text("Alive: %u/%u", aliveParticles, totalParticles);
-}
-
 void MyEventHandler::createGuiConfigWindow()
 {
 	if (showConfigWindow_)
@@ -1820,9 +2052,6 @@ void MyEventHandler::createGuiConfigWindow()
 		ImGui::Checkbox("Culling", &cfg.culling);
 
 		ImGui::NewLine();
-		int saveFileSize = cfg.saveFileMaxSize / 1024;
-		ImGui::SliderInt("Savefile Size", &saveFileSize, 0, 128, "%d KB");
-		cfg.saveFileMaxSize = saveFileSize * 1024;
 		int logStringSize = cfg.logMaxSize / 1024;
 		ImGui::SliderInt("Log Size", &logStringSize, 0, 64, "%d KB");
 		cfg.logMaxSize = logStringSize * 1024;
@@ -1900,8 +2129,11 @@ void MyEventHandler::createGuiConfigWindow()
 		if (ImGui::Button(Labels::Load))
 		{
 #ifndef __EMSCRIPTEN__
-			loader_->loadConfig(configFile_.data());
-			logString_.formatAppend("Loaded config file \"%s\"\n", configFile_.data());
+			const nc::TimeStamp loadStartTime = nc::TimeStamp::now();
+			if (loader_->loadConfig(configFile_.data()))
+				logLoadTime(*loader_, configFile_.data(), loadStartTime.millisecondsSince(), false);
+			else
+				logString_.formatAppend("Could not load config file \"%s\"\n", configFile_.data());
 #else
 			if (loader_->localFileLoadConfig.isLoading() == false)
 				loader_->localFileLoadConfig.load(".lua");
@@ -1917,8 +2149,11 @@ void MyEventHandler::createGuiConfigWindow()
 		ImGui::SameLine();
 		if (ImGui::Button(Labels::Reset))
 		{
-			loader_->loadConfig(configFile_.data());
-			logString_.formatAppend("Loaded config file \"%s\"\n", configFile_.data());
+			const nc::TimeStamp loadStartTime = nc::TimeStamp::now();
+			if (loader_->loadConfig(configFile_.data()))
+				logLoadTime(*loader_, configFile_.data(), loadStartTime.millisecondsSince(), false);
+			else
+				logString_.formatAppend("Could not load config file \"%s\"\n", configFile_.data());
 		}
 #endif
 
@@ -1947,6 +2182,138 @@ void MyEventHandler::createGuiLogWindow()
 	}
 }
 
+/*! The statistics of the renderer are not exposed by the engine, the draw calls are estimated from its batching settings */
+void MyEventHandler::createGuiPerformanceWindow()
+{
+	if (showPerformanceWindow_)
+	{
+		const ImVec2 windowSize = ImVec2(450.0f, 500.0f);
+		ImGui::SetNextWindowSize(windowSize, ImGuiCond_FirstUseEver);
+		ImGui::Begin("Performance", &showPerformanceWindow_, 0);
+
+		LuaLoader::Config &cfg = loader_->config();
+		const FrameTimeHistory::Statistics &stats = frameTimes_.computeStatistics();
+		ImGui::Text("FPS: %.0f, frame time: %.2f ms mean, %.2f min, %.2f max", (stats.mean > 0.0f) ? 1000.0f / stats.mean : 0.0f,
+		            stats.mean, stats.min, stats.max);
+		ImGui::Text("Percentiles: %.2f ms p50, %.2f p90, %.2f p99", stats.p50, stats.p90, stats.p99);
+		widgetName_.format("%u frames", stats.numFrames);
+		ImGui::PlotLines("Frame Times", frameTimes_.data(), frameTimes_.size(), frameTimes_.offset(), widgetName_.data(), 0.0f, stats.max, ImVec2(0.0f, PlotHeight));
+		widgetName_.format("%.2f - %.2f ms", stats.min, stats.max);
+		ImGui::PlotHistogram("Distribution", stats.bins, FrameTimeHistory::NumBins, 0, widgetName_.data(), 0.0f, stats.maxBinCount, ImVec2(0.0f, PlotHeight));
+
+		int historyLength = cfg.performanceHistory;
+		ImGui::SliderInt("History", &historyLength, 16, 4096, "%d frames");
+		cfg.performanceHistory = historyLength < 0 ? 0 : historyLength;
+		loader_->sanitizeInitValues();
+		ImGui::SameLine();
+		showHelpMarker("The number of frames kept, it is saved in the config file");
+		ImGui::SameLine();
+		if (ImGui::Button(Labels::Clear))
+			frameTimes_.clear();
+
+		ImGui::Separator();
+		const nc::Application::RenderingSettings &settings = nc::theApplication().renderingSettings();
+		drawCallEstimator_.clear();
+		for (unsigned int i = 0; i < particleSystems_.size(); i++)
+		{
+			const nc::ParticleSystem *particleSystem = particleSystems_[i].get();
+			if (particleSystem->isDrawEnabled() == false)
+				continue;
+
+			const ParticleSystemGuiState &s = sysStates_[i];
+			nc::Recti atlasRect;
+			const nc::Texture *atlasPage = useTextureAtlas_ ? textureAtlas_->remap(s.texture, s.texRect, atlasRect) : nullptr;
+			drawCallEstimator_.add((atlasPage != nullptr) ? atlasPage : s.texture, static_cast<int>(s.blendingPreset), s.layer, particleSystem->numAliveParticles());
+		}
+		const DrawCallEstimator::Estimate estimate = drawCallEstimator_.estimate(settings.batchingEnabled, settings.minBatchSize, settings.maxBatchSize);
+		ImGui::Text("Particle sprites: %u with %u render states", estimate.numSprites, estimate.numGroups);
+		ImGui::Text("Estimated draw calls: %u, %u of them batches", estimate.numDrawCalls, estimate.numBatches);
+		if (ImGui::IsItemHovered())
+		{
+			ImGui::SetTooltip("Sprites with the same texture, blending and layer are batched when they are at least %u, up to %u per batch.\n"
+			                  "Batching is %s, a texture atlas lets systems with different textures share a batch.",
+			                  settings.minBatchSize, settings.maxBatchSize, settings.batchingEnabled ? "enabled" : "disabled");
+		}
+
+		ImGui::Separator();
+		uint64_t totalUpdateTime = 0;
+		unsigned long poolBytes = 0;
+		unsigned long aliveBytes = 0;
+		ImGui::Columns(4);
+		ImGui::Text("System");
+		ImGui::NextColumn();
+		ImGui::Text("Alive / Pool");
+		ImGui::NextColumn();
+		ImGui::Text("Pool Usage");
+		ImGui::NextColumn();
+		ImGui::Text("Update");
+		ImGui::NextColumn();
+		for (unsigned int i = 0; i < particleSystems_.size(); i++)
+		{
+			// Every system is created as a profiled one
+			const ProfiledParticleSystem &particleSystem = static_cast<const ProfiledParticleSystem &>(*particleSystems_[i]);
+			const unsigned int numAlive = particleSystem.numAliveParticles();
+			const unsigned int poolSize = particleSystem.numParticles();
+			totalUpdateTime += particleSystem.updateTime();
+			poolBytes += poolSize * ParticleBytes;
+			aliveBytes += numAlive * ParticleBytes;
+
+			ImGui::Text("#%u: %s", i, sysStates_[i].name.data());
+			ImGui::NextColumn();
+			ImGui::Text("%u / %u", numAlive, poolSize);
+			ImGui::NextColumn();
+			ImGui::ProgressBar((poolSize > 0) ? numAlive / static_cast<float>(poolSize) : 0.0f, ImVec2(-1.0f, 0.0f));
+			ImGui::NextColumn();
+			ImGui::Text("%.3f ms", particleSystem.updateTime() * 1.0e-6f);
+			ImGui::NextColumn();
+		}
+		ImGui::Columns(1);
+		ImGui::Text("Total update: %.3f ms", totalUpdateTime * 1.0e-6f);
+
+		ImGui::Separator();
+		unsigned long textureBytes = 0;
+		for (unsigned int i = 0; i < textures_->size(); i++)
+			textureBytes += textures_->texture(i)->dataSize();
+		unsigned long atlasBytes = 0;
+		for (unsigned int i = 0; i < textureAtlas_->numPages(); i++)
+			atlasBytes += textureAtlas_->page(i)->dataSize();
+		const unsigned long backgroundBytes = (backgroundTexture_ != nullptr) ? backgroundTexture_->dataSize() : 0;
+		const unsigned int numCurves = colorCurves_.size() + sizeCurves_.size() + rotationCurves_.size() + positionCurves_.size() + velocityCurves_.size();
+
+		ImGui::Text("Particle pools: %.1f KB, %.1f KB in use", poolBytes / 1024.0f, aliveBytes / 1024.0f);
+		ImGui::Text("Textures: %.1f KB in %u textures, %.1f KB in %u atlas pages", textureBytes / 1024.0f, textures_->size(),
+		            atlasBytes / 1024.0f, textureAtlas_->numPages());
+		ImGui::Text("Background image: %.1f KB", backgroundBytes / 1024.0f);
+		ImGui::Text("Step curves: %u for %u affectors", numCurves, particleSystems_.size() * 5);
+		ImGui::Text("Log: %.1f KB, frame history: %.1f KB", logString_.capacity() / 1024.0f, frameTimes_.length() * 2 * sizeof(float) / 1024.0f);
+#ifdef WITH_PROFILER
+		const FrameProfiler &profiler = theFrameProfiler();
+		ImGui::Text("Profiler: %u / %u events, %.1f KB", profiler.size(), profiler.capacity(), profiler.capacity() * sizeof(FrameProfiler::Event) / 1024.0f);
+#endif
+
+		ImGui::End();
+	}
+}
+
+void MyEventHandler::createGuiLoadingProgress()
+{
+	ProjectLoadJob &job = *projectLoadJob_;
+	ImGui::Text("Loading \"%s\"", job.filename().data());
+
+	if (job.status() == ProjectLoadJob::Status::RUNNING)
+	{
+		widgetName_.format("Reading files (%.0f%%)", job.progress() * 100.0f);
+		ImGui::ProgressBar(job.progress(), ImVec2(-1.0f, 0.0f), widgetName_.data());
+	}
+	else
+	{
+		const unsigned int numTextures = job.textures().size();
+		const float fraction = (numTextures > 0) ? job.numCommittedTextures() / static_cast<float>(numTextures) : 1.0f;
+		widgetName_.format("Creating textures (%u / %u)", job.numCommittedTextures(), numTextures);
+		ImGui::ProgressBar(fraction, ImVec2(-1.0f, 0.0f), widgetName_.data());
+	}
+}
+
 void MyEventHandler::applyGuiStyleConfig()
 {
 	const LuaLoader::Config &cfg = loader_->config();
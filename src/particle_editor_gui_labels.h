@@ -17,10 +17,12 @@
 #define TEXT_MENU_FILE_OPENBUNDLED "Open Bundled"
 #define TEXT_MENU_FILE_SAVE "Save"
 #define TEXT_MENU_FILE_SAVEAS "Save as..."
+#define TEXT_MENU_FILE_SAVETRACE "Save Trace"
 #define TEXT_MENU_FILE_QUIT "Quit"
 #define TEXT_MENU_VIEW_MAIN "Main"
 #define TEXT_MENU_VIEW_CONFIG "Config"
 #define TEXT_MENU_VIEW_LOG "Log"
+#define TEXT_MENU_VIEW_PERFORMANCE "Performance"
 #define TEXT_MENU_ABOUT "About"
 
 #define TEXT_HEADER_BACKGROUND "Background"
@@ -67,10 +69,12 @@ namespace Labels {
 	static const char *OpenBundled = TEXT_MENU_FILE_OPENBUNDLED;
 	static const char *Save = TEXT_MENU_FILE_SAVE;
 	static const char *SaveAs = TEXT_MENU_FILE_SAVEAS;
+	static const char *SaveTrace = TEXT_MENU_FILE_SAVETRACE;
 	static const char *Quit = TEXT_MENU_FILE_QUIT;
 	static const char *Main = TEXT_MENU_VIEW_MAIN;
 	static const char *Config = TEXT_MENU_VIEW_CONFIG;
 	static const char *Log = TEXT_MENU_VIEW_LOG;
+	static const char *Performance = TEXT_MENU_VIEW_PERFORMANCE;
 	static const char *About = TEXT_MENU_ABOUT;
 
 	static const char *Background = TEXT_HEADER_BACKGROUND;
@@ -119,10 +123,12 @@ namespace Labels {
 	static const char *OpenBundled = ICON_FA_FOLDER_OPEN FA5_SPACING TEXT_MENU_FILE_OPENBUNDLED;
 	static const char *Save = ICON_FA_SAVE FA5_SPACING TEXT_MENU_FILE_SAVE;
 	static const char *SaveAs = ICON_FA_SAVE FA5_SPACING TEXT_MENU_FILE_SAVEAS;
+	static const char *SaveTrace = ICON_FA_STOPWATCH FA5_SPACING TEXT_MENU_FILE_SAVETRACE;
 	static const char *Quit = ICON_FA_POWER_OFF FA5_SPACING TEXT_MENU_FILE_QUIT;
 	static const char *Main = ICON_FA_WINDOW_MAXIMIZE FA5_SPACING TEXT_MENU_VIEW_MAIN;
 	static const char *Config = ICON_FA_TOOLS FA5_SPACING TEXT_MENU_VIEW_CONFIG;
 	static const char *Log = ICON_FA_CLIPBOARD_LIST FA5_SPACING TEXT_MENU_VIEW_LOG;
+	static const char *Performance = ICON_FA_CHART_BAR FA5_SPACING TEXT_MENU_VIEW_PERFORMANCE;
 	static const char *About = ICON_FA_INFO_CIRCLE FA5_SPACING TEXT_MENU_ABOUT;
 
 	static const char *Background = ICON_FA_PALETTE FA5_SPACING TEXT_HEADER_BACKGROUND;
@@ -0,0 +1,22 @@
+#ifndef HASHMAP_CAPACITY
+#define HASHMAP_CAPACITY
+
+namespace HashMaps {
+
+/// Doubles the capacity of a map until the specified number of elements would fill at most half of it
+/*! Hash maps use open addressing, keeping the load factor low avoids long probing sequences.
+ *  Maps that index the same elements in different ways should be reserved together, so they rehash at once. */
+template <class Map>
+void reserve(Map &map, unsigned int numElements)
+{
+	unsigned int capacity = (map.capacity() > 0) ? map.capacity() : 1;
+	while (numElements * 2 > capacity)
+		capacity *= 2;
+
+	if (capacity > map.capacity())
+		map.rehash(capacity);
+}
+
+}
+
+#endif
@@ -0,0 +1,146 @@
+#include "particle_editor_jobpool.h"
+
+///////////////////////////////////////////////////////////
+// CONSTRUCTORS and DESTRUCTOR
+///////////////////////////////////////////////////////////
+
+JobPool::JobPool(unsigned int numThreads)
+    : numThreads_(1), numStolenJobs_(0), function_(nullptr), userData_(nullptr)
+#if NCINE_WITH_THREADS
+      , batch_(0), numBusyWorkers_(0), quit_(false)
+#endif
+{
+#if NCINE_WITH_THREADS
+	numThreads_ = numThreads;
+	if (numThreads_ > MaxThreads)
+		numThreads_ = MaxThreads;
+	if (numThreads_ == 0)
+		numThreads_ = 1;
+
+	for (unsigned int i = 0; i < numThreads_ - 1; i++)
+	{
+		workers_[i].pool = this;
+		workers_[i].index = i + 1;
+		workers_[i].thread.run(workerFunction, &workers_[i]);
+	}
+#endif
+}
+
+JobPool::~JobPool()
+{
+#if NCINE_WITH_THREADS
+	mutex_.lock();
+	quit_ = true;
+	wakeCondition_.broadcast();
+	mutex_.unlock();
+
+	for (unsigned int i = 0; i < numThreads_ - 1; i++)
+		workers_[i].thread.join();
+#endif
+}
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+unsigned int JobPool::defaultNumThreads()
+{
+#if NCINE_WITH_THREADS
+	const unsigned int numProcessors = nc::Thread::numProcessors();
+	if (numProcessors == 0)
+		return 1;
+	return (numProcessors < MaxThreads) ? numProcessors : MaxThreads;
+#else
+	return 1;
+#endif
+}
+
+void JobPool::run(JobFunction function, void *userData, unsigned int numJobs)
+{
+	if (numJobs == 0)
+		return;
+
+	function_ = function;
+	userData_ = userData;
+	numStolenJobs_.store(0);
+	for (unsigned int i = 0; i < numThreads_; i++)
+	{
+		ranges_[i].next.store(static_cast<int32_t>(static_cast<unsigned long>(numJobs) * i / numThreads_));
+		ranges_[i].end = static_cast<int32_t>(static_cast<unsigned long>(numJobs) * (i + 1) / numThreads_);
+	}
+
+#if NCINE_WITH_THREADS
+	if (numThreads_ > 1)
+	{
+		mutex_.lock();
+		numBusyWorkers_ = numThreads_ - 1;
+		batch_++;
+		wakeCondition_.broadcast();
+		mutex_.unlock();
+	}
+#endif
+
+	work(0);
+
+#if NCINE_WITH_THREADS
+	if (numThreads_ > 1)
+	{
+		mutex_.lock();
+		while (numBusyWorkers_ > 0)
+			doneCondition_.wait(mutex_);
+		mutex_.unlock();
+	}
+#endif
+}
+
+///////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+///////////////////////////////////////////////////////////
+
+#if NCINE_WITH_THREADS
+void JobPool::workerFunction(void *arg)
+{
+	Worker *worker = static_cast<Worker *>(arg);
+	JobPool &pool = *worker->pool;
+
+	unsigned int lastBatch = 0;
+	pool.mutex_.lock();
+	while (true)
+	{
+		while (pool.batch_ == lastBatch && pool.quit_ == false)
+			pool.wakeCondition_.wait(pool.mutex_);
+		if (pool.quit_)
+			break;
+		lastBatch = pool.batch_;
+		pool.mutex_.unlock();
+
+		pool.work(worker->index);
+
+		pool.mutex_.lock();
+		pool.numBusyWorkers_--;
+		if (pool.numBusyWorkers_ == 0)
+			pool.doneCondition_.signal();
+	}
+	pool.mutex_.unlock();
+}
+#endif
+
+void JobPool::work(unsigned int threadIndex)
+{
+	unsigned int numStolenJobs = 0;
+	for (unsigned int i = 0; i < numThreads_; i++)
+	{
+		Range &range = ranges_[(threadIndex + i) % numThreads_];
+		int32_t index = range.next.fetchAdd(1);
+		while (index < range.end)
+		{
+			function_(userData_, static_cast<unsigned int>(index));
+			if (i > 0)
+				numStolenJobs++;
+			index = range.next.fetchAdd(1);
+		}
+	}
+
+	if (numStolenJobs > 0)
+		numStolenJobs_.fetchAdd(static_cast<int32_t>(numStolenJobs));
+}
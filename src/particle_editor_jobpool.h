@@ -0,0 +1,84 @@
+#ifndef CLASS_JOBPOOL
+#define CLASS_JOBPOOL
+
+#include <ncine/config.h>
+#include <nctl/Atomic.h>
+
+#if NCINE_WITH_THREADS
+	#include <ncine/Thread.h>
+	#include <ncine/ThreadSync.h>
+
+namespace nc = ncine;
+#endif
+
+/// A fixed set of worker threads that run batches of independent jobs
+/*! The jobs of a batch are split in one contiguous range per thread. A thread that finishes
+ *  its own range takes the remaining jobs of the other ranges, one at a time. The thread that
+ *  calls `run()` works as well. When threads are not available every job runs in `run()`. */
+class JobPool
+{
+  public:
+	typedef void (*JobFunction)(void *userData, unsigned int jobIndex);
+
+	static const unsigned int MaxThreads = 64;
+
+	/// Creates the workers, the thread calling `run()` counts as one of the `numThreads`
+	explicit JobPool(unsigned int numThreads);
+	~JobPool();
+
+	/// Returns the number of processors, clamped to the maximum number of threads
+	static unsigned int defaultNumThreads();
+
+	inline unsigned int numThreads() const { return numThreads_; }
+	/// Returns the number of jobs of the last batch run by a thread other than the one owning their range
+	inline unsigned int numStolenJobs() const { return static_cast<unsigned int>(numStolenJobs_.load()); }
+
+	/// Calls the function once for every index from zero to `numJobs`, returning when all calls are done
+	void run(JobFunction function, void *userData, unsigned int numJobs);
+
+  private:
+	/// The range of jobs initially assigned to a thread, padded to avoid sharing cache lines
+	struct Range
+	{
+		nctl::Atomic32 next;
+		int32_t end = 0;
+		char padding[64 - sizeof(nctl::Atomic32) - sizeof(int32_t)];
+	};
+
+	unsigned int numThreads_;
+	Range ranges_[MaxThreads];
+	mutable nctl::Atomic32 numStolenJobs_;
+
+	JobFunction function_;
+	void *userData_;
+
+#if NCINE_WITH_THREADS
+	struct Worker
+	{
+		JobPool *pool = nullptr;
+		unsigned int index = 0;
+		nc::Thread thread;
+	};
+
+	Worker workers_[MaxThreads - 1];
+	nc::Mutex mutex_;
+	nc::CondVariable wakeCondition_;
+	nc::CondVariable doneCondition_;
+	/// Incremented for every batch, workers compare it with the last one they have seen
+	unsigned int batch_;
+	unsigned int numBusyWorkers_;
+	bool quit_;
+
+	static void workerFunction(void *arg);
+#endif
+
+	/// Runs the jobs of its own range, then the ones left in the other ranges
+	void work(unsigned int threadIndex);
+
+	/// Deleted copy constructor
+	JobPool(const JobPool &) = delete;
+	/// Deleted assignment operator
+	JobPool &operator=(const JobPool &) = delete;
+};
+
+#endif
@@ -0,0 +1,231 @@
+#include "particle_editor_loadjob.h"
+#include <ncine/FileSystem.h>
+#include <ncine/IFile.h>
+
+///////////////////////////////////////////////////////////
+// CONSTRUCTORS and DESTRUCTOR
+///////////////////////////////////////////////////////////
+
+ProjectLoadJob::ProjectLoadJob()
+    : textures_(4), numCommittedTextures_(0), numReaderThreads_(1), texturesReadTime_(0.0f),
+      status_(static_cast<int32_t>(Status::IDLE)), numSteps_(1), numStepsDone_(0), nextTexture_(0)
+#if NCINE_WITH_THREADS
+      , threadRunning_(false)
+#endif
+#ifdef __EMSCRIPTEN__
+      , localFile_(nullptr)
+#endif
+{
+}
+
+ProjectLoadJob::~ProjectLoadJob()
+{
+	reset();
+}
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+bool ProjectLoadJob::start(const char *filename, const char *projectName, const char *texturesPath)
+#ifdef __EMSCRIPTEN__
+{
+	return start(filename, projectName, texturesPath, nullptr);
+}
+
+bool ProjectLoadJob::start(const char *filename, const char *projectName, const char *texturesPath, const nc::EmscriptenLocalFile *localFile)
+#endif
+{
+	if (isActive())
+		return false;
+
+	filename_ = filename;
+	projectName_ = (projectName != nullptr) ? projectName : "";
+	texturesPath_ = texturesPath;
+	numCommittedTextures_ = 0;
+	numSteps_.store(1);
+	numStepsDone_.store(0);
+	numReaderThreads_ = 1;
+	texturesReadTime_ = 0.0f;
+	startTime_ = nc::TimeStamp::now();
+	status_.store(static_cast<int32_t>(Status::RUNNING));
+
+#ifdef __EMSCRIPTEN__
+	// The local file data is only valid during the loaded callback
+	localFile_ = localFile;
+	if (localFile_ != nullptr)
+	{
+		run();
+		localFile_ = nullptr;
+		return true;
+	}
+#endif
+
+#if NCINE_WITH_THREADS
+	loader_.createState();
+	threadRunning_ = true;
+	thread_.run(threadFunction, this);
+#else
+	run();
+#endif
+
+	return true;
+}
+
+float ProjectLoadJob::progress() const
+{
+	const int32_t numSteps = numSteps_.load();
+	return (numSteps > 0) ? numStepsDone_.load() / static_cast<float>(numSteps) : 0.0f;
+}
+
+float ProjectLoadJob::texturesSerialReadTime() const
+{
+	float readTime = 0.0f;
+	for (const TextureFile &texture : textures_)
+		readTime += texture.readTime;
+	return readTime;
+}
+
+bool ProjectLoadJob::texturesRead() const
+{
+	for (const TextureFile &texture : textures_)
+	{
+		if (texture.buffer.get() == nullptr || texture.size == 0)
+			return false;
+	}
+	return true;
+}
+
+void ProjectLoadJob::reset()
+{
+#if NCINE_WITH_THREADS
+	if (threadRunning_)
+	{
+		thread_.join();
+		threadRunning_ = false;
+	}
+#endif
+
+	state_.systems.clear();
+	textures_.clear();
+	numCommittedTextures_ = 0;
+	status_.store(static_cast<int32_t>(Status::IDLE));
+}
+
+///////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+///////////////////////////////////////////////////////////
+
+#if NCINE_WITH_THREADS
+void ProjectLoadJob::threadFunction(void *arg)
+{
+	ProjectLoadJob *job = static_cast<ProjectLoadJob *>(arg);
+	job->run();
+}
+
+void ProjectLoadJob::readerThreadFunction(void *arg)
+{
+	ProjectLoadJob *job = static_cast<ProjectLoadJob *>(arg);
+	job->readTextures();
+}
+#endif
+
+void ProjectLoadJob::run()
+{
+	state_.systems.clear();
+#ifndef __EMSCRIPTEN__
+	const bool loaded = loader_.load(filename_.data(), state_);
+#else
+	const bool loaded = loader_.load(filename_.data(), state_, localFile_);
+#endif
+	if (loaded == false || state_.systems.isEmpty())
+	{
+		status_.store(static_cast<int32_t>(Status::FAILED));
+		return;
+	}
+
+	collectTextures();
+	numSteps_.store(static_cast<int32_t>(textures_.size() + 1));
+	numStepsDone_.store(1);
+
+	// Every texture has its own slot, the commit order does not depend on which thread reads it first
+	const nc::TimeStamp readStartTime = nc::TimeStamp::now();
+	nextTexture_.store(0);
+#if NCINE_WITH_THREADS
+	numReaderThreads_ = nc::Thread::numProcessors();
+	if (numReaderThreads_ > MaxReaderThreads)
+		numReaderThreads_ = MaxReaderThreads;
+	if (numReaderThreads_ > textures_.size())
+		numReaderThreads_ = textures_.size();
+	if (numReaderThreads_ == 0)
+		numReaderThreads_ = 1;
+
+	// The job thread reads textures as well
+	nc::Thread readerThreads[MaxReaderThreads - 1];
+	for (unsigned int i = 0; i < numReaderThreads_ - 1; i++)
+		readerThreads[i].run(readerThreadFunction, this);
+	readTextures();
+	for (unsigned int i = 0; i < numReaderThreads_ - 1; i++)
+		readerThreads[i].join();
+#else
+	readTextures();
+#endif
+	texturesReadTime_ = readStartTime.millisecondsSince();
+
+	status_.store(static_cast<int32_t>(Status::LOADED));
+}
+
+/*! Textures are ordered by their first use, like when they were created one system at a time */
+void ProjectLoadJob::collectTextures()
+{
+	textures_.clear();
+	for (const LuaLoader::State::ParticleSystem &system : state_.systems)
+	{
+		bool found = false;
+		for (const TextureFile &texture : textures_)
+		{
+			if (texture.name == system.textureName)
+			{
+				found = true;
+				break;
+			}
+		}
+
+		if (found == false)
+		{
+			textures_.emplaceBack();
+			textures_.back().name = system.textureName;
+		}
+	}
+}
+
+void ProjectLoadJob::readTextures()
+{
+	const int32_t numTextures = static_cast<int32_t>(textures_.size());
+	int32_t index = nextTexture_.fetchAdd(1);
+	while (index < numTextures)
+	{
+		readTexture(textures_[index]);
+		numStepsDone_.fetchAdd(1);
+		index = nextTexture_.fetchAdd(1);
+	}
+}
+
+void ProjectLoadJob::readTexture(TextureFile &texture)
+{
+	const nc::TimeStamp readStartTime = nc::TimeStamp::now();
+	texture.path = texture.name;
+	if (nc::fs::isReadableFile(texture.path.data()) == false)
+		texture.path = nc::fs::joinPath(texturesPath_, texture.name);
+
+	nctl::UniquePtr<nc::IFile> fileHandle = nc::IFile::createFileHandle(texture.path.data());
+	fileHandle->open(nc::IFile::OpenMode::READ | nc::IFile::OpenMode::BINARY);
+	if (fileHandle->isOpened())
+	{
+		const unsigned long fileSize = fileHandle->size();
+		texture.buffer = nctl::makeUnique<unsigned char[]>(fileSize);
+		texture.size = fileHandle->read(texture.buffer.get(), fileSize);
+		fileHandle->close();
+	}
+	texture.readTime = readStartTime.millisecondsSince();
+}
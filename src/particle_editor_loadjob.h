@@ -0,0 +1,122 @@
+#ifndef CLASS_PROJECTLOADJOB
+#define CLASS_PROJECTLOADJOB
+
+#include <ncine/config.h>
+#include <nctl/Atomic.h>
+#include <ncine/TimeStamp.h>
+#include "particle_editor_lua.h"
+
+#if NCINE_WITH_THREADS
+	#include <ncine/Thread.h>
+#endif
+
+/// Loads a project file and reads the textures it references on a worker thread
+/*! The worker fills the loader state and the texture file buffers. The main thread
+ *  then creates the textures and the particle systems, as they need the graphics context.
+ *  When threads are not available the job runs synchronously inside `start()`. */
+class ProjectLoadJob
+{
+  public:
+	/// Maximum number of threads that read texture files in parallel
+	static const unsigned int MaxReaderThreads = 8;
+
+	enum class Status
+	{
+		IDLE,
+		RUNNING,
+		LOADED,
+		FAILED
+	};
+
+	struct TextureFile
+	{
+		nctl::String name = nctl::String(LuaLoader::MaxFilenameLength);
+		nctl::String path = nctl::String(LuaLoader::MaxFilenameLength);
+		nctl::UniquePtr<unsigned char[]> buffer;
+		unsigned long size = 0;
+		/// Time spent reading the file, in milliseconds
+		float readTime = 0.0f;
+	};
+
+	ProjectLoadJob();
+	~ProjectLoadJob();
+
+	/// Starts loading a project, textures not found as they are named are searched in `texturesPath`
+	/*! The project name is the one the editor will use once the project is loaded, it can be null. */
+	bool start(const char *filename, const char *projectName, const char *texturesPath);
+#ifdef __EMSCRIPTEN__
+	bool start(const char *filename, const char *projectName, const char *texturesPath, const nc::EmscriptenLocalFile *localFile);
+#endif
+
+	inline Status status() const { return static_cast<Status>(status_.load()); }
+	/// Returns true from the start of the job until the main thread resets it
+	inline bool isActive() const { return status() != Status::IDLE; }
+	/// Returns the progress of the worker thread, reading the project counts as one step
+	float progress() const;
+
+	inline const nctl::String &filename() const { return filename_; }
+	inline const nctl::String &projectName() const { return projectName_; }
+	inline const LuaLoader &loader() const { return loader_; }
+	inline LuaLoader::State &state() { return state_; }
+	inline nctl::Array<TextureFile> &textures() { return textures_; }
+	/// Returns true if the files of all the textures have been read
+	bool texturesRead() const;
+
+	/// Returns the index of the first texture that has not been created yet by the main thread
+	inline unsigned int numCommittedTextures() const { return numCommittedTextures_; }
+	inline void textureCommitted() { numCommittedTextures_++; }
+
+	/// Returns the time since the start of the job, in milliseconds
+	inline float elapsedTime() const { return startTime_.millisecondsSince(); }
+
+	inline unsigned int numReaderThreads() const { return numReaderThreads_; }
+	/// Returns the wall-clock time spent reading all texture files, in milliseconds
+	inline float texturesReadTime() const { return texturesReadTime_; }
+	/// Returns the sum of the single texture reading times, in milliseconds
+	float texturesSerialReadTime() const;
+
+	/// Waits for the worker thread and releases all the loaded data
+	void reset();
+
+  private:
+	LuaLoader loader_;
+	nctl::String filename_ = nctl::String(LuaLoader::MaxFilenameLength);
+	nctl::String projectName_ = nctl::String(LuaLoader::MaxFilenameLength);
+	nctl::String texturesPath_ = nctl::String(LuaLoader::MaxFilenameLength);
+	LuaLoader::State state_;
+	nctl::Array<TextureFile> textures_;
+	unsigned int numCommittedTextures_;
+	nc::TimeStamp startTime_;
+	unsigned int numReaderThreads_;
+	float texturesReadTime_;
+
+	mutable nctl::Atomic32 status_;
+	mutable nctl::Atomic32 numSteps_;
+	mutable nctl::Atomic32 numStepsDone_;
+	nctl::Atomic32 nextTexture_;
+
+#if NCINE_WITH_THREADS
+	nc::Thread thread_;
+	bool threadRunning_;
+
+	static void threadFunction(void *arg);
+	static void readerThreadFunction(void *arg);
+#endif
+
+#ifdef __EMSCRIPTEN__
+	const nc::EmscriptenLocalFile *localFile_;
+#endif
+
+	void run();
+	void collectTextures();
+	/// Reads textures until none is left, it is run by every reader thread
+	void readTextures();
+	void readTexture(TextureFile &texture);
+
+	/// Deleted copy constructor
+	ProjectLoadJob(const ProjectLoadJob &) = delete;
+	/// Deleted assignment operator
+	ProjectLoadJob &operator=(const ProjectLoadJob &) = delete;
+};
+
+#endif
@@ -1,11 +1,18 @@
 #include "particle_editor_lua.h"
+#include "particle_editor_float.h"
+#include "particle_editor_names.h"
+#include "particle_editor_parser.h"
+#include "particle_editor_random.h"
+#include "particle_editor_writer.h"
 #include <ncine/Colorf.h>
 #include <ncine/LuaStateManager.h>
 #include <ncine/LuaUtils.h>
 #include <ncine/LuaRectUtils.h>
 #include <ncine/LuaVector2Utils.h>
 #include <ncine/LuaColorfUtils.h>
+#include <ncine/FileSystem.h>
 #include <ncine/IFile.h>
+#include <ncine/TimeStamp.h>
 
 ///////////////////////////////////////////////////////////
 // PUBLIC FUNCTIONS
@@ -13,72 +20,17 @@
 
 namespace {
 
-nctl::String &indent(nctl::String &string, int amount)
+BufferedWriter &indent(BufferedWriter &writer, int amount)
 {
 	FATAL_ASSERT(amount >= 0);
 	for (int i = 0; i < amount; i++)
-		string.append("\t");
+		writer.append("\t");
 
-	return string;
+	return writer;
 }
 
-const unsigned int ProjectFileVersion = 8;
-const unsigned int ConfigFileVersion = 11;
-
-namespace Names {
-
-	const char *version = "project_version"; // version 3
-
-	const char *normalizedAbsPosition = "normalized_absolute_position"; // version 2
-	const char *particleSystems = "particle_systems";
-	const char *backgroundProperties = "background_properties"; // version 4
-	const char *backgroundColor = "background_color"; // version 4
-	const char *backgroundImage = "background_image"; // version 4
-	const char *backgroundImageNormalizedPosition = "background_image_normalized_position"; // version 4
-	const char *backgroundImageScale = "background_image_scale"; // version 4, becomes a vector in version 7
-	const char *backgroundImageLayer = "background_image_layer"; // version 4
-	const char *backgroundImageColor = "background_image_color"; // version 5
-	const char *backgroundImageRect = "background_image_rect"; // version 5
-	const char *backgroundImageFlippedX = "background_image_flipped_x"; // version 7
-	const char *backgroundImageFlippedY = "background_image_flipped_y"; // version 7
-
-	const char *name = "name"; // version 3
-	const char *numParticles = "num_particles";
-	const char *texture = "texture";
-	const char *texRext = "texture_rect";
-	const char *anchorPoint = "anchor_point"; // version 6
-	const char *flippedX = "flipped_x"; // version 7
-	const char *flippedY = "flipped_y"; // version 7
-	const char *blendingPreset = "blending_preset"; // version 8
-	const char *disabledBlending = "disabled"; // version 8
-	const char *alphaBlending = "alpha"; // version 8
-	const char *premultipliedAlphaBlending = "premultiplied_alpha"; // version 8
-	const char *additiveBlending = "additive"; // version 8
-	const char *multiplyBlending = "multiply"; // version 8
-	const char *relativePosition = "relative_position";
-	const char *layer = "layer";
-	const char *inLocalSpace = "local_space";
-	const char *active = "active";
-
-	const char *colorSteps = "color_steps";
-	const char *sizeSteps = "size_steps";
-	const char *baseScale = "base_scale"; // becomes a vector in version 7
-	const char *rotationSteps = "rotation_steps";
-	const char *positionSteps = "position_steps";
-	const char *velocitySteps = "velocity_steps";
-
-	const char *emission = "emission";
-	const char *amount = "amount";
-	const char *life = "life";
-	const char *positionX = "position_x";
-	const char *positionY = "position_y";
-	const char *velocityX = "velocity_x";
-	const char *velocityY = "velocity_y";
-	const char *rotation = "rotation";
-	const char *emitterRotation = "emitter_rotation";
-	const char *delay = "delay";
-
-}
+const unsigned int ProjectFileVersion = 11;
+const unsigned int ConfigFileVersion = 13;
 
 namespace CfgNames {
 
@@ -94,10 +46,10 @@ namespace CfgNames {
 	const char *vsync = "vsync"; // version 9
 	const char *batching = "batching";
 	const char *culling = "culling";
-	const char *saveFileMaxSize = "savefile_maxsize"; // version 3
 	const char *logMaxSize = "log_maxsize"; // version 5
 	const char *startupScriptName = "startup_script_name"; // version 11
 	const char *autoEmissionOnStart = "auto_emission_on_start"; // version 11
+	const char *performanceHistory = "performance_history"; // version 13
 
 	const char *scriptsPath = "scripts_path"; // version 6
 	const char *backgroundsPath = "backgrounds_path"; // version 6
@@ -146,10 +98,13 @@ void LuaLoader::sanitizeInitValues()
 	if (config_.iboSize < 32 * 1024)
 		config_.iboSize = 32 * 1024;
 
-	if (config_.saveFileMaxSize < 8 * 1024)
-		config_.saveFileMaxSize = 8 * 1024;
 	if (config_.logMaxSize < 4 * 1024)
 		config_.logMaxSize = 4 * 1024;
+
+	if (config_.performanceHistory < 16)
+		config_.performanceHistory = 16;
+	else if (config_.performanceHistory > 4096)
+		config_.performanceHistory = 4096;
 }
 
 void LuaLoader::sanitizeGuiLimits()
@@ -208,7 +163,7 @@ bool LuaLoader::loadConfig(const char *filename)
 bool LuaLoader::loadConfig(const char *filename, const nc::EmscriptenLocalFile *localFile)
 #endif
 {
-	createNewState();
+	prepareState();
 #ifndef __EMSCRIPTEN__
 	if (luaState_->runFromFile(filename) == false)
 #else
@@ -244,8 +199,7 @@ bool LuaLoader::loadConfig(const char *filename, const nc::EmscriptenLocalFile *
 	if (version >= 8)
 		nc::LuaUtils::tryRetrieveGlobal<bool>(L, CfgNames::resizable, config_.resizable);
 
-	if (version >= 3)
-		nc::LuaUtils::tryRetrieveGlobal<uint32_t>(L, CfgNames::saveFileMaxSize, config_.saveFileMaxSize);
+	// The save file maximum size has been removed in version 12 as project files are streamed to disk
 
 	if (version >= 5)
 		nc::LuaUtils::tryRetrieveGlobal<uint32_t>(L, CfgNames::logMaxSize, config_.logMaxSize);
@@ -256,6 +210,9 @@ bool LuaLoader::loadConfig(const char *filename, const nc::EmscriptenLocalFile *
 		nc::LuaUtils::tryRetrieveGlobal<bool>(L, CfgNames::autoEmissionOnStart, config_.autoEmissionOnStart);
 	}
 
+	if (version >= 13)
+		nc::LuaUtils::tryRetrieveGlobal<uint32_t>(L, CfgNames::performanceHistory, config_.performanceHistory);
+
 	config_.scriptsPath = "scripts/";
 	config_.texturesPath = "textures/";
 	config_.backgroundsPath = "backgrounds/";
@@ -318,7 +275,9 @@ bool LuaLoader::saveConfig(const char *filename)
 	sanitizeInitValues();
 	sanitizeGuiLimits();
 
-	nctl::String file(4096);
+	BufferedWriter file(filename);
+	if (file.isOpened() == false)
+		return false;
 	int amount = 0;
 
 	indent(file, amount).formatAppend("%s = %u\n", CfgNames::version, ConfigFileVersion);
@@ -333,10 +292,10 @@ bool LuaLoader::saveConfig(const char *filename)
 	indent(file, amount).formatAppend("%s = %s\n", CfgNames::vsync, config_.vsync ? "true" : "false");
 	indent(file, amount).formatAppend("%s = %s\n", CfgNames::batching, config_.batching ? "true" : "false");
 	indent(file, amount).formatAppend("%s = %s\n", CfgNames::culling, config_.culling ? "true" : "false");
-	indent(file, amount).formatAppend("%s = %u\n", CfgNames::saveFileMaxSize, config_.saveFileMaxSize);
 	indent(file, amount).formatAppend("%s = %u\n", CfgNames::logMaxSize, config_.logMaxSize);
 	indent(file, amount).formatAppend("%s = \"%s\"\n", CfgNames::startupScriptName, config_.startupScriptName.data());
 	indent(file, amount).formatAppend("%s = %s\n", CfgNames::autoEmissionOnStart, config_.autoEmissionOnStart ? "true" : "false");
+	indent(file, amount).formatAppend("%s = %u\n", CfgNames::performanceHistory, config_.performanceHistory);
 
 	indent(file, amount).formatAppend("%s = \"%s\"\n", CfgNames::scriptsPath, config_.scriptsPath.data());
 	indent(file, amount).formatAppend("%s = \"%s\"\n", CfgNames::texturesPath, config_.texturesPath.data());
@@ -347,20 +306,20 @@ bool LuaLoader::saveConfig(const char *filename)
 	indent(file, amount).append("{\n");
 	amount++;
 
-	indent(file, amount).formatAppend("%s = %f,\n", CfgNames::maxBackgroundImageScale, config_.maxBackgroundImageScale);
+	indent(file, amount).formatAppend("%s = %s,\n", CfgNames::maxBackgroundImageScale, FloatString(config_.maxBackgroundImageScale).data());
 	indent(file, amount).formatAppend("%s = %d,\n", CfgNames::maxRenderingLayer, config_.maxRenderingLayer);
 	indent(file, amount).formatAppend("%s = %d,\n", CfgNames::maxNumParticles, config_.maxNumParticles);
-	indent(file, amount).formatAppend("%s = %f,\n", CfgNames::systemPositionRange, config_.systemPositionRange);
-	indent(file, amount).formatAppend("%s = %f,\n", CfgNames::minParticleScale, config_.minParticleScale);
-	indent(file, amount).formatAppend("%s = %f,\n", CfgNames::maxParticleScale, config_.maxParticleScale);
-	indent(file, amount).formatAppend("%s = %f,\n", CfgNames::minParticleAngle, config_.minParticleAngle);
-	indent(file, amount).formatAppend("%s = %f,\n", CfgNames::maxParticleAngle, config_.maxParticleAngle);
-	indent(file, amount).formatAppend("%s = %f,\n", CfgNames::positionRange, config_.positionRange);
-	indent(file, amount).formatAppend("%s = %f,\n", CfgNames::velocityRange, config_.velocityRange);
-	indent(file, amount).formatAppend("%s = %f,\n", CfgNames::maxRandomLife, config_.maxRandomLife);
-	indent(file, amount).formatAppend("%s = %f,\n", CfgNames::randomPositionRange, config_.randomPositionRange);
-	indent(file, amount).formatAppend("%s = %f,\n", CfgNames::randomVelocityRange, config_.randomVelocityRange);
-	indent(file, amount).formatAppend("%s = %f\n", CfgNames::maxDelay, config_.maxDelay);
+	indent(file, amount).formatAppend("%s = %s,\n", CfgNames::systemPositionRange, FloatString(config_.systemPositionRange).data());
+	indent(file, amount).formatAppend("%s = %s,\n", CfgNames::minParticleScale, FloatString(config_.minParticleScale).data());
+	indent(file, amount).formatAppend("%s = %s,\n", CfgNames::maxParticleScale, FloatString(config_.maxParticleScale).data());
+	indent(file, amount).formatAppend("%s = %s,\n", CfgNames::minParticleAngle, FloatString(config_.minParticleAngle).data());
+	indent(file, amount).formatAppend("%s = %s,\n", CfgNames::maxParticleAngle, FloatString(config_.maxParticleAngle).data());
+	indent(file, amount).formatAppend("%s = %s,\n", CfgNames::positionRange, FloatString(config_.positionRange).data());
+	indent(file, amount).formatAppend("%s = %s,\n", CfgNames::velocityRange, FloatString(config_.velocityRange).data());
+	indent(file, amount).formatAppend("%s = %s,\n", CfgNames::maxRandomLife, FloatString(config_.maxRandomLife).data());
+	indent(file, amount).formatAppend("%s = %s,\n", CfgNames::randomPositionRange, FloatString(config_.randomPositionRange).data());
+	indent(file, amount).formatAppend("%s = %s,\n", CfgNames::randomVelocityRange, FloatString(config_.randomVelocityRange).data());
+	indent(file, amount).formatAppend("%s = %s\n", CfgNames::maxDelay, FloatString(config_.maxDelay).data());
 
 	amount--;
 	indent(file, amount).append("}\n");
@@ -371,27 +330,16 @@ bool LuaLoader::saveConfig(const char *filename)
 	amount++;
 
 	indent(file, amount).formatAppend("%s = %d,\n", CfgNames::styleIndex, config_.styleIndex);
-	indent(file, amount).formatAppend("%s = %f,\n", CfgNames::frameRounding, config_.frameRounding);
+	indent(file, amount).formatAppend("%s = %s,\n", CfgNames::frameRounding, FloatString(config_.frameRounding).data());
 	indent(file, amount).formatAppend("%s = %s,\n", CfgNames::windowBorder, config_.windowBorder ? "true" : "false");
 	indent(file, amount).formatAppend("%s = %s,\n", CfgNames::frameBorder, config_.frameBorder ? "true" : "false");
 	indent(file, amount).formatAppend("%s = %s,\n", CfgNames::popupBorder, config_.popupBorder ? "true" : "false");
-	indent(file, amount).formatAppend("%s = %f\n", CfgNames::scaling, config_.scaling);
+	indent(file, amount).formatAppend("%s = %s\n", CfgNames::scaling, FloatString(config_.scaling).data());
 
 	amount--;
 	indent(file, amount).append("}\n");
 
-#ifndef __EMSCRIPTEN__
-	nctl::UniquePtr<nc::IFile> fileHandle = nc::IFile::createFileHandle(filename);
-	fileHandle->open(nc::IFile::OpenMode::WRITE | nc::IFile::OpenMode::BINARY);
-	fileHandle->write(file.data(), file.length());
-	fileHandle->close();
-#else
-	nc::EmscriptenLocalFile localFileSave;
-	localFileSave.write(file.data(), file.length());
-	localFileSave.save(filename);
-#endif
-
-	return true;
+	return file.close();
 }
 
 bool LuaLoader::load(const char *filename, State &state)
@@ -403,16 +351,41 @@ bool LuaLoader::load(const char *filename, State &state)
 bool LuaLoader::load(const char *filename, State &state, const nc::EmscriptenLocalFile *localFile)
 #endif
 {
-	createNewState();
-#ifndef __EMSCRIPTEN__
-	if (luaState_->runFromFile(filename) == false)
-#else
-	const bool loaded = (localFile != nullptr)
-	                        ? luaState_->runFromMemory(localFile->filename(), localFile->data(), localFile->size())
-	                        : luaState_->runFromFile(filename);
-
-	if (loaded == false)
+	// The file is read only once and shared between the binary loader, the parser and Lua
+	nctl::UniquePtr<char[]> fileBuffer;
+	const char *buffer = nullptr;
+	unsigned long bufferSize = 0;
+#ifdef __EMSCRIPTEN__
+	if (localFile != nullptr)
+	{
+		buffer = localFile->data();
+		bufferSize = localFile->size();
+	}
+	else
 #endif
+	{
+		bufferSize = readFile(filename, fileBuffer);
+		buffer = fileBuffer.get();
+	}
+	if (buffer == nullptr)
+		return false;
+
+	if (isBinaryProject(filename))
+	{
+		statistics_.lastLoadMethod = LoadMethod::BINARY;
+		return loadBinary(buffer, bufferSize, state);
+	}
+
+	// Files written by `save()` do not need a Lua state to be loaded
+	statistics_.lastLoadMethod = LoadMethod::PARSER;
+	ProjectParser parser(buffer, bufferSize);
+	if (parser.parse(state))
+		return true;
+	state.systems.clear();
+
+	statistics_.lastLoadMethod = LoadMethod::LUA;
+	prepareState();
+	if (luaState_->runFromMemory(filename, buffer, bufferSize) == false)
 		return false;
 	lua_State *L = luaState_->state();
 
@@ -644,6 +617,19 @@ bool LuaLoader::load(const char *filename, State &state, const nc::EmscriptenLoc
 		s.init.rndRotation = nc::LuaVector2fUtils::retrieveArrayField(L, -1, Names::rotation);
 		s.init.emitterRotation = nc::LuaUtils::retrieveField<bool>(L, -1, Names::emitterRotation);
 		s.emitDelay = nc::LuaUtils::retrieveField<float>(L, -1, Names::delay);
+		s.randomSeed = CounterRandom::defaultSeed(state.systems.size());
+		if (version >= 9)
+			nc::LuaUtils::tryRetrieveField<uint32_t>(L, -1, Names::randomSeed, s.randomSeed);
+		s.continuousEmission = false;
+		s.emissionRate = 60.0f;
+		if (version >= 10)
+		{
+			nc::LuaUtils::tryRetrieveField<bool>(L, -1, Names::continuous, s.continuousEmission);
+			nc::LuaUtils::tryRetrieveField<float>(L, -1, Names::rate, s.emissionRate);
+		}
+		s.prewarmTime = 0.0f;
+		if (version >= 11)
+			nc::LuaUtils::tryRetrieveField<float>(L, -1, Names::prewarm, s.prewarmTime);
 		nc::LuaUtils::pop(L);
 
 		state.systems.pushBack(s);
@@ -653,13 +639,18 @@ bool LuaLoader::load(const char *filename, State &state, const nc::EmscriptenLoc
 	return true;
 }
 
-void LuaLoader::save(const char *filename, const State &state)
+bool LuaLoader::save(const char *filename, const State &state)
 {
-	nctl::String file(config_.saveFileMaxSize);
+	if (isBinaryProject(filename))
+		return saveBinary(filename, state);
+
+	BufferedWriter file(filename);
+	if (file.isOpened() == false)
+		return false;
 	int amount = 0;
 
 	indent(file, amount).formatAppend("%s = %u\n", Names::version, ProjectFileVersion);
-	indent(file, amount).formatAppend("%s = {x = %f, y = %f}\n", Names::normalizedAbsPosition, state.normalizedAbsPosition.x, state.normalizedAbsPosition.y);
+	indent(file, amount).formatAppend("%s = {x = %s, y = %s}\n", Names::normalizedAbsPosition, FloatString(state.normalizedAbsPosition.x).data(), FloatString(state.normalizedAbsPosition.y).data());
 	file.append("\n");
 
 	indent(file, amount).formatAppend("%s =\n", Names::backgroundProperties);
@@ -667,14 +658,14 @@ void LuaLoader::save(const char *filename, const State &state)
 	amount++;
 
 	const nc::Colorf &bgColor = state.background.color;
-	indent(file, amount).formatAppend("%s = {r = %f, g = %f, b = %f, a = %f},\n", Names::backgroundColor, bgColor.r(), bgColor.g(), bgColor.b(), 1.0f);
+	indent(file, amount).formatAppend("%s = {r = %s, g = %s, b = %s, a = %s},\n", Names::backgroundColor, FloatString(bgColor.r()).data(), FloatString(bgColor.g()).data(), FloatString(bgColor.b()).data(), FloatString(1.0f).data());
 	indent(file, amount).formatAppend("%s = \"%s\",\n", Names::backgroundImage, state.background.imageName.data());
-	indent(file, amount).formatAppend("%s = {x = %f, y = %f},\n", Names::backgroundImageNormalizedPosition,
-	                                  state.background.imageNormalizedPosition.x, state.background.imageNormalizedPosition.y);
-	indent(file, amount).formatAppend("%s = {x = %f, y = %f},\n", Names::backgroundImageScale, state.background.imageScale.x, state.background.imageScale.y);
+	indent(file, amount).formatAppend("%s = {x = %s, y = %s},\n", Names::backgroundImageNormalizedPosition,
+	                                  FloatString(state.background.imageNormalizedPosition.x).data(), FloatString(state.background.imageNormalizedPosition.y).data());
+	indent(file, amount).formatAppend("%s = {x = %s, y = %s},\n", Names::backgroundImageScale, FloatString(state.background.imageScale.x).data(), FloatString(state.background.imageScale.y).data());
 	indent(file, amount).formatAppend("%s = %d,\n", Names::backgroundImageLayer, state.background.imageLayer);
 	const nc::Colorf &imgColor = state.background.imageColor;
-	indent(file, amount).formatAppend("%s = {r = %f, g = %f, b = %f, a = %f},\n", Names::backgroundImageColor, imgColor.r(), imgColor.g(), imgColor.b(), imgColor.a());
+	indent(file, amount).formatAppend("%s = {r = %s, g = %s, b = %s, a = %s},\n", Names::backgroundImageColor, FloatString(imgColor.r()).data(), FloatString(imgColor.g()).data(), FloatString(imgColor.b()).data(), FloatString(imgColor.a()).data());
 	indent(file, amount).formatAppend("%s = {x = %d, y = %d, w = %d, h = %d},\n", Names::backgroundImageRect,
 	                                  state.background.imageRect.x, state.background.imageRect.y, state.background.imageRect.w, state.background.imageRect.h);
 	indent(file, amount).formatAppend("%s = %s,\n", Names::backgroundImageFlippedX, state.background.imageFlippedX ? "true" : "false");
@@ -700,7 +691,7 @@ void LuaLoader::save(const char *filename, const State &state)
 		indent(file, amount).formatAppend("%s = \"%s\",\n", Names::texture, sysState.textureName.data());
 		indent(file, amount).formatAppend("%s = {x = %d, y = %d, w = %d, h = %d},\n", Names::texRext,
 		                                  sysState.texRect.x, sysState.texRect.y, sysState.texRect.w, sysState.texRect.h);
-		indent(file, amount).formatAppend("%s = {x = %f, y = %f},\n", Names::anchorPoint, sysState.anchorPoint.x, sysState.anchorPoint.y);
+		indent(file, amount).formatAppend("%s = {x = %s, y = %s},\n", Names::anchorPoint, FloatString(sysState.anchorPoint.x).data(), FloatString(sysState.anchorPoint.y).data());
 		indent(file, amount).formatAppend("%s = %s,\n", Names::flippedX, sysState.flippedX ? "true" : "false");
 		indent(file, amount).formatAppend("%s = %s,\n", Names::flippedY, sysState.flippedY ? "true" : "false");
 
@@ -726,7 +717,7 @@ void LuaLoader::save(const char *filename, const State &state)
 		}
 		indent(file, amount).formatAppend("%s = \"%s\",\n", Names::blendingPreset, blendingPresetName.data());
 
-		indent(file, amount).formatAppend("%s = {x = %f, y = %f},\n", Names::relativePosition, sysState.position.x, sysState.position.y);
+		indent(file, amount).formatAppend("%s = {x = %s, y = %s},\n", Names::relativePosition, FloatString(sysState.position.x).data(), FloatString(sysState.position.y).data());
 		indent(file, amount).formatAppend("%s = %d,\n", Names::layer, sysState.layer);
 		indent(file, amount).formatAppend("%s = %s,\n", Names::inLocalSpace, sysState.inLocalSpace ? "true" : "false");
 		indent(file, amount).formatAppend("%s = %s,\n", Names::active, sysState.active ? "true" : "false");
@@ -742,8 +733,8 @@ void LuaLoader::save(const char *filename, const State &state)
 				const State::ColorStep &step = sysState.colorSteps[i];
 				const bool isLastStep = (i == sysState.colorSteps.size() - 1);
 				indent(file, amount);
-				file.formatAppend("{%f, {r = %f, g = %f, b = %f, a = %f}}%s\n",
-				                  step.age, step.color.r(), step.color.g(), step.color.b(), step.color.a(), isLastStep ? "" : ",");
+				file.formatAppend("{%s, {r = %s, g = %s, b = %s, a = %s}}%s\n",
+				                  FloatString(step.age).data(), FloatString(step.color.r()).data(), FloatString(step.color.g()).data(), FloatString(step.color.b()).data(), FloatString(step.color.a()).data(), isLastStep ? "" : ",");
 			}
 			amount--;
 			indent(file, amount).append("},\n");
@@ -755,13 +746,13 @@ void LuaLoader::save(const char *filename, const State &state)
 			indent(file, amount).formatAppend("%s =\n", Names::sizeSteps);
 			indent(file, amount).append("{\n");
 			amount++;
-			indent(file, amount).formatAppend("%s = {x = %f, y = %f},\n", Names::baseScale, sysState.sizeStepBaseScale.x, sysState.sizeStepBaseScale.y);
+			indent(file, amount).formatAppend("%s = {x = %s, y = %s},\n", Names::baseScale, FloatString(sysState.sizeStepBaseScale.x).data(), FloatString(sysState.sizeStepBaseScale.y).data());
 			for (unsigned int i = 0; i < sysState.sizeSteps.size(); i++)
 			{
 				const State::SizeStep &step = sysState.sizeSteps[i];
 				const bool isLastStep = (i == sysState.sizeSteps.size() - 1);
 				indent(file, amount);
-				file.formatAppend("{%f, {x = %f, y = %f}}%s\n", step.age, step.scale.x, step.scale.y, isLastStep ? "" : ",");
+				file.formatAppend("{%s, {x = %s, y = %s}}%s\n", FloatString(step.age).data(), FloatString(step.scale.x).data(), FloatString(step.scale.y).data(), isLastStep ? "" : ",");
 			}
 			amount--;
 			indent(file, amount).append("},\n");
@@ -778,7 +769,7 @@ void LuaLoader::save(const char *filename, const State &state)
 				const State::RotationStep &step = sysState.rotationSteps[i];
 				const bool isLastStep = (i == sysState.rotationSteps.size() - 1);
 				indent(file, amount);
-				file.formatAppend("{%f, %f}%s\n", step.age, step.angle, isLastStep ? "" : ",");
+				file.formatAppend("{%s, %s}%s\n", FloatString(step.age).data(), FloatString(step.angle).data(), isLastStep ? "" : ",");
 			}
 			amount--;
 			indent(file, amount).append("},\n");
@@ -795,7 +786,7 @@ void LuaLoader::save(const char *filename, const State &state)
 				const State::PositionStep &step = sysState.positionSteps[i];
 				const bool isLastStep = (i == sysState.positionSteps.size() - 1);
 				indent(file, amount);
-				file.formatAppend("{%f, {x = %f, y = %f}}%s\n", step.age, step.position.x, step.position.y, isLastStep ? "" : ",");
+				file.formatAppend("{%s, {x = %s, y = %s}}%s\n", FloatString(step.age).data(), FloatString(step.position.x).data(), FloatString(step.position.y).data(), isLastStep ? "" : ",");
 			}
 			amount--;
 			indent(file, amount).append("},\n");
@@ -812,7 +803,7 @@ void LuaLoader::save(const char *filename, const State &state)
 				const State::VelocityStep &step = sysState.velocitySteps[i];
 				const bool isLastStep = (i == sysState.velocitySteps.size() - 1);
 				indent(file, amount);
-				file.formatAppend("{%f, {x = %f, y = %f}}%s\n", step.age, step.velocity.x, step.velocity.y, isLastStep ? "" : ",");
+				file.formatAppend("{%s, {x = %s, y = %s}}%s\n", FloatString(step.age).data(), FloatString(step.velocity.x).data(), FloatString(step.velocity.y).data(), isLastStep ? "" : ",");
 			}
 			amount--;
 			indent(file, amount).append("},\n");
@@ -823,14 +814,18 @@ void LuaLoader::save(const char *filename, const State &state)
 		indent(file, amount).append("{\n");
 		amount++;
 		indent(file, amount).formatAppend("%s = {%d, %d},\n", Names::amount, sysState.init.rndAmount.x, sysState.init.rndAmount.y);
-		indent(file, amount).formatAppend("%s = {%f, %f},\n", Names::life, sysState.init.rndLife.x, sysState.init.rndLife.y);
-		indent(file, amount).formatAppend("%s = {%f, %f},\n", Names::positionX, sysState.init.rndPositionX.x, sysState.init.rndPositionX.y);
-		indent(file, amount).formatAppend("%s = {%f, %f},\n", Names::positionY, sysState.init.rndPositionY.x, sysState.init.rndPositionY.y);
-		indent(file, amount).formatAppend("%s = {%f, %f},\n", Names::velocityX, sysState.init.rndVelocityX.x, sysState.init.rndVelocityX.y);
-		indent(file, amount).formatAppend("%s = {%f, %f},\n", Names::velocityY, sysState.init.rndVelocityY.x, sysState.init.rndVelocityY.y);
-		indent(file, amount).formatAppend("%s = {%f, %f},\n", Names::rotation, sysState.init.rndRotation.x, sysState.init.rndRotation.y);
+		indent(file, amount).formatAppend("%s = {%s, %s},\n", Names::life, FloatString(sysState.init.rndLife.x).data(), FloatString(sysState.init.rndLife.y).data());
+		indent(file, amount).formatAppend("%s = {%s, %s},\n", Names::positionX, FloatString(sysState.init.rndPositionX.x).data(), FloatString(sysState.init.rndPositionX.y).data());
+		indent(file, amount).formatAppend("%s = {%s, %s},\n", Names::positionY, FloatString(sysState.init.rndPositionY.x).data(), FloatString(sysState.init.rndPositionY.y).data());
+		indent(file, amount).formatAppend("%s = {%s, %s},\n", Names::velocityX, FloatString(sysState.init.rndVelocityX.x).data(), FloatString(sysState.init.rndVelocityX.y).data());
+		indent(file, amount).formatAppend("%s = {%s, %s},\n", Names::velocityY, FloatString(sysState.init.rndVelocityY.x).data(), FloatString(sysState.init.rndVelocityY.y).data());
+		indent(file, amount).formatAppend("%s = {%s, %s},\n", Names::rotation, FloatString(sysState.init.rndRotation.x).data(), FloatString(sysState.init.rndRotation.y).data());
 		indent(file, amount).formatAppend("%s = %s,\n", Names::emitterRotation, sysState.init.emitterRotation ? "true" : "false");
-		indent(file, amount).formatAppend("%s = %f\n", Names::delay, sysState.emitDelay);
+		indent(file, amount).formatAppend("%s = %s,\n", Names::delay, FloatString(sysState.emitDelay).data());
+		indent(file, amount).formatAppend("%s = %u,\n", Names::randomSeed, sysState.randomSeed);
+		indent(file, amount).formatAppend("%s = %s,\n", Names::continuous, sysState.continuousEmission ? "true" : "false");
+		indent(file, amount).formatAppend("%s = %s,\n", Names::rate, FloatString(sysState.emissionRate).data());
+		indent(file, amount).formatAppend("%s = %s\n", Names::prewarm, FloatString(sysState.prewarmTime).data());
 		amount--;
 		indent(file, amount).append("}\n");
 
@@ -840,26 +835,71 @@ void LuaLoader::save(const char *filename, const State &state)
 	amount--;
 	indent(file, amount).append("}\n");
 
-#ifndef __EMSCRIPTEN__
-	nctl::UniquePtr<nc::IFile> fileHandle = nc::IFile::createFileHandle(filename);
-	fileHandle->open(nc::IFile::OpenMode::WRITE | nc::IFile::OpenMode::BINARY);
-	fileHandle->write(file.data(), file.length());
-	fileHandle->close();
-#else
-	nc::EmscriptenLocalFile localFileSave;
-	localFileSave.write(file.data(), file.length());
-	localFileSave.save(filename);
-#endif
+	return file.close();
+}
+
+void LuaLoader::createState()
+{
+	if (luaState_ == nullptr)
+		prepareState();
+}
+
+bool LuaLoader::isBinaryProject(const char *filename)
+{
+	return nc::fs::hasExtension(filename, BinaryExtension);
 }
 
 ///////////////////////////////////////////////////////////
 // PRIVATE FUNCTIONS
 ///////////////////////////////////////////////////////////
 
-void LuaLoader::createNewState()
+void LuaLoader::prepareState()
 {
-	luaState_ = nctl::makeUnique<nc::LuaStateManager>(
-	    nc::LuaStateManager::ApiType::NONE,
-	    nc::LuaStateManager::StatisticsTracking::DISABLED,
-	    nc::LuaStateManager::StandardLibraries::NOT_LOADED);
+	const nc::TimeStamp startTime = nc::TimeStamp::now();
+
+	if (luaState_ == nullptr)
+	{
+		luaState_ = nctl::makeUnique<nc::LuaStateManager>(
+		    nc::LuaStateManager::ApiType::NONE,
+		    nc::LuaStateManager::StatisticsTracking::DISABLED,
+		    nc::LuaStateManager::StandardLibraries::NOT_LOADED);
+		statistics_.numStatesCreated++;
+		statistics_.lastStateCreated = true;
+	}
+	else
+	{
+		// No libraries are loaded in the state, every global has been set by a previous script
+		lua_State *L = luaState_->state();
+		lua_settop(L, 0);
+		lua_pushglobaltable(L);
+		lua_pushnil(L);
+		while (lua_next(L, -2) != 0)
+		{
+			lua_pop(L, 1); // value
+			lua_pushvalue(L, -1); // key
+			lua_pushnil(L);
+			lua_rawset(L, -4); // existing fields can be cleared while traversing
+		}
+		lua_pop(L, 1); // global table
+		lua_gc(L, LUA_GCCOLLECT, 0);
+		statistics_.numStateResets++;
+		statistics_.lastStateCreated = false;
+	}
+
+	statistics_.lastStateTime = startTime.millisecondsSince();
+}
+
+unsigned long LuaLoader::readFile(const char *filename, nctl::UniquePtr<char[]> &buffer)
+{
+	nctl::UniquePtr<nc::IFile> fileHandle = nc::IFile::createFileHandle(filename);
+	fileHandle->open(nc::IFile::OpenMode::READ | nc::IFile::OpenMode::BINARY);
+	if (fileHandle->isOpened() == false)
+		return 0;
+
+	const unsigned long fileSize = fileHandle->size();
+	buffer = nctl::makeUnique<char[]>(fileSize);
+	const unsigned long bytesRead = fileHandle->read(buffer.get(), fileSize);
+	fileHandle->close();
+
+	return bytesRead;
 }
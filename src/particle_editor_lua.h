@@ -13,6 +13,7 @@
 #include <ncine/ParticleAffectors.h>
 #include <ncine/ParticleInitializer.h>
 #include <ncine/LuaStateManager.h>
+#include "particle_editor_lut.h"
 
 #ifdef __EMSCRIPTEN__
 	#include <ncine/EmscriptenLocalFile.h>
@@ -33,6 +34,8 @@ class LuaLoader
 {
   public:
 	static const unsigned int MaxFilenameLength = 256;
+	/// The extension that selects the binary project format
+	static const char *BinaryExtension;
 
 	struct State
 	{
@@ -66,6 +69,16 @@ class LuaLoader
 			nc::Vector2f velocity;
 		};
 
+		/// The affector steps sampled at a fixed resolution, size values include the base scale
+		struct CurveLuts
+		{
+			CurveLut color;
+			CurveLut size;
+			CurveLut rotation;
+			CurveLut position;
+			CurveLut velocity;
+		};
+
 		struct ParticleSystem
 		{
 			nctl::String name = nctl::String(MaxFilenameLength);
@@ -88,6 +101,15 @@ class LuaLoader
 			nctl::Array<VelocityStep> velocitySteps;
 			nc::ParticleInitializer init;
 			float emitDelay;
+			/// The seed of the random stream used by every emission of the system
+			uint32_t randomSeed;
+			/// Emits `emissionRate` particles per second instead of a burst after every delay
+			bool continuousEmission;
+			float emissionRate;
+			/// Seconds of simulation run when the project is loaded
+			float prewarmTime;
+			/// Only filled by binary projects, they are baked again from the steps on every save
+			CurveLuts luts;
 		};
 
 		struct BackgroundProperties
@@ -121,10 +143,12 @@ class LuaLoader
 		bool vsync = true;
 		bool batching = true;
 		bool culling = true;
-		unsigned int saveFileMaxSize = 8 * 1024;
 		unsigned int logMaxSize = 4 * 1024;
 		nctl::String startupScriptName = nctl::String(MaxFilenameLength);
 		bool autoEmissionOnStart = false;
+		static const unsigned int DefaultPerformanceHistory = 300;
+		/// Number of frames in the history of the performance window
+		unsigned int performanceHistory = DefaultPerformanceHistory;
 
 		nctl::String scriptsPath = nctl::String(MaxFilenameLength);
 		nctl::String texturesPath = nctl::String(MaxFilenameLength);
@@ -157,6 +181,26 @@ class LuaLoader
 #endif
 	};
 
+	/// How the last project file has been loaded
+	enum class LoadMethod
+	{
+		BINARY,
+		PARSER,
+		LUA
+	};
+
+	/// Counters about the Lua state, which is reused between loads
+	struct Statistics
+	{
+		unsigned int numStatesCreated = 0;
+		unsigned int numStateResets = 0;
+		/// Whether the state has been created or reset by the last load
+		bool lastStateCreated = false;
+		/// Time spent to create or reset the state in the last load, in milliseconds
+		float lastStateTime = 0.0f;
+		LoadMethod lastLoadMethod = LoadMethod::LUA;
+	};
+
 #ifdef __EMSCRIPTEN__
 	nc::EmscriptenLocalFile localFileLoad;
 	nc::EmscriptenLocalFile localFileLoadConfig;
@@ -164,6 +208,7 @@ class LuaLoader
 
 	inline const Config &config() const { return config_; }
 	inline Config &config() { return config_; }
+	inline const Statistics &statistics() const { return statistics_; }
 	void sanitizeInitValues();
 	void sanitizeGuiLimits();
 	void sanitizeGuiStyle();
@@ -176,13 +221,26 @@ class LuaLoader
 #ifdef __EMSCRIPTEN__
 	bool load(const char *filename, State &state, const nc::EmscriptenLocalFile *localFile);
 #endif
-	void save(const char *filename, const State &state);
+	/// Returns false if the file could not be opened or not all of it could be written
+	bool save(const char *filename, const State &state);
+	/// Creates the Lua state in advance, as states should not be created by more threads at the same time
+	void createState();
+
+	static bool isBinaryProject(const char *filename);
 
   private:
 	nctl::UniquePtr<nc::LuaStateManager> luaState_;
 	Config config_;
+	Statistics statistics_;
+
+	/// Creates the Lua state the first time, then clears the globals of the previous script
+	void prepareState();
+
+	/// Reads the whole file in a newly allocated buffer and returns its size
+	static unsigned long readFile(const char *filename, nctl::UniquePtr<char[]> &buffer);
 
-	void createNewState();
+	bool loadBinary(const char *buffer, unsigned long bufferSize, State &state);
+	bool saveBinary(const char *filename, const State &state);
 };
 
 #endif
@@ -0,0 +1,59 @@
+#include "particle_editor_lut.h"
+
+///////////////////////////////////////////////////////////
+// CONSTRUCTORS and DESTRUCTOR
+///////////////////////////////////////////////////////////
+
+CurveLut::CurveLut()
+    : numComponents_(0)
+{
+}
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+void CurveLut::clear()
+{
+	numComponents_ = 0;
+	values_.clear();
+}
+
+void CurveLut::setNumComponents(unsigned int numComponents)
+{
+	numComponents_ = numComponents;
+	values_.clear();
+	if (values_.capacity() < numComponents * Resolution)
+		values_.setCapacity(numComponents * Resolution);
+	values_.setSize(numComponents * Resolution);
+}
+
+void CurveLut::bake(const float *ages, const float *values, unsigned int numSteps, unsigned int numComponents)
+{
+	if (numSteps == 0)
+	{
+		clear();
+		return;
+	}
+
+	setNumComponents(numComponents);
+	// Samples are visited in order of age, the current step only moves forward
+	unsigned int step = 0;
+	for (unsigned int i = 0; i < Resolution; i++)
+	{
+		const float age = i / static_cast<float>(Resolution - 1);
+		while (step + 1 < numSteps && ages[step + 1] <= age)
+			step++;
+
+		float factor = 0.0f;
+		if (step + 1 < numSteps && age > ages[step])
+			factor = (age - ages[step]) / (ages[step + 1] - ages[step]);
+
+		for (unsigned int c = 0; c < numComponents; c++)
+		{
+			const float *componentValues = values + c * numSteps;
+			const float nextValue = (step + 1 < numSteps) ? componentValues[step + 1] : componentValues[step];
+			values_[c * Resolution + i] = componentValues[step] + (nextValue - componentValues[step]) * factor;
+		}
+	}
+}
@@ -0,0 +1,44 @@
+#ifndef CLASS_CURVELUT
+#define CLASS_CURVELUT
+
+#include <nctl/Array.h>
+
+/// The steps of an affector sampled at a fixed resolution over the normalized age
+/*! Evaluating the curve is a single indexed load per component, instead of a search
+ *  for the surrounding steps and an interpolation between them. */
+class CurveLut
+{
+  public:
+	/// Number of samples of every component, from age zero to age one
+	static const unsigned int Resolution = 256;
+
+	CurveLut();
+
+	inline bool isEmpty() const { return numComponents_ == 0; }
+	inline unsigned int numComponents() const { return numComponents_; }
+	inline const float *data(unsigned int component) const { return values_.data() + component * Resolution; }
+	inline float *data(unsigned int component) { return values_.data() + component * Resolution; }
+
+	/// Returns the index of the sample nearest to a normalized age, ages outside the range are clamped
+	static inline unsigned int index(float normalizedAge)
+	{
+		if (normalizedAge > 0.0f)
+			return (normalizedAge < 1.0f) ? static_cast<unsigned int>(normalizedAge * (Resolution - 1) + 0.5f) : Resolution - 1;
+		return 0;
+	}
+	inline float evaluate(unsigned int component, float normalizedAge) const { return data(component)[index(normalizedAge)]; }
+
+	void clear();
+	/// Allocates the samples of the specified number of components, to be filled by the caller
+	void setNumComponents(unsigned int numComponents);
+	/// Samples steps sorted by age, `values` holds the first component of every step, then the second one and so on
+	/*! Before the first step and after the last one the curve is constant, like in the engine affectors */
+	void bake(const float *ages, const float *values, unsigned int numSteps, unsigned int numComponents);
+
+  private:
+	unsigned int numComponents_;
+	/// The samples of the first component, followed by the ones of the second component and so on
+	nctl::Array<float> values_;
+};
+
+#endif
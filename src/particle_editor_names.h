@@ -0,0 +1,64 @@
+#ifndef PROJECT_NAMES
+#define PROJECT_NAMES
+
+/// The names of the variables and fields used in project files
+namespace Names {
+
+	const char *const version = "project_version"; // version 3
+
+	const char *const normalizedAbsPosition = "normalized_absolute_position"; // version 2
+	const char *const particleSystems = "particle_systems";
+	const char *const backgroundProperties = "background_properties"; // version 4
+	const char *const backgroundColor = "background_color"; // version 4
+	const char *const backgroundImage = "background_image"; // version 4
+	const char *const backgroundImageNormalizedPosition = "background_image_normalized_position"; // version 4
+	const char *const backgroundImageScale = "background_image_scale"; // version 4, becomes a vector in version 7
+	const char *const backgroundImageLayer = "background_image_layer"; // version 4
+	const char *const backgroundImageColor = "background_image_color"; // version 5
+	const char *const backgroundImageRect = "background_image_rect"; // version 5
+	const char *const backgroundImageFlippedX = "background_image_flipped_x"; // version 7
+	const char *const backgroundImageFlippedY = "background_image_flipped_y"; // version 7
+
+	const char *const name = "name"; // version 3
+	const char *const numParticles = "num_particles";
+	const char *const texture = "texture";
+	const char *const texRext = "texture_rect";
+	const char *const anchorPoint = "anchor_point"; // version 6
+	const char *const flippedX = "flipped_x"; // version 7
+	const char *const flippedY = "flipped_y"; // version 7
+	const char *const blendingPreset = "blending_preset"; // version 8
+	const char *const disabledBlending = "disabled"; // version 8
+	const char *const alphaBlending = "alpha"; // version 8
+	const char *const premultipliedAlphaBlending = "premultiplied_alpha"; // version 8
+	const char *const additiveBlending = "additive"; // version 8
+	const char *const multiplyBlending = "multiply"; // version 8
+	const char *const relativePosition = "relative_position";
+	const char *const layer = "layer";
+	const char *const inLocalSpace = "local_space";
+	const char *const active = "active";
+
+	const char *const colorSteps = "color_steps";
+	const char *const sizeSteps = "size_steps";
+	const char *const baseScale = "base_scale"; // becomes a vector in version 7
+	const char *const rotationSteps = "rotation_steps";
+	const char *const positionSteps = "position_steps";
+	const char *const velocitySteps = "velocity_steps";
+
+	const char *const emission = "emission";
+	const char *const amount = "amount";
+	const char *const life = "life";
+	const char *const positionX = "position_x";
+	const char *const positionY = "position_y";
+	const char *const velocityX = "velocity_x";
+	const char *const velocityY = "velocity_y";
+	const char *const rotation = "rotation";
+	const char *const emitterRotation = "emitter_rotation";
+	const char *const delay = "delay";
+	const char *const randomSeed = "random_seed"; // version 9
+	const char *const continuous = "continuous"; // version 10
+	const char *const rate = "rate"; // version 10
+	const char *const prewarm = "prewarm"; // version 11
+
+}
+
+#endif
@@ -0,0 +1,194 @@
+#include "particle_editor_packer.h"
+
+///////////////////////////////////////////////////////////
+// CONSTRUCTORS and DESTRUCTOR
+///////////////////////////////////////////////////////////
+
+AtlasPacker::AtlasPacker(int pageWidth, int pageHeight, int padding)
+    : pageWidth_(pageWidth), pageHeight_(pageHeight), padding_(padding),
+      sizes_(16), regions_(16), pageSizes_(1), skylines_(1)
+{
+}
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+unsigned int AtlasPacker::add(int width, int height)
+{
+	sizes_.pushBack(nc::Vector2i(width, height));
+	return sizes_.size() - 1;
+}
+
+void AtlasPacker::clear()
+{
+	sizes_.clear();
+	regions_.clear();
+	pageSizes_.clear();
+	skylines_.clear();
+}
+
+bool AtlasPacker::pack()
+{
+	regions_.clear();
+	pageSizes_.clear();
+	skylines_.clear();
+
+	// Taller rectangles are placed first, it leaves a flatter skyline
+	nctl::Array<unsigned int> order(sizes_.size());
+	for (unsigned int i = 0; i < sizes_.size(); i++)
+	{
+		regions_.emplaceBack();
+		unsigned int j = order.size();
+		order.pushBack(i);
+		while (j > 0 && (sizes_[order[j - 1]].y < sizes_[i].y ||
+		                 (sizes_[order[j - 1]].y == sizes_[i].y && sizes_[order[j - 1]].x < sizes_[i].x)))
+		{
+			order[j] = order[j - 1];
+			j--;
+		}
+		order[j] = i;
+	}
+
+	for (unsigned int i = 0; i < order.size(); i++)
+	{
+		const unsigned int index = order[i];
+		const nc::Vector2i &size = sizes_[index];
+		Region &region = regions_[index];
+		region.rect.set(0, 0, size.x, size.y);
+		if (size.x <= 0 || size.y <= 0)
+			continue;
+		else if (size.x > pageWidth_ || size.y > pageHeight_)
+			return false;
+
+		unsigned int nodeIndex = 0;
+		int x = 0;
+		int y = 0;
+		unsigned int page = 0;
+		while (page < skylines_.size())
+		{
+			if (findPosition(skylines_[page], size.x, size.y, nodeIndex, x, y))
+				break;
+			page++;
+		}
+		if (page == skylines_.size())
+		{
+			addPage();
+			findPosition(skylines_[page], size.x, size.y, nodeIndex, x, y);
+		}
+
+		addSkylineLevel(skylines_[page], nodeIndex, x, y, size.x, size.y);
+		region.page = page;
+		region.rect.x = x;
+		region.rect.y = y;
+
+		nc::Vector2i &pageSize = pageSizes_[page];
+		if (pageSize.x < x + size.x)
+			pageSize.x = x + size.x;
+		if (pageSize.y < y + size.y)
+			pageSize.y = y + size.y;
+	}
+
+	return true;
+}
+
+float AtlasPacker::efficiency() const
+{
+	unsigned long rectsArea = 0;
+	for (unsigned int i = 0; i < regions_.size(); i++)
+		rectsArea += static_cast<unsigned long>(regions_[i].rect.w) * regions_[i].rect.h;
+
+	unsigned long pagesArea = 0;
+	for (unsigned int i = 0; i < pageSizes_.size(); i++)
+		pagesArea += static_cast<unsigned long>(pageSizes_[i].x) * pageSizes_[i].y;
+
+	return (pagesArea > 0) ? rectsArea / static_cast<float>(pagesArea) : 0.0f;
+}
+
+///////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+///////////////////////////////////////////////////////////
+
+void AtlasPacker::addPage()
+{
+	pageSizes_.pushBack(nc::Vector2i(0, 0));
+	skylines_.emplaceBack(16);
+	skylines_.back().pushBack({ 0, 0, pageWidth_ });
+}
+
+bool AtlasPacker::findPosition(const nctl::Array<SkylineNode> &skyline, int width, int height, unsigned int &nodeIndex, int &x, int &y) const
+{
+	int bestTop = pageHeight_ + 1;
+	int bestX = pageWidth_;
+	bool found = false;
+
+	for (unsigned int i = 0; i < skyline.size(); i++)
+	{
+		const int nodeX = skyline[i].x;
+		if (nodeX + width > pageWidth_)
+			break;
+
+		// The rectangle and its padding rest on the highest node they span
+		int nodeY = 0;
+		int widthLeft = width + padding_;
+		for (unsigned int j = i; j < skyline.size() && widthLeft > 0; j++)
+		{
+			if (nodeY < skyline[j].y)
+				nodeY = skyline[j].y;
+			widthLeft -= skyline[j].width;
+		}
+
+		const int top = nodeY + height;
+		if (top <= pageHeight_ && (top < bestTop || (top == bestTop && nodeX < bestX)))
+		{
+			bestTop = top;
+			bestX = nodeX;
+			nodeIndex = i;
+			x = nodeX;
+			y = nodeY;
+			found = true;
+		}
+	}
+
+	return found;
+}
+
+void AtlasPacker::addSkylineLevel(nctl::Array<SkylineNode> &skyline, unsigned int nodeIndex, int x, int y, int width, int height)
+{
+	// The padding is only added where it does not go beyond the page
+	int paddedWidth = width + padding_;
+	if (x + paddedWidth > pageWidth_)
+		paddedWidth = pageWidth_ - x;
+
+	skyline.insertAt(nodeIndex, { x, y + height + padding_, paddedWidth });
+
+	// Shrinks or removes the nodes covered by the new one
+	unsigned int i = nodeIndex + 1;
+	while (i < skyline.size())
+	{
+		const SkylineNode &prev = skyline[i - 1];
+		SkylineNode &node = skyline[i];
+		const int overlap = prev.x + prev.width - node.x;
+		if (overlap <= 0)
+			break;
+
+		node.x += overlap;
+		node.width -= overlap;
+		if (node.width > 0)
+			break;
+		skyline.removeAt(i);
+	}
+
+	// Merges the nodes at the same height
+	i = 0;
+	while (i + 1 < skyline.size())
+	{
+		if (skyline[i].y == skyline[i + 1].y)
+		{
+			skyline[i].width += skyline[i + 1].width;
+			skyline.removeAt(i + 1);
+		}
+		else
+			i++;
+	}
+}
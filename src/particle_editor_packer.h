@@ -0,0 +1,68 @@
+#ifndef CLASS_ATLASPACKER
+#define CLASS_ATLASPACKER
+
+#include <nctl/Array.h>
+#include <ncine/Vector2.h>
+#include <ncine/Rect.h>
+
+namespace nc = ncine;
+
+/// A rectangle packer that places rectangles in one or more atlas pages
+/*! It uses a skyline bottom-left heuristic on rectangles sorted by decreasing height.
+ *  It only works on sizes and does not need a graphics context. */
+class AtlasPacker
+{
+  public:
+	struct Region
+	{
+		unsigned int page = 0;
+		nc::Recti rect;
+	};
+
+	AtlasPacker(int pageWidth, int pageHeight, int padding);
+
+	inline int pageWidth() const { return pageWidth_; }
+	inline int pageHeight() const { return pageHeight_; }
+	inline int padding() const { return padding_; }
+
+	/// Adds a rectangle to pack and returns its index
+	unsigned int add(int width, int height);
+	/// Removes all rectangles and pages
+	void clear();
+	/// Packs all the rectangles, returns false if one of them is bigger than a page
+	bool pack();
+
+	inline unsigned int size() const { return sizes_.size(); }
+	inline const Region &region(unsigned int index) const { return regions_[index]; }
+	inline unsigned int numPages() const { return pageSizes_.size(); }
+	/// Returns the smallest size that contains all the rectangles of a page
+	inline const nc::Vector2i &pageSize(unsigned int page) const { return pageSizes_[page]; }
+
+	/// Returns the ratio between the area of all the rectangles and the area of all the pages
+	float efficiency() const;
+
+  private:
+	/// A horizontal segment of the top profile of the packed rectangles
+	struct SkylineNode
+	{
+		int x;
+		int y;
+		int width;
+	};
+
+	int pageWidth_;
+	int pageHeight_;
+	int padding_;
+
+	nctl::Array<nc::Vector2i> sizes_;
+	nctl::Array<Region> regions_;
+	nctl::Array<nc::Vector2i> pageSizes_;
+	nctl::Array<nctl::Array<SkylineNode>> skylines_;
+
+	void addPage();
+	/// Finds the position that keeps the rectangle top edge lowest, returns false if it does not fit
+	bool findPosition(const nctl::Array<SkylineNode> &skyline, int width, int height, unsigned int &nodeIndex, int &x, int &y) const;
+	void addSkylineLevel(nctl::Array<SkylineNode> &skyline, unsigned int nodeIndex, int x, int y, int width, int height);
+};
+
+#endif
@@ -0,0 +1,781 @@
+#include <cstring>
+
+#include "particle_editor_parser.h"
+#include "particle_editor_float.h"
+#include "particle_editor_names.h"
+#include "particle_editor_random.h"
+#include <ncine/Colorf.h>
+
+namespace {
+
+inline bool isNameStart(char c)
+{
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+inline bool isDigit(char c)
+{
+	return (c >= '0' && c <= '9');
+}
+
+inline bool isNameChar(char c)
+{
+	return isNameStart(c) || isDigit(c);
+}
+
+}
+
+const ProjectParser::RequiredKey ProjectParser::BackgroundKeys[] = {
+	{ Names::backgroundColor, 4 },
+	{ Names::backgroundImage, 4 },
+	{ Names::backgroundImageNormalizedPosition, 4 },
+	{ Names::backgroundImageScale, 4 },
+	{ Names::backgroundImageLayer, 4 },
+	{ Names::backgroundImageColor, 5 },
+	{ Names::backgroundImageRect, 5 },
+	{ Names::backgroundImageFlippedX, 7 },
+	{ Names::backgroundImageFlippedY, 7 }
+};
+const unsigned int ProjectParser::NumBackgroundKeys = sizeof(BackgroundKeys) / sizeof(BackgroundKeys[0]);
+
+const ProjectParser::RequiredKey ProjectParser::SystemKeys[] = {
+	{ Names::name, 3 },
+	{ Names::numParticles, 1 },
+	{ Names::texture, 1 },
+	{ Names::texRext, 1 },
+	{ Names::anchorPoint, 6 },
+	{ Names::flippedX, 7 },
+	{ Names::flippedY, 7 },
+	{ Names::blendingPreset, 8 },
+	{ Names::relativePosition, 1 },
+	{ Names::inLocalSpace, 1 },
+	{ Names::active, 1 },
+	{ Names::layer, 4 },
+	{ Names::emission, 1 }
+};
+const unsigned int ProjectParser::NumSystemKeys = sizeof(SystemKeys) / sizeof(SystemKeys[0]);
+
+const ProjectParser::RequiredKey ProjectParser::EmissionKeys[] = {
+	{ Names::amount, 1 },
+	{ Names::life, 1 },
+	{ Names::positionX, 1 },
+	{ Names::positionY, 1 },
+	{ Names::velocityX, 1 },
+	{ Names::velocityY, 1 },
+	{ Names::rotation, 1 },
+	{ Names::emitterRotation, 1 },
+	{ Names::delay, 1 }
+};
+const unsigned int ProjectParser::NumEmissionKeys = sizeof(EmissionKeys) / sizeof(EmissionKeys[0]);
+
+///////////////////////////////////////////////////////////
+// CONSTRUCTORS and DESTRUCTOR
+///////////////////////////////////////////////////////////
+
+ProjectParser::ProjectParser(const char *buffer, unsigned long bufferSize)
+    : current_(buffer), end_(buffer + bufferSize), version_(1)
+{
+}
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+bool ProjectParser::parse(LuaLoader::State &state)
+{
+	// Same defaults as the Lua loading path
+	state.normalizedAbsPosition.set(0.5f, 0.5f);
+	LuaLoader::State::BackgroundProperties &background = state.background;
+	background.color = nc::Colorf::Black;
+	background.imageName.clear();
+	background.imageNormalizedPosition.set(0.5f, 0.5f);
+	background.imageScale.set(1.0f, 1.0f);
+	background.imageLayer = 0;
+	background.imageFlippedX = false;
+	background.imageFlippedY = false;
+	state.systems.clear();
+	version_ = 1;
+
+	bool backgroundFound = false;
+	bool systemsFound = false;
+	advance();
+	while (token_.type != TokenType::END)
+	{
+		if (token_.type != TokenType::NAME)
+			return false;
+		const Token name = token_;
+		advance();
+		if (accept(TokenType::EQUALS) == false)
+			return false;
+
+		bool parsed = false;
+		if (name.equals(Names::version))
+		{
+			// The tables are checked against the version, it has to come before them as it does in saved files
+			if (backgroundFound || systemsFound)
+				return false;
+			parsed = parseInteger(version_);
+		}
+		else if (name.equals(Names::normalizedAbsPosition))
+			parsed = parseVector2f(state.normalizedAbsPosition);
+		else if (name.equals(Names::backgroundProperties))
+		{
+			// A table assigned twice is left to the Lua loading path, which only keeps the last one
+			if (backgroundFound)
+				return false;
+			parsed = parseBackground(state.background);
+			backgroundFound = true;
+		}
+		else if (name.equals(Names::particleSystems))
+		{
+			if (systemsFound)
+				return false;
+			parsed = parseSystems(state.systems);
+			systemsFound = true;
+		}
+
+		if (parsed == false)
+			return false;
+		accept(TokenType::SEMICOLON);
+	}
+
+	// Missing tables would make the Lua loading path fail as well
+	return (systemsFound && (backgroundFound || version_ < 4));
+}
+
+///////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+///////////////////////////////////////////////////////////
+
+bool ProjectParser::Token::equals(const char *string) const
+{
+	return (strncmp(start, string, length) == 0 && string[length] == '\0');
+}
+
+void ProjectParser::markRequiredKey(const Token &name, const RequiredKey *keys, unsigned int numKeys, uint32_t &seenKeys)
+{
+	for (unsigned int i = 0; i < numKeys; i++)
+	{
+		if (name.equals(keys[i].name))
+		{
+			seenKeys |= (1u << i);
+			return;
+		}
+	}
+}
+
+bool ProjectParser::hasRequiredKeys(const RequiredKey *keys, unsigned int numKeys, uint32_t seenKeys) const
+{
+	for (unsigned int i = 0; i < numKeys; i++)
+	{
+		if (version_ >= keys[i].version && (seenKeys & (1u << i)) == 0)
+			return false;
+	}
+	return true;
+}
+
+void ProjectParser::advance()
+{
+	// Skipping white spaces and line comments
+	while (current_ < end_)
+	{
+		const char c = *current_;
+		if (c == ' ' || c == '\t' || c == '\n' || c == '\r')
+			current_++;
+		else if (c == '-' && current_ + 1 < end_ && current_[1] == '-')
+		{
+			// Block comments are left to Lua
+			if (current_ + 2 < end_ && current_[2] == '[')
+			{
+				token_.type = TokenType::INVALID;
+				return;
+			}
+			while (current_ < end_ && *current_ != '\n')
+				current_++;
+		}
+		else
+			break;
+	}
+
+	token_.start = current_;
+	token_.length = 1;
+	if (current_ >= end_)
+	{
+		token_.type = TokenType::END;
+		token_.length = 0;
+		return;
+	}
+
+	const char c = *current_;
+	switch (c)
+	{
+		case '{': token_.type = TokenType::OPEN_BRACE; current_++; return;
+		case '}': token_.type = TokenType::CLOSE_BRACE; current_++; return;
+		case '=': token_.type = TokenType::EQUALS; current_++; return;
+		case ',': token_.type = TokenType::COMMA; current_++; return;
+		case ';': token_.type = TokenType::SEMICOLON; current_++; return;
+		default: break;
+	}
+
+	if (isNameStart(c))
+	{
+		while (current_ < end_ && isNameChar(*current_))
+			current_++;
+		token_.length = static_cast<unsigned int>(current_ - token_.start);
+		token_.type = TokenType::NAME;
+		if (token_.equals("true") || token_.equals("false"))
+		{
+			token_.type = TokenType::BOOLEAN;
+			token_.number = (token_.start[0] == 't') ? 1.0 : 0.0;
+		}
+	}
+	else if (c == '"' || c == '\'')
+	{
+		current_++;
+		token_.start = current_;
+		while (current_ < end_ && *current_ != c)
+		{
+			// Escape sequences would need a copy to be decoded
+			if (*current_ == '\\' || *current_ == '\n')
+			{
+				token_.type = TokenType::INVALID;
+				return;
+			}
+			current_++;
+		}
+		if (current_ >= end_)
+		{
+			token_.type = TokenType::INVALID;
+			return;
+		}
+		token_.type = TokenType::STRING;
+		token_.length = static_cast<unsigned int>(current_ - token_.start);
+		current_++; // closing quote
+	}
+	else if (isDigit(c) || c == '-' || c == '.')
+		readNumber();
+	else
+		token_.type = TokenType::INVALID;
+}
+
+void ProjectParser::readNumber()
+{
+	// Only decimal numbers with an optional sign, fraction and exponent are supported
+	const char *start = current_;
+	if (*current_ == '-')
+		current_++;
+	unsigned int numDigits = 0;
+	while (current_ < end_ && isDigit(*current_))
+	{
+		current_++;
+		numDigits++;
+	}
+	if (current_ < end_ && *current_ == '.')
+	{
+		current_++;
+		while (current_ < end_ && isDigit(*current_))
+		{
+			current_++;
+			numDigits++;
+		}
+	}
+	if (numDigits > 0 && current_ < end_ && (*current_ == 'e' || *current_ == 'E'))
+	{
+		current_++;
+		if (current_ < end_ && (*current_ == '+' || *current_ == '-'))
+			current_++;
+		if (current_ >= end_ || isDigit(*current_) == false)
+			numDigits = 0;
+		while (current_ < end_ && isDigit(*current_))
+			current_++;
+	}
+
+	const unsigned int length = static_cast<unsigned int>(current_ - start);
+	if (numDigits == 0 || length >= MaxNumberLength || (current_ < end_ && isNameChar(*current_)))
+	{
+		token_.type = TokenType::INVALID;
+		return;
+	}
+
+	// The buffer is not null terminated, the conversion reads the token in place
+	token_.type = TokenType::NUMBER;
+	token_.length = length;
+	token_.number = FloatString::parse(start, length);
+}
+
+bool ProjectParser::accept(TokenType type)
+{
+	if (token_.type != type)
+		return false;
+
+	advance();
+	return true;
+}
+
+bool ProjectParser::acceptSeparator()
+{
+	return (accept(TokenType::COMMA) || accept(TokenType::SEMICOLON));
+}
+
+bool ProjectParser::parseNumber(float &value)
+{
+	if (token_.type != TokenType::NUMBER)
+		return false;
+
+	value = static_cast<float>(token_.number);
+	advance();
+	return true;
+}
+
+bool ProjectParser::parseInteger(int &value)
+{
+	if (token_.type != TokenType::NUMBER)
+		return false;
+
+	value = static_cast<int>(token_.number);
+	advance();
+	return true;
+}
+
+bool ProjectParser::parseUnsigned(uint32_t &value)
+{
+	if (token_.type != TokenType::NUMBER || token_.number < 0.0 || token_.number > 4294967295.0)
+		return false;
+
+	value = static_cast<uint32_t>(token_.number);
+	advance();
+	return true;
+}
+
+bool ProjectParser::parseBool(bool &value)
+{
+	if (token_.type != TokenType::BOOLEAN)
+		return false;
+
+	value = (token_.number != 0.0);
+	advance();
+	return true;
+}
+
+bool ProjectParser::parseString(nctl::String &string)
+{
+	if (token_.type != TokenType::STRING)
+		return false;
+
+	string.format("%.*s", static_cast<int>(token_.length), token_.start);
+	advance();
+	return true;
+}
+
+/*! Values can be positional or named after one of the single letter `keys`, missing ones are left untouched */
+bool ProjectParser::parseNumberTable(const char *keys, float *values, unsigned int numValues)
+{
+	if (accept(TokenType::OPEN_BRACE) == false)
+		return false;
+
+	unsigned int position = 0;
+	while (accept(TokenType::CLOSE_BRACE) == false)
+	{
+		unsigned int index = position;
+		if (token_.type == TokenType::NAME)
+		{
+			const char *key = (token_.length == 1) ? strchr(keys, token_.start[0]) : nullptr;
+			if (key == nullptr)
+				return false;
+			index = static_cast<unsigned int>(key - keys);
+			advance();
+			if (accept(TokenType::EQUALS) == false)
+				return false;
+		}
+		else
+			position++;
+
+		if (index >= numValues || parseNumber(values[index]) == false)
+			return false;
+		if (acceptSeparator() == false)
+			return accept(TokenType::CLOSE_BRACE);
+	}
+
+	return true;
+}
+
+bool ProjectParser::parseVector2f(nc::Vector2f &vector)
+{
+	return parseNumberTable("xy", vector.data(), 2);
+}
+
+bool ProjectParser::parseVector2i(nc::Vector2i &vector)
+{
+	float values[2] = { static_cast<float>(vector.x), static_cast<float>(vector.y) };
+	if (parseNumberTable("xy", values, 2) == false)
+		return false;
+
+	vector.set(static_cast<int>(values[0]), static_cast<int>(values[1]));
+	return true;
+}
+
+bool ProjectParser::parseColorf(nc::Colorf &color)
+{
+	return parseNumberTable("rgba", color.data(), 4);
+}
+
+bool ProjectParser::parseRecti(nc::Recti &rect)
+{
+	float values[4] = { static_cast<float>(rect.x), static_cast<float>(rect.y), static_cast<float>(rect.w), static_cast<float>(rect.h) };
+	if (parseNumberTable("xywh", values, 4) == false)
+		return false;
+
+	rect.set(static_cast<int>(values[0]), static_cast<int>(values[1]), static_cast<int>(values[2]), static_cast<int>(values[3]));
+	return true;
+}
+
+/*! Before version 7 a scale was a single number, it is a vector since then */
+bool ProjectParser::parseScale(nc::Vector2f &scale)
+{
+	if (token_.type == TokenType::NUMBER)
+	{
+		if (parseNumber(scale.x) == false)
+			return false;
+		scale.y = scale.x;
+		return true;
+	}
+
+	return parseVector2f(scale);
+}
+
+/*! A step is a table with the age followed by either a number or a table of numbers */
+bool ProjectParser::parseStep(float &age, float *values, const char *keys, unsigned int numValues)
+{
+	if (accept(TokenType::OPEN_BRACE) == false || parseNumber(age) == false || acceptSeparator() == false)
+		return false;
+
+	const bool parsed = (numValues == 1) ? parseNumber(values[0]) : parseNumberTable(keys, values, numValues);
+	if (parsed == false)
+		return false;
+
+	acceptSeparator();
+	return accept(TokenType::CLOSE_BRACE);
+}
+
+bool ProjectParser::parseBackground(LuaLoader::State::BackgroundProperties &background)
+{
+	if (accept(TokenType::OPEN_BRACE) == false)
+		return false;
+
+	uint32_t seenKeys = 0;
+	while (accept(TokenType::CLOSE_BRACE) == false)
+	{
+		if (token_.type != TokenType::NAME)
+			return false;
+		const Token name = token_;
+		advance();
+		if (accept(TokenType::EQUALS) == false)
+			return false;
+
+		bool parsed = false;
+		if (name.equals(Names::backgroundColor))
+			parsed = parseColorf(background.color);
+		else if (name.equals(Names::backgroundImage))
+			parsed = parseString(background.imageName);
+		else if (name.equals(Names::backgroundImageNormalizedPosition))
+			parsed = parseVector2f(background.imageNormalizedPosition);
+		else if (name.equals(Names::backgroundImageScale))
+			parsed = parseScale(background.imageScale);
+		else if (name.equals(Names::backgroundImageLayer))
+			parsed = parseInteger(background.imageLayer);
+		else if (name.equals(Names::backgroundImageColor))
+			parsed = parseColorf(background.imageColor);
+		else if (name.equals(Names::backgroundImageRect))
+			parsed = parseRecti(background.imageRect);
+		else if (name.equals(Names::backgroundImageFlippedX))
+			parsed = parseBool(background.imageFlippedX);
+		else if (name.equals(Names::backgroundImageFlippedY))
+			parsed = parseBool(background.imageFlippedY);
+
+		if (parsed == false)
+			return false;
+		markRequiredKey(name, BackgroundKeys, NumBackgroundKeys, seenKeys);
+		if (acceptSeparator() == false)
+		{
+			if (accept(TokenType::CLOSE_BRACE) == false)
+				return false;
+			break;
+		}
+	}
+
+	return hasRequiredKeys(BackgroundKeys, NumBackgroundKeys, seenKeys);
+}
+
+bool ProjectParser::parseSystems(nctl::Array<LuaLoader::State::ParticleSystem> &systems)
+{
+	if (accept(TokenType::OPEN_BRACE) == false)
+		return false;
+
+	while (accept(TokenType::CLOSE_BRACE) == false)
+	{
+		systems.emplaceBack();
+		systems.back().randomSeed = CounterRandom::defaultSeed(systems.size() - 1);
+		if (parseSystem(systems.back()) == false)
+			return false;
+		if (acceptSeparator() == false)
+			return accept(TokenType::CLOSE_BRACE);
+	}
+
+	return true;
+}
+
+bool ProjectParser::parseSystem(LuaLoader::State::ParticleSystem &s)
+{
+	// Same defaults as the Lua loading path, for fields that were added in later versions
+	s.anchorPoint.set(0.5f, 0.5f);
+	s.flippedX = false;
+	s.flippedY = false;
+	s.blendingPreset = nc::DrawableNode::BlendingPreset::ALPHA;
+	s.layer = 1;
+	s.sizeStepBaseScale.set(1.0f, 1.0f);
+	s.emitDelay = 0.0f;
+	s.continuousEmission = false;
+	s.emissionRate = 60.0f;
+	s.prewarmTime = 0.0f;
+
+	if (accept(TokenType::OPEN_BRACE) == false)
+		return false;
+
+	uint32_t seenKeys = 0;
+	while (accept(TokenType::CLOSE_BRACE) == false)
+	{
+		if (token_.type != TokenType::NAME)
+			return false;
+		const Token name = token_;
+		advance();
+		if (accept(TokenType::EQUALS) == false)
+			return false;
+
+		bool parsed = false;
+		if (name.equals(Names::name))
+			parsed = parseString(s.name);
+		else if (name.equals(Names::numParticles))
+			parsed = parseInteger(s.numParticles);
+		else if (name.equals(Names::texture))
+			parsed = parseString(s.textureName);
+		else if (name.equals(Names::texRext))
+			parsed = parseRecti(s.texRect);
+		else if (name.equals(Names::anchorPoint))
+			parsed = parseVector2f(s.anchorPoint);
+		else if (name.equals(Names::flippedX))
+			parsed = parseBool(s.flippedX);
+		else if (name.equals(Names::flippedY))
+			parsed = parseBool(s.flippedY);
+		else if (name.equals(Names::blendingPreset))
+		{
+			const Token preset = token_;
+			parsed = accept(TokenType::STRING);
+			if (preset.equals(Names::disabledBlending))
+				s.blendingPreset = nc::DrawableNode::BlendingPreset::DISABLED;
+			else if (preset.equals(Names::alphaBlending))
+				s.blendingPreset = nc::DrawableNode::BlendingPreset::ALPHA;
+			else if (preset.equals(Names::premultipliedAlphaBlending))
+				s.blendingPreset = nc::DrawableNode::BlendingPreset::PREMULTIPLIED_ALPHA;
+			else if (preset.equals(Names::additiveBlending))
+				s.blendingPreset = nc::DrawableNode::BlendingPreset::ADDITIVE;
+			else if (preset.equals(Names::multiplyBlending))
+				s.blendingPreset = nc::DrawableNode::BlendingPreset::MULTIPLY;
+		}
+		else if (name.equals(Names::relativePosition))
+			parsed = parseVector2f(s.position);
+		else if (name.equals(Names::layer))
+			parsed = parseInteger(s.layer);
+		else if (name.equals(Names::inLocalSpace))
+			parsed = parseBool(s.inLocalSpace);
+		else if (name.equals(Names::active))
+			parsed = parseBool(s.active);
+		else if (name.equals(Names::colorSteps))
+			parsed = parseColorSteps(s.colorSteps);
+		else if (name.equals(Names::sizeSteps))
+			parsed = parseSizeSteps(s);
+		else if (name.equals(Names::rotationSteps))
+			parsed = parseRotationSteps(s.rotationSteps);
+		else if (name.equals(Names::positionSteps))
+			parsed = parsePositionSteps(s.positionSteps);
+		else if (name.equals(Names::velocitySteps))
+			parsed = parseVelocitySteps(s.velocitySteps);
+		else if (name.equals(Names::emission))
+			parsed = parseEmission(s);
+
+		if (parsed == false)
+			return false;
+		markRequiredKey(name, SystemKeys, NumSystemKeys, seenKeys);
+		if (acceptSeparator() == false)
+		{
+			if (accept(TokenType::CLOSE_BRACE) == false)
+				return false;
+			break;
+		}
+	}
+
+	return hasRequiredKeys(SystemKeys, NumSystemKeys, seenKeys);
+}
+
+bool ProjectParser::parseColorSteps(nctl::Array<LuaLoader::State::ColorStep> &steps)
+{
+	if (accept(TokenType::OPEN_BRACE) == false)
+		return false;
+
+	while (accept(TokenType::CLOSE_BRACE) == false)
+	{
+		LuaLoader::State::ColorStep step;
+		if (parseStep(step.age, step.color.data(), "rgba", 4) == false)
+			return false;
+		steps.pushBack(step);
+		if (acceptSeparator() == false)
+			return accept(TokenType::CLOSE_BRACE);
+	}
+
+	return true;
+}
+
+bool ProjectParser::parseSizeSteps(LuaLoader::State::ParticleSystem &s)
+{
+	if (accept(TokenType::OPEN_BRACE) == false)
+		return false;
+
+	while (accept(TokenType::CLOSE_BRACE) == false)
+	{
+		if (token_.type == TokenType::NAME)
+		{
+			if (token_.equals(Names::baseScale) == false)
+				return false;
+			advance();
+			if (accept(TokenType::EQUALS) == false || parseScale(s.sizeStepBaseScale) == false)
+				return false;
+		}
+		else
+		{
+			LuaLoader::State::SizeStep step;
+			if (accept(TokenType::OPEN_BRACE) == false || parseNumber(step.age) == false || acceptSeparator() == false)
+				return false;
+			if (parseScale(step.scale) == false)
+				return false;
+			acceptSeparator();
+			if (accept(TokenType::CLOSE_BRACE) == false)
+				return false;
+			s.sizeSteps.pushBack(step);
+		}
+
+		if (acceptSeparator() == false)
+			return accept(TokenType::CLOSE_BRACE);
+	}
+
+	return true;
+}
+
+bool ProjectParser::parseRotationSteps(nctl::Array<LuaLoader::State::RotationStep> &steps)
+{
+	if (accept(TokenType::OPEN_BRACE) == false)
+		return false;
+
+	while (accept(TokenType::CLOSE_BRACE) == false)
+	{
+		LuaLoader::State::RotationStep step;
+		if (parseStep(step.age, &step.angle, nullptr, 1) == false)
+			return false;
+		steps.pushBack(step);
+		if (acceptSeparator() == false)
+			return accept(TokenType::CLOSE_BRACE);
+	}
+
+	return true;
+}
+
+bool ProjectParser::parsePositionSteps(nctl::Array<LuaLoader::State::PositionStep> &steps)
+{
+	if (accept(TokenType::OPEN_BRACE) == false)
+		return false;
+
+	while (accept(TokenType::CLOSE_BRACE) == false)
+	{
+		LuaLoader::State::PositionStep step;
+		if (parseStep(step.age, step.position.data(), "xy", 2) == false)
+			return false;
+		steps.pushBack(step);
+		if (acceptSeparator() == false)
+			return accept(TokenType::CLOSE_BRACE);
+	}
+
+	return true;
+}
+
+bool ProjectParser::parseVelocitySteps(nctl::Array<LuaLoader::State::VelocityStep> &steps)
+{
+	if (accept(TokenType::OPEN_BRACE) == false)
+		return false;
+
+	while (accept(TokenType::CLOSE_BRACE) == false)
+	{
+		LuaLoader::State::VelocityStep step;
+		if (parseStep(step.age, step.velocity.data(), "xy", 2) == false)
+			return false;
+		steps.pushBack(step);
+		if (acceptSeparator() == false)
+			return accept(TokenType::CLOSE_BRACE);
+	}
+
+	return true;
+}
+
+bool ProjectParser::parseEmission(LuaLoader::State::ParticleSystem &s)
+{
+	if (accept(TokenType::OPEN_BRACE) == false)
+		return false;
+
+	uint32_t seenKeys = 0;
+	while (accept(TokenType::CLOSE_BRACE) == false)
+	{
+		if (token_.type != TokenType::NAME)
+			return false;
+		const Token name = token_;
+		advance();
+		if (accept(TokenType::EQUALS) == false)
+			return false;
+
+		bool parsed = false;
+		if (name.equals(Names::amount))
+			parsed = parseVector2i(s.init.rndAmount);
+		else if (name.equals(Names::life))
+			parsed = parseVector2f(s.init.rndLife);
+		else if (name.equals(Names::positionX))
+			parsed = parseVector2f(s.init.rndPositionX);
+		else if (name.equals(Names::positionY))
+			parsed = parseVector2f(s.init.rndPositionY);
+		else if (name.equals(Names::velocityX))
+			parsed = parseVector2f(s.init.rndVelocityX);
+		else if (name.equals(Names::velocityY))
+			parsed = parseVector2f(s.init.rndVelocityY);
+		else if (name.equals(Names::rotation))
+			parsed = parseVector2f(s.init.rndRotation);
+		else if (name.equals(Names::emitterRotation))
+			parsed = parseBool(s.init.emitterRotation);
+		else if (name.equals(Names::delay))
+			parsed = parseNumber(s.emitDelay);
+		else if (name.equals(Names::randomSeed))
+			parsed = parseUnsigned(s.randomSeed);
+		else if (name.equals(Names::continuous))
+			parsed = parseBool(s.continuousEmission);
+		else if (name.equals(Names::rate))
+			parsed = parseNumber(s.emissionRate);
+		else if (name.equals(Names::prewarm))
+			parsed = parseNumber(s.prewarmTime);
+
+		if (parsed == false)
+			return false;
+		markRequiredKey(name, EmissionKeys, NumEmissionKeys, seenKeys);
+		if (acceptSeparator() == false)
+		{
+			if (accept(TokenType::CLOSE_BRACE) == false)
+				return false;
+			break;
+		}
+	}
+
+	return hasRequiredKeys(EmissionKeys, NumEmissionKeys, seenKeys);
+}
@@ -0,0 +1,102 @@
+#ifndef CLASS_PROJECTPARSER
+#define CLASS_PROJECTPARSER
+
+#include "particle_editor_lua.h"
+
+/// A parser for project files that does not need a Lua state
+/*! It only understands the subset of the language written by `LuaLoader::save()`:
+ *  global assignments, nested tables, numbers, strings, booleans and line comments.
+ *  When it finds anything else the parsing fails and the file should be run by Lua. */
+class ProjectParser
+{
+  public:
+	ProjectParser(const char *buffer, unsigned long bufferSize);
+
+	/// Fills the state with the content of the buffer, returns false on unsupported constructs
+	bool parse(LuaLoader::State &state);
+
+  private:
+	/// Longer number tokens are rejected
+	static const unsigned int MaxNumberLength = 64;
+
+	/// A key that the Lua loading path retrieves without a default, since the version that introduced it
+	struct RequiredKey
+	{
+		const char *name;
+		int version;
+	};
+
+	static const RequiredKey BackgroundKeys[];
+	static const unsigned int NumBackgroundKeys;
+	static const RequiredKey SystemKeys[];
+	static const unsigned int NumSystemKeys;
+	static const RequiredKey EmissionKeys[];
+	static const unsigned int NumEmissionKeys;
+
+	enum class TokenType
+	{
+		END,
+		NAME,
+		NUMBER,
+		STRING,
+		BOOLEAN,
+		OPEN_BRACE,
+		CLOSE_BRACE,
+		EQUALS,
+		COMMA,
+		SEMICOLON,
+		INVALID
+	};
+
+	/// A token is a view over the buffer, no memory is allocated while parsing
+	struct Token
+	{
+		TokenType type = TokenType::END;
+		const char *start = nullptr;
+		unsigned int length = 0;
+		/// The value of numbers, or one and zero for booleans
+		double number = 0.0;
+
+		bool equals(const char *string) const;
+	};
+
+	const char *current_;
+	const char *end_;
+	Token token_;
+	/// The version of the project, the keys required to load it depend on it
+	int version_;
+
+	void advance();
+	void readNumber();
+	bool accept(TokenType type);
+	bool acceptSeparator();
+	/// Sets the bit of the key in the mask, if the key is in the required ones
+	static void markRequiredKey(const Token &name, const RequiredKey *keys, unsigned int numKeys, uint32_t &seenKeys);
+	/// Returns true if all the keys required by the version of the project have been seen
+	bool hasRequiredKeys(const RequiredKey *keys, unsigned int numKeys, uint32_t seenKeys) const;
+
+	bool parseNumber(float &value);
+	bool parseInteger(int &value);
+	bool parseUnsigned(uint32_t &value);
+	bool parseBool(bool &value);
+	bool parseString(nctl::String &string);
+	bool parseNumberTable(const char *keys, float *values, unsigned int numValues);
+	bool parseVector2f(nc::Vector2f &vector);
+	bool parseVector2i(nc::Vector2i &vector);
+	bool parseColorf(nc::Colorf &color);
+	bool parseRecti(nc::Recti &rect);
+	bool parseScale(nc::Vector2f &scale);
+	bool parseStep(float &age, float *values, const char *keys, unsigned int numValues);
+
+	bool parseBackground(LuaLoader::State::BackgroundProperties &background);
+	bool parseSystems(nctl::Array<LuaLoader::State::ParticleSystem> &systems);
+	bool parseSystem(LuaLoader::State::ParticleSystem &system);
+	bool parseColorSteps(nctl::Array<LuaLoader::State::ColorStep> &steps);
+	bool parseSizeSteps(LuaLoader::State::ParticleSystem &system);
+	bool parseRotationSteps(nctl::Array<LuaLoader::State::RotationStep> &steps);
+	bool parsePositionSteps(nctl::Array<LuaLoader::State::PositionStep> &steps);
+	bool parseVelocitySteps(nctl::Array<LuaLoader::State::VelocityStep> &steps);
+	bool parseEmission(LuaLoader::State::ParticleSystem &system);
+};
+
+#endif
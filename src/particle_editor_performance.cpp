@@ -0,0 +1,176 @@
+#include "particle_editor_performance.h"
+
+namespace {
+
+void siftDown(float *values, unsigned int index, unsigned int size)
+{
+	while (2 * index + 1 < size)
+	{
+		unsigned int child = 2 * index + 1;
+		if (child + 1 < size && values[child + 1] > values[child])
+			child++;
+		if (values[index] >= values[child])
+			break;
+
+		const float temp = values[index];
+		values[index] = values[child];
+		values[child] = temp;
+		index = child;
+	}
+}
+
+/// Sorts in ascending order with a heap sort, it needs no additional memory and has no worst case
+void sortValues(float *values, unsigned int size)
+{
+	for (unsigned int i = size / 2; i > 0; i--)
+		siftDown(values, i - 1, size);
+
+	for (unsigned int last = size; last > 1; last--)
+	{
+		const float temp = values[0];
+		values[0] = values[last - 1];
+		values[last - 1] = temp;
+		siftDown(values, 0, last - 1);
+	}
+}
+
+/// The nearest-rank percentile of sorted values
+float percentile(const float *sortedValues, unsigned int size, unsigned int percent)
+{
+	const unsigned int rank = (size * percent + 99) / 100;
+	return sortedValues[(rank > 0) ? rank - 1 : 0];
+}
+
+}
+
+///////////////////////////////////////////////////////////
+// CONSTRUCTORS and DESTRUCTOR
+///////////////////////////////////////////////////////////
+
+FrameTimeHistory::FrameTimeHistory(unsigned int length)
+    : values_(length), next_(0), size_(0), sortedValues_(length)
+{
+	FATAL_ASSERT(length > 0);
+	values_.setSize(length);
+}
+
+DrawCallEstimator::DrawCallEstimator()
+    : groups_(16)
+{
+}
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+void FrameTimeHistory::setLength(unsigned int length)
+{
+	FATAL_ASSERT(length > 0);
+	if (length == values_.size())
+		return;
+
+	const unsigned int numKept = (size_ < length) ? size_ : length;
+	nctl::Array<float> values(length);
+	values.setSize(length);
+	// The values are moved to the start of the new buffer, from the oldest kept to the newest
+	const unsigned int oldLength = values_.size();
+	for (unsigned int i = 0; i < numKept; i++)
+		values[i] = values_[(next_ + oldLength - numKept + i) % oldLength];
+
+	values_ = nctl::move(values);
+	next_ = numKept % length;
+	size_ = numKept;
+}
+
+void FrameTimeHistory::push(float milliseconds)
+{
+	values_[next_] = milliseconds;
+	next_ = (next_ + 1) % values_.size();
+	if (size_ < values_.size())
+		size_++;
+}
+
+void FrameTimeHistory::clear()
+{
+	next_ = 0;
+	size_ = 0;
+	statistics_ = Statistics();
+}
+
+const FrameTimeHistory::Statistics &FrameTimeHistory::computeStatistics()
+{
+	statistics_ = Statistics();
+	statistics_.numFrames = size_;
+	if (size_ == 0)
+		return statistics_;
+
+	sortedValues_.clear();
+	float sum = 0.0f;
+	for (unsigned int i = 0; i < size_; i++)
+	{
+		sortedValues_.pushBack(values_[i]);
+		sum += values_[i];
+	}
+	sortValues(sortedValues_.data(), size_);
+
+	statistics_.mean = sum / size_;
+	statistics_.min = sortedValues_[0];
+	statistics_.max = sortedValues_[size_ - 1];
+	statistics_.p50 = percentile(sortedValues_.data(), size_, 50);
+	statistics_.p90 = percentile(sortedValues_.data(), size_, 90);
+	statistics_.p99 = percentile(sortedValues_.data(), size_, 99);
+
+	const float range = statistics_.max - statistics_.min;
+	for (unsigned int i = 0; i < size_; i++)
+	{
+		unsigned int bin = (range > 0.0f) ? static_cast<unsigned int>((sortedValues_[i] - statistics_.min) / range * NumBins) : 0;
+		if (bin >= NumBins)
+			bin = NumBins - 1;
+		statistics_.bins[bin] += 1.0f;
+		if (statistics_.maxBinCount < statistics_.bins[bin])
+			statistics_.maxBinCount = statistics_.bins[bin];
+	}
+
+	return statistics_;
+}
+
+void DrawCallEstimator::clear()
+{
+	groups_.clear();
+}
+
+/*! A project has a few distinct states, a linear search is faster than hashing them */
+void DrawCallEstimator::add(const void *texture, int blendingPreset, int layer, unsigned int numSprites)
+{
+	if (numSprites == 0)
+		return;
+
+	for (Group &group : groups_)
+	{
+		if (group.texture == texture && group.blendingPreset == blendingPreset && group.layer == layer)
+		{
+			group.numSprites += numSprites;
+			return;
+		}
+	}
+	groups_.pushBack({ texture, blendingPreset, layer, numSprites });
+}
+
+DrawCallEstimator::Estimate DrawCallEstimator::estimate(bool batchingEnabled, unsigned int minBatchSize, unsigned int maxBatchSize) const
+{
+	Estimate estimate;
+	estimate.numGroups = groups_.size();
+	for (const Group &group : groups_)
+	{
+		estimate.numSprites += group.numSprites;
+		if (batchingEnabled && maxBatchSize > 0 && group.numSprites >= minBatchSize)
+		{
+			const unsigned int numBatches = (group.numSprites + maxBatchSize - 1) / maxBatchSize;
+			estimate.numBatches += numBatches;
+			estimate.numDrawCalls += numBatches;
+		}
+		else
+			estimate.numDrawCalls += group.numSprites;
+	}
+	return estimate;
+}
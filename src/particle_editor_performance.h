@@ -0,0 +1,83 @@
+#ifndef CLASS_FRAMETIMEHISTORY
+#define CLASS_FRAMETIMEHISTORY
+
+#include <nctl/Array.h>
+
+/// The durations of the last frames, in a ring buffer that can be plotted directly
+class FrameTimeHistory
+{
+  public:
+	static const unsigned int NumBins = 32;
+
+	struct Statistics
+	{
+		unsigned int numFrames = 0;
+		float mean = 0.0f;
+		float min = 0.0f;
+		float max = 0.0f;
+		float p50 = 0.0f;
+		float p90 = 0.0f;
+		float p99 = 0.0f;
+		/// The number of frames in every bin, from the minimum to the maximum time
+		float bins[NumBins] = {};
+		float maxBinCount = 0.0f;
+	};
+
+	explicit FrameTimeHistory(unsigned int length);
+
+	inline unsigned int length() const { return values_.size(); }
+	inline unsigned int size() const { return size_; }
+	inline const float *data() const { return values_.data(); }
+	/// The index of the oldest value, the offset of a plot of the whole buffer
+	inline unsigned int offset() const { return (size_ < values_.size()) ? 0 : next_; }
+	inline const Statistics &statistics() const { return statistics_; }
+
+	/// Changes the number of frames kept, the most recent values are preserved
+	void setLength(unsigned int length);
+	void push(float milliseconds);
+	void clear();
+	/// Computes the statistics and the histogram of the values, by sorting a copy of them
+	const Statistics &computeStatistics();
+
+  private:
+	nctl::Array<float> values_;
+	/// The index where the next value will be written
+	unsigned int next_;
+	unsigned int size_;
+	nctl::Array<float> sortedValues_;
+	Statistics statistics_;
+};
+
+/// Estimates the draw calls of the particles from the batching settings of the renderer
+/*! Particles are sprites, the renderer can merge the ones with the same material and layer in instanced batches. */
+class DrawCallEstimator
+{
+  public:
+	struct Estimate
+	{
+		unsigned int numSprites = 0;
+		unsigned int numGroups = 0;
+		unsigned int numBatches = 0;
+		unsigned int numDrawCalls = 0;
+	};
+
+	DrawCallEstimator();
+
+	void clear();
+	/// Adds sprites drawn with a texture, a blending preset and a layer, they join the ones with the same state
+	void add(const void *texture, int blendingPreset, int layer, unsigned int numSprites);
+	Estimate estimate(bool batchingEnabled, unsigned int minBatchSize, unsigned int maxBatchSize) const;
+
+  private:
+	struct Group
+	{
+		const void *texture;
+		int blendingPreset;
+		int layer;
+		unsigned int numSprites;
+	};
+
+	nctl::Array<Group> groups_;
+};
+
+#endif
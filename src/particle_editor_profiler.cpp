@@ -0,0 +1,116 @@
+#include "particle_editor_profiler.h"
+#include "particle_editor_writer.h"
+#include <ncine/TimeStamp.h>
+
+namespace {
+
+/// Appends a duration in nanoseconds as microseconds with three decimals, the unit of the trace format
+void appendMicroseconds(BufferedWriter &file, uint64_t nanoseconds)
+{
+	file.formatAppend("%llu.%03u", static_cast<unsigned long long>(nanoseconds / 1000), static_cast<unsigned int>(nanoseconds % 1000));
+}
+
+}
+
+FrameProfiler &theFrameProfiler()
+{
+	static FrameProfiler profiler(FrameProfiler::DefaultCapacity);
+	return profiler;
+}
+
+///////////////////////////////////////////////////////////
+// CONSTRUCTORS and DESTRUCTOR
+///////////////////////////////////////////////////////////
+
+FrameProfiler::FrameProfiler(unsigned int capacity)
+    : events_(capacity), first_(0), size_(0), frame_(0), frameStart_(0)
+{
+	FATAL_ASSERT(capacity > 0);
+	events_.setSize(capacity);
+}
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+void FrameProfiler::nextFrame()
+{
+	const uint64_t time = now();
+	if (frameStart_ > 0)
+		record("Frame", frameStart_, time, NoSystem);
+	frameStart_ = time;
+	frame_++;
+}
+
+void FrameProfiler::record(const char *name, uint64_t start, uint64_t end, unsigned int systemIndex)
+{
+	const unsigned int capacity = events_.size();
+	const unsigned int index = (first_ + size_) % capacity;
+	if (size_ < capacity)
+		size_++;
+	else
+		first_ = (first_ + 1) % capacity;
+
+	Event &event = events_[index];
+	event.name = name;
+	event.start = start;
+	event.duration = end - start;
+	event.frame = frame_;
+	event.systemIndex = systemIndex;
+}
+
+void FrameProfiler::clear()
+{
+	first_ = 0;
+	size_ = 0;
+}
+
+/*! Every event is a complete event on a single thread, the nesting of the scopes is recovered from the times.
+ *  Times are relative to the earliest start, so that they stay short and precise. */
+bool FrameProfiler::saveChromeTrace(const char *filename) const
+{
+	BufferedWriter file(filename);
+	if (file.isOpened() == false)
+		return false;
+
+	// An enclosing scope is recorded after the ones it contains, the oldest event is not always the earliest
+	uint64_t origin = (size_ > 0) ? (*this)[0].start : 0;
+	for (unsigned int i = 1; i < size_; i++)
+	{
+		if (origin > (*this)[i].start)
+			origin = (*this)[i].start;
+	}
+
+	file.append("{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+	for (unsigned int i = 0; i < size_; i++)
+	{
+		const Event &event = (*this)[i];
+		file.formatAppend("{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 0, \"tid\": 0, \"ts\": ", event.name);
+		appendMicroseconds(file, event.start - origin);
+		file.append(", \"dur\": ");
+		appendMicroseconds(file, event.duration);
+		file.formatAppend(", \"args\": {\"frame\": %u", event.frame);
+		if (event.systemIndex != NoSystem)
+			file.formatAppend(", \"system\": %u", event.systemIndex);
+		file.formatAppend("}}%s\n", (i + 1 < size_) ? "," : "");
+	}
+	file.append("]}\n");
+	return file.close();
+}
+
+uint64_t FrameProfiler::now()
+{
+	return nc::TimeStamp::now().nanoseconds();
+}
+
+void ProfiledParticleSystem::update(float interval)
+{
+	const uint64_t start = FrameProfiler::now();
+	nc::ParticleSystem::update(interval);
+	const uint64_t end = FrameProfiler::now();
+
+	updateTime_ = end - start;
+#ifdef WITH_PROFILER
+	theFrameProfiler().record("ParticleSystem::update", start, end, profileIndex_);
+#endif
+}
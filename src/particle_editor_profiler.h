@@ -0,0 +1,114 @@
+#ifndef CLASS_FRAMEPROFILER
+#define CLASS_FRAMEPROFILER
+
+#include <cstdint>
+#include <nctl/Array.h>
+#include <ncine/ParticleSystem.h>
+
+namespace nc = ncine;
+
+/// The durations of the phases of the last frames, recorded by scoped timers in a ring buffer
+/*! When the buffer is full the oldest events are overwritten. Events should only be recorded by the main thread. */
+class FrameProfiler
+{
+  public:
+	static const unsigned int DefaultCapacity = 16384;
+	/// The system index of an event that is not related to a particle system
+	static const unsigned int NoSystem = ~0u;
+
+	struct Event
+	{
+		/// A string literal naming the phase
+		const char *name = nullptr;
+		/// Start time in nanoseconds
+		uint64_t start = 0;
+		/// Duration in nanoseconds
+		uint64_t duration = 0;
+		uint32_t frame = 0;
+		unsigned int systemIndex = NoSystem;
+	};
+
+	explicit FrameProfiler(unsigned int capacity);
+
+	inline unsigned int capacity() const { return events_.size(); }
+	inline unsigned int size() const { return size_; }
+	/// Returns the events from the oldest to the newest
+	inline const Event &operator[](unsigned int index) const { return events_[(first_ + index) % events_.size()]; }
+	inline uint32_t frame() const { return frame_; }
+
+	/// Ends the current frame with a `Frame` event and starts a new one
+	void nextFrame();
+	void record(const char *name, uint64_t start, uint64_t end, unsigned int systemIndex);
+	void clear();
+
+	/// Writes the events in the Chrome trace event format, it can be opened with `about:tracing`
+	bool saveChromeTrace(const char *filename) const;
+
+	/// Returns the current time in nanoseconds
+	static uint64_t now();
+
+  private:
+	nctl::Array<Event> events_;
+	/// The index of the oldest event
+	unsigned int first_;
+	unsigned int size_;
+	uint32_t frame_;
+	uint64_t frameStart_;
+};
+
+/// Returns the profiler of the application
+FrameProfiler &theFrameProfiler();
+
+/// Records an event from its construction to its destruction
+class ProfileScope
+{
+  public:
+	explicit ProfileScope(const char *name)
+	    : name_(name), systemIndex_(FrameProfiler::NoSystem), start_(FrameProfiler::now()) {}
+	ProfileScope(const char *name, unsigned int systemIndex)
+	    : name_(name), systemIndex_(systemIndex), start_(FrameProfiler::now()) {}
+	~ProfileScope() { theFrameProfiler().record(name_, start_, FrameProfiler::now(), systemIndex_); }
+
+  private:
+	const char *name_;
+	unsigned int systemIndex_;
+	uint64_t start_;
+
+	/// Deleted copy constructor
+	ProfileScope(const ProfileScope &) = delete;
+	/// Deleted assignment operator
+	ProfileScope &operator=(const ProfileScope &) = delete;
+};
+
+/// A particle system that measures the duration of its updates, the engine updates it when visiting the scene
+/*! With the profiler enabled the updates are also recorded as events. */
+class ProfiledParticleSystem : public nc::ParticleSystem
+{
+  public:
+	using nc::ParticleSystem::ParticleSystem;
+
+	/// Sets the index shown in the trace, it changes when a previous system is destroyed
+	inline void setProfileIndex(unsigned int index) { profileIndex_ = index; }
+	/// Returns the duration of the last update in nanoseconds
+	inline uint64_t updateTime() const { return updateTime_; }
+	/// Resets the duration when the system is not going to be updated
+	inline void clearUpdateTime() { updateTime_ = 0; }
+
+	void update(float interval) override;
+
+  private:
+	unsigned int profileIndex_ = FrameProfiler::NoSystem;
+	uint64_t updateTime_ = 0;
+};
+
+#ifdef WITH_PROFILER
+	#define PROFILE_CONCAT_IMPL(a, b) a##b
+	#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+	#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+	#define PROFILE_SYSTEM_SCOPE(name, index) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name, index)
+#else
+	#define PROFILE_SCOPE(name)
+	#define PROFILE_SYSTEM_SCOPE(name, index)
+#endif
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef CLASS_COUNTERRANDOM
+#define CLASS_COUNTERRANDOM
+
+#include <cstdint>
+
+/// A counter-based random generator, every number is a hash of the seed and of its position in the stream
+/*! The whole state is a seed and a counter, a stream can be restarted or saved without generating any number.
+ *  The hash is the finalizer of SplitMix64, applied to a Weyl sequence keyed by the seed. */
+class CounterRandom
+{
+  public:
+	CounterRandom()
+	    : seed_(0), key_(hash(0)), counter_(0) {}
+	explicit CounterRandom(uint32_t seed)
+	    : seed_(seed), key_(hash(seed)), counter_(0) {}
+
+	/// Mixes all the bits of a value
+	static inline uint64_t hash(uint64_t value)
+	{
+		value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+		value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+		return value ^ (value >> 31);
+	}
+	/// Returns the seed used when a project file does not specify one, it only depends on the system index
+	static inline uint32_t defaultSeed(unsigned int systemIndex) { return static_cast<uint32_t>(hash(systemIndex + 1) >> 32); }
+
+	/// Restarts the stream of a seed
+	inline void init(uint32_t seed)
+	{
+		seed_ = seed;
+		key_ = hash(seed);
+		counter_ = 0;
+	}
+	inline uint32_t seed() const { return seed_; }
+	/// Returns the number of values generated since the stream has been restarted
+	inline uint64_t counter() const { return counter_; }
+
+	inline uint64_t next64() { return hash(key_ + (++counter_) * 0x9e3779b97f4a7c15ull); }
+	inline uint32_t next() { return static_cast<uint32_t>(next64() >> 32); }
+
+	/// Returns a number in the `[min, max)` range, like `nc::RandomGenerator::integer()`
+	inline int32_t integer(int32_t min, int32_t max)
+	{
+		if (max <= min)
+			return min;
+		const uint64_t range = static_cast<uint32_t>(max - min);
+		return min + static_cast<int32_t>((next() * range) >> 32);
+	}
+	/// Returns a number in the `[min, max)` range, like `nc::RandomGenerator::real()`
+	inline float real(float min, float max) { return min + (next() >> 8) * (1.0f / 16777216.0f) * (max - min); }
+
+  private:
+	uint32_t seed_;
+	uint64_t key_;
+	uint64_t counter_;
+};
+
+#endif
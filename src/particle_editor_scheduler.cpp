@@ -0,0 +1,137 @@
+#include "particle_editor_scheduler.h"
+
+///////////////////////////////////////////////////////////
+// CONSTRUCTORS and DESTRUCTOR
+///////////////////////////////////////////////////////////
+
+EmissionScheduler::EmissionScheduler()
+    : heap_(16), systems_(16), numScheduled_(0)
+{
+}
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+void EmissionScheduler::clear()
+{
+	heap_.clear();
+	systems_.clear();
+	numScheduled_ = 0;
+	statistics_ = Statistics();
+}
+
+void EmissionScheduler::schedule(unsigned int index, double time)
+{
+	while (systems_.size() <= index)
+		systems_.emplaceBack();
+
+	System &system = systems_[index];
+	if (system.scheduled == false)
+		numScheduled_++;
+	system.scheduled = true;
+	system.version++;
+
+	push({ time, index, system.version });
+	compact();
+}
+
+void EmissionScheduler::unschedule(unsigned int index)
+{
+	if (isScheduled(index) == false)
+		return;
+
+	systems_[index].scheduled = false;
+	numScheduled_--;
+	compact();
+}
+
+void EmissionScheduler::popDue(double time, nctl::Array<unsigned int> &dueIndices)
+{
+	statistics_.numDue = 0;
+	statistics_.numStale = 0;
+
+	while (heap_.isEmpty() == false && (heap_[0].time <= time || isCurrent(heap_[0]) == false))
+	{
+		const Entry top = heap_[0];
+		pop();
+		if (isCurrent(top))
+		{
+			systems_[top.index].scheduled = false;
+			numScheduled_--;
+			dueIndices.pushBack(top.index);
+			statistics_.numDue++;
+		}
+		else
+			statistics_.numStale++;
+	}
+
+	statistics_.numScheduled = numScheduled_;
+	statistics_.heapSize = heap_.size();
+}
+
+///////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+///////////////////////////////////////////////////////////
+
+void EmissionScheduler::push(const Entry &entry)
+{
+	heap_.pushBack(entry);
+	siftUp(heap_.size() - 1);
+}
+
+void EmissionScheduler::pop()
+{
+	heap_[0] = heap_.back();
+	heap_.popBack();
+	if (heap_.isEmpty() == false)
+		siftDown(0);
+}
+
+void EmissionScheduler::compact()
+{
+	if (heap_.size() < 2 * numScheduled_ + 16)
+		return;
+
+	unsigned int numCurrent = 0;
+	for (unsigned int i = 0; i < heap_.size(); i++)
+	{
+		if (isCurrent(heap_[i]))
+			heap_[numCurrent++] = heap_[i];
+	}
+	heap_.setSize(numCurrent);
+
+	for (unsigned int i = numCurrent / 2; i > 0; i--)
+		siftDown(i - 1);
+}
+
+void EmissionScheduler::siftUp(unsigned int position)
+{
+	const Entry entry = heap_[position];
+	while (position > 0)
+	{
+		const unsigned int parent = (position - 1) / 2;
+		if (heap_[parent].time <= entry.time)
+			break;
+		heap_[position] = heap_[parent];
+		position = parent;
+	}
+	heap_[position] = entry;
+}
+
+void EmissionScheduler::siftDown(unsigned int position)
+{
+	const Entry entry = heap_[position];
+	const unsigned int size = heap_.size();
+	while (2 * position + 1 < size)
+	{
+		unsigned int child = 2 * position + 1;
+		if (child + 1 < size && heap_[child + 1].time < heap_[child].time)
+			child++;
+		if (entry.time <= heap_[child].time)
+			break;
+		heap_[position] = heap_[child];
+		position = child;
+	}
+	heap_[position] = entry;
+}
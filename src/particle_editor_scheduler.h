@@ -0,0 +1,75 @@
+#ifndef CLASS_EMISSIONSCHEDULER
+#define CLASS_EMISSIONSCHEDULER
+
+#include <cstdint>
+#include <nctl/Array.h>
+
+/// A min-heap of the next emission time of every scheduled particle system
+/*! Polling only looks at the systems that are due, a system that is not scheduled costs nothing.
+ *  Rescheduling a system does not search the heap, the previous entry is discarded when it reaches the top. */
+class EmissionScheduler
+{
+  public:
+	/// The work done by the last call to `popDue()`
+	struct Statistics
+	{
+		/// Number of systems with a valid entry in the heap
+		unsigned int numScheduled = 0;
+		/// Number of systems returned as due
+		unsigned int numDue = 0;
+		/// Number of outdated entries discarded from the top of the heap
+		unsigned int numStale = 0;
+		/// Number of entries in the heap, outdated ones included
+		unsigned int heapSize = 0;
+	};
+
+	EmissionScheduler();
+
+	inline const Statistics &statistics() const { return statistics_; }
+	inline bool isScheduled(unsigned int index) const { return index < systems_.size() && systems_[index].scheduled; }
+
+	/// Removes every system and every entry
+	void clear();
+	/// Sets or replaces the next emission time of a system
+	void schedule(unsigned int index, double time);
+	/// Removes a system from the schedule until it is scheduled again
+	void unschedule(unsigned int index);
+	/// Appends the systems due at the specified time and removes them from the schedule
+	/*! Every due system is returned once, even if it is scheduled again at a time that is already due */
+	void popDue(double time, nctl::Array<unsigned int> &dueIndices);
+
+  private:
+	struct Entry
+	{
+		double time;
+		unsigned int index;
+		/// Matches the version of the system while the entry is the current one
+		uint32_t version;
+	};
+
+	struct System
+	{
+		uint32_t version = 0;
+		bool scheduled = false;
+	};
+
+	nctl::Array<Entry> heap_;
+	nctl::Array<System> systems_;
+	unsigned int numScheduled_;
+	Statistics statistics_;
+
+	inline bool isCurrent(const Entry &entry) const
+	{
+		const System &system = systems_[entry.index];
+		return system.scheduled && system.version == entry.version;
+	}
+
+	void push(const Entry &entry);
+	void pop();
+	/// Removes the outdated entries when they outnumber the current ones
+	void compact();
+	void siftUp(unsigned int position);
+	void siftDown(unsigned int position);
+};
+
+#endif
@@ -0,0 +1,243 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "particle_editor.h"
+#include "particle_editor_lua.h"
+#include "particle_editor_loadjob.h"
+#include "particle_editor_writer.h"
+#include "particle_editor_float.h"
+#include <ncine/AppConfiguration.h>
+#include <ncine/ParticleSystem.h>
+#include <ncine/FileSystem.h>
+#include <ncine/Timer.h>
+
+namespace {
+
+const char *SimulateOption = "--simulate";
+
+void printSimulationUsage()
+{
+	fprintf(stderr, "Usage: --simulate <project file> [--seconds s] [--timestep dt] [--output report.json]\n");
+}
+
+/// Appends a string between quotes, escaping the characters that JSON does not allow
+void appendJsonString(BufferedWriter &file, const char *string)
+{
+	file.append("\"");
+	for (const char *c = string; *c != '\0'; c++)
+	{
+		if (*c == '"' || *c == '\\')
+			file.formatAppend("\\%c", *c);
+		else if (static_cast<unsigned char>(*c) < 0x20)
+			file.formatAppend("\\u%04x", static_cast<unsigned int>(*c));
+		else
+			file.formatAppend("%c", *c);
+	}
+	file.append("\"");
+}
+
+}
+
+///////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+///////////////////////////////////////////////////////////
+
+bool MyEventHandler::parseSimulationArguments(const nc::AppConfiguration &config)
+{
+	int simulateIndex = -1;
+	for (int i = 1; i < config.argc(); i++)
+	{
+		if (strcmp(config.argv(i), SimulateOption) == 0)
+		{
+			simulateIndex = i;
+			break;
+		}
+	}
+	if (simulateIndex < 0)
+		return false;
+
+	SimulationSettings &settings = simulation_;
+	settings.valid = false;
+	if (simulateIndex + 1 >= config.argc())
+		return true;
+	settings.projectFile = config.argv(simulateIndex + 1);
+
+	for (int i = simulateIndex + 2; i < config.argc(); i++)
+	{
+		const char *arg = config.argv(i);
+		const bool hasValue = (i + 1 < config.argc());
+		if (strcmp(arg, "--seconds") == 0 && hasValue)
+			settings.seconds = static_cast<float>(atof(config.argv(++i)));
+		else if (strcmp(arg, "--timestep") == 0 && hasValue)
+			settings.timeStep = static_cast<float>(atof(config.argv(++i)));
+		else if (strcmp(arg, "--output") == 0 && hasValue)
+			settings.outputFile = config.argv(++i);
+		else
+			return true;
+	}
+
+	// The report file replaces the extension of the project one
+	if (settings.outputFile.isEmpty())
+	{
+		const char *projectFile = settings.projectFile.data();
+		settings.outputFile = projectFile;
+		const char *extension = strrchr(projectFile, '.');
+		if (extension != nullptr && strchr(extension, '/') == nullptr && strchr(extension, '\\') == nullptr)
+			settings.outputFile.setLength(static_cast<unsigned int>(extension - projectFile));
+		settings.outputFile.append("_simulation.json");
+	}
+
+	settings.valid = (settings.seconds > 0.0f && settings.timeStep > 0.0f && settings.timeStep <= settings.seconds);
+	return true;
+}
+
+bool MyEventHandler::runSimulation()
+{
+	const SimulationSettings &settings = simulation_;
+	if (settings.valid == false)
+	{
+		printSimulationUsage();
+		return false;
+	}
+
+	nctl::String projectFile(MaxStringLength);
+	projectFile = settings.projectFile;
+	if (nc::fs::isReadableFile(projectFile.data()) == false)
+		projectFile = nc::fs::joinPath(loader_->config().scriptsPath, settings.projectFile);
+	if (load(projectFile.data(), nullptr) == false)
+	{
+		fprintf(stderr, "Could not load project file \"%s\"\n", settings.projectFile.data());
+		return false;
+	}
+
+	// There is no frame loop yet, the worker thread is waited for and the textures are created at once
+	ProjectLoadJob &job = *projectLoadJob_;
+	while (job.status() == ProjectLoadJob::Status::RUNNING)
+		nc::Timer::sleep(1);
+	if (job.status() == ProjectLoadJob::Status::FAILED)
+	{
+		fprintf(stderr, "Could not load project file \"%s\"\n", projectFile.data());
+		job.reset();
+		return false;
+	}
+	while (job.isActive())
+		updateProjectLoad();
+	// The simulation starts from the state the editor shows after loading
+	prewarmParticleSystems();
+	prewarmPending_ = false;
+
+	const unsigned int numSystems = particleSystems_.size();
+	if (numSystems == 0)
+	{
+		fprintf(stderr, "The project file \"%s\" has no particle systems\n", projectFile.data());
+		return false;
+	}
+
+	const unsigned int numSteps = static_cast<unsigned int>(settings.seconds / settings.timeStep + 0.5f);
+	nctl::Array<float> stepTimes(numSteps);
+	nctl::Array<unsigned int> aliveParticles(numSteps * numSystems);
+	nctl::Array<unsigned int> peakAliveParticles(numSystems);
+	nctl::Array<unsigned int> numEmissions(numSystems);
+	nctl::Array<float> lastEmissionTimes(numSystems);
+	for (unsigned int i = 0; i < numSystems; i++)
+	{
+		peakAliveParticles.pushBack(0);
+		numEmissions.pushBack(0);
+		lastEmissionTimes.pushBack(0.0f);
+	}
+
+	// Every step emits with the rules of `emitParticles()` on the simulated clock, then updates the scene
+	for (unsigned int step = 0; step < numSteps; step++)
+	{
+		const float time = step * settings.timeStep;
+		for (unsigned int i = 0; i < numSystems; i++)
+		{
+			const ParticleSystemGuiState &s = sysStates_[i];
+			if (s.active && s.continuousEmission)
+			{
+				// Steps shorter than the emission period do not always emit
+				if (emitContinuousParticles(i, settings.timeStep) > 0)
+					numEmissions[i]++;
+			}
+			else if (s.active && (s.emitDelay == 0.0f || (s.emitDelay > 0.0f && time - lastEmissionTimes[i] > s.emitDelay)))
+			{
+				emitSeededParticles(i, s.init);
+				lastEmissionTimes[i] = time;
+				numEmissions[i]++;
+			}
+		}
+
+		const nc::TimeStamp updateStartTime = nc::TimeStamp::now();
+		dummy_->update(settings.timeStep);
+		stepTimes.pushBack(updateStartTime.millisecondsSince());
+
+		for (unsigned int i = 0; i < numSystems; i++)
+		{
+			const unsigned int numAlive = particleSystems_[i]->numAliveParticles();
+			aliveParticles.pushBack(numAlive);
+			if (peakAliveParticles[i] < numAlive)
+				peakAliveParticles[i] = numAlive;
+		}
+	}
+
+	float totalTime = 0.0f;
+	float minTime = stepTimes[0];
+	float maxTime = stepTimes[0];
+	for (unsigned int i = 0; i < numSteps; i++)
+	{
+		totalTime += stepTimes[i];
+		if (minTime > stepTimes[i])
+			minTime = stepTimes[i];
+		if (maxTime < stepTimes[i])
+			maxTime = stepTimes[i];
+	}
+
+	BufferedWriter file(settings.outputFile.data());
+	if (file.isOpened() == false)
+	{
+		fprintf(stderr, "Cannot save simulation report \"%s\"\n", settings.outputFile.data());
+		return false;
+	}
+
+	file.append("{\n\t\"project\": ");
+	appendJsonString(file, projectFile.data());
+	file.formatAppend(",\n\t\"seconds\": %s,\n", FloatString(settings.seconds).data());
+	file.formatAppend("\t\"time_step\": %s,\n", FloatString(settings.timeStep).data());
+	file.formatAppend("\t\"num_steps\": %u,\n", numSteps);
+	file.formatAppend("\t\"update_ms\": {\"total\": %s, \"mean\": %s, \"min\": %s, \"max\": %s},\n", FloatString(totalTime).data(),
+	                  FloatString(totalTime / numSteps).data(), FloatString(minTime).data(), FloatString(maxTime).data());
+
+	file.append("\t\"step_update_ms\": [");
+	for (unsigned int i = 0; i < numSteps; i++)
+		file.formatAppend("%s%s", FloatString(stepTimes[i]).data(), (i + 1 < numSteps) ? ", " : "");
+	file.append("],\n");
+
+	file.append("\t\"systems\":\n\t[\n");
+	for (unsigned int i = 0; i < numSystems; i++)
+	{
+		const unsigned int poolSize = particleSystems_[i]->numParticles();
+		file.append("\t\t{\n\t\t\t\"name\": ");
+		appendJsonString(file, sysStates_[i].name.data());
+		file.formatAppend(",\n\t\t\t\"random_seed\": %u,\n", sysStates_[i].randomSeed);
+		file.formatAppend("\t\t\t\"pool_size\": %u,\n", poolSize);
+		file.formatAppend("\t\t\t\"peak_alive\": %u,\n", peakAliveParticles[i]);
+		file.formatAppend("\t\t\t\"peak_pool_usage\": %s,\n", FloatString((poolSize > 0) ? peakAliveParticles[i] / static_cast<float>(poolSize) : 0.0f).data());
+		file.formatAppend("\t\t\t\"emissions\": %u,\n", numEmissions[i]);
+		file.append("\t\t\t\"alive\": [");
+		for (unsigned int step = 0; step < numSteps; step++)
+			file.formatAppend("%u%s", aliveParticles[step * numSystems + i], (step + 1 < numSteps) ? ", " : "");
+		file.formatAppend("]\n\t\t}%s\n", (i + 1 < numSystems) ? "," : "");
+	}
+	file.append("\t]\n}\n");
+	if (file.close() == false)
+	{
+		fprintf(stderr, "Cannot save simulation report \"%s\"\n", settings.outputFile.data());
+		return false;
+	}
+
+	printf("Simulated %u systems for %u steps of %.4f s: %.3f ms of updates (%.4f ms mean, %.4f ms max)\n",
+	       numSystems, numSteps, settings.timeStep, totalTime, totalTime / numSteps, maxTime);
+	printf("Saved simulation report \"%s\"\n", settings.outputFile.data());
+	return true;
+}
@@ -0,0 +1,493 @@
+#include <cstdint>
+#include <cstring>
+
+#include "particle_editor_soa.h"
+
+#if defined(__AVX2__)
+	#include <immintrin.h>
+	#define SOA_WITH_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define SOA_WITH_SSE 1
+#endif
+
+namespace {
+
+/// Channels are aligned for the widest vector and padded to a multiple of its width
+const unsigned int ChannelAlignment = 32;
+const unsigned int MaxSimdWidth = 8;
+/// Colors have the most components of all affector values
+const unsigned int MaxComponents = 4;
+
+#if SOA_WITH_AVX2
+typedef __m256 SimdFloat;
+inline SimdFloat simdLoad(const float *p) { return _mm256_load_ps(p); }
+inline void simdStore(float *p, SimdFloat a) { _mm256_store_ps(p, a); }
+inline SimdFloat simdSet(float a) { return _mm256_set1_ps(a); }
+inline SimdFloat simdAdd(SimdFloat a, SimdFloat b) { return _mm256_add_ps(a, b); }
+inline SimdFloat simdSub(SimdFloat a, SimdFloat b) { return _mm256_sub_ps(a, b); }
+inline SimdFloat simdMul(SimdFloat a, SimdFloat b) { return _mm256_mul_ps(a, b); }
+inline SimdFloat simdMin(SimdFloat a, SimdFloat b) { return _mm256_min_ps(a, b); }
+inline SimdFloat simdGreaterEqual(SimdFloat a, SimdFloat b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+/// Takes the lanes of `a` where the mask is set and the ones of `b` elsewhere
+inline SimdFloat simdSelect(SimdFloat mask, SimdFloat a, SimdFloat b) { return _mm256_blendv_ps(b, a, mask); }
+inline bool simdAny(SimdFloat mask) { return _mm256_movemask_ps(mask) != 0; }
+const unsigned int VectorWidth = 8;
+#elif SOA_WITH_SSE
+typedef __m128 SimdFloat;
+inline SimdFloat simdLoad(const float *p) { return _mm_load_ps(p); }
+inline void simdStore(float *p, SimdFloat a) { _mm_store_ps(p, a); }
+inline SimdFloat simdSet(float a) { return _mm_set1_ps(a); }
+inline SimdFloat simdAdd(SimdFloat a, SimdFloat b) { return _mm_add_ps(a, b); }
+inline SimdFloat simdSub(SimdFloat a, SimdFloat b) { return _mm_sub_ps(a, b); }
+inline SimdFloat simdMul(SimdFloat a, SimdFloat b) { return _mm_mul_ps(a, b); }
+inline SimdFloat simdMin(SimdFloat a, SimdFloat b) { return _mm_min_ps(a, b); }
+inline SimdFloat simdGreaterEqual(SimdFloat a, SimdFloat b) { return _mm_cmpge_ps(a, b); }
+inline SimdFloat simdSelect(SimdFloat mask, SimdFloat a, SimdFloat b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+inline bool simdAny(SimdFloat mask) { return _mm_movemask_ps(mask) != 0; }
+const unsigned int VectorWidth = 4;
+#else
+const unsigned int VectorWidth = 1;
+#endif
+
+unsigned int roundUp(unsigned int value, unsigned int multiple)
+{
+	return (value + multiple - 1) / multiple * multiple;
+}
+
+/// Every step after the first one overrides the value of the particles that reached its age
+void interpolateScalar(const float *stepAges, const float *invLengths, const float *values, const float *deltas, unsigned int numSteps,
+                       unsigned int numComponents, const float *ages, float *const *outs, unsigned int count, bool accumulate)
+{
+	for (unsigned int i = 0; i < count; i++)
+	{
+		// Steps are sorted by age, the search stops at the first one not reached yet
+		const float age = ages[i];
+		unsigned int k = 0;
+		float t = 0.0f;
+		while (k + 1 < numSteps && age >= stepAges[k + 1])
+			k++;
+		if (k + 1 < numSteps && age >= stepAges[k])
+		{
+			t = (age - stepAges[k]) * invLengths[k];
+			if (t > 1.0f)
+				t = 1.0f;
+		}
+
+		for (unsigned int c = 0; c < numComponents; c++)
+		{
+			const unsigned int index = c * numSteps + k;
+			const float value = values[index] + deltas[index] * t;
+			outs[c][i] = accumulate ? outs[c][i] + value : value;
+		}
+	}
+}
+
+#if SOA_WITH_AVX2 || SOA_WITH_SSE
+/// The comparison and the interpolation factor of every step are shared by all the components
+template <unsigned int NumComponents>
+void interpolateSimd(const float *stepAges, const float *invLengths, const float *values, const float *deltas,
+                     unsigned int numSteps, const float *ages, float *const *outs, unsigned int count, bool accumulate)
+{
+	const SimdFloat one = simdSet(1.0f);
+	for (unsigned int i = 0; i < count; i += VectorWidth)
+	{
+		const SimdFloat age = simdLoad(ages + i);
+		SimdFloat value[NumComponents];
+		for (unsigned int c = 0; c < NumComponents; c++)
+			value[c] = simdSet(values[c * numSteps]);
+
+		for (unsigned int k = 0; k + 1 < numSteps; k++)
+		{
+			const SimdFloat stepAge = simdSet(stepAges[k]);
+			const SimdFloat mask = simdGreaterEqual(age, stepAge);
+			// Steps are sorted by age, none of the following ones has been reached either
+			if (simdAny(mask) == false)
+				break;
+			const SimdFloat t = simdMin(simdMul(simdSub(age, stepAge), simdSet(invLengths[k])), one);
+			for (unsigned int c = 0; c < NumComponents; c++)
+			{
+				const unsigned int index = c * numSteps + k;
+				const SimdFloat stepValue = simdAdd(simdSet(values[index]), simdMul(simdSet(deltas[index]), t));
+				value[c] = simdSelect(mask, stepValue, value[c]);
+			}
+		}
+
+		for (unsigned int c = 0; c < NumComponents; c++)
+			simdStore(outs[c] + i, accumulate ? simdAdd(simdLoad(outs[c] + i), value[c]) : value[c]);
+	}
+}
+
+/// Dispatches to a kernel that keeps all the components in registers
+void interpolateSimd(const float *stepAges, const float *invLengths, const float *values, const float *deltas, unsigned int numSteps,
+                     unsigned int numComponents, const float *ages, float *const *outs, unsigned int count, bool accumulate)
+{
+	switch (numComponents)
+	{
+		case 1: interpolateSimd<1>(stepAges, invLengths, values, deltas, numSteps, ages, outs, count, accumulate); break;
+		case 2: interpolateSimd<2>(stepAges, invLengths, values, deltas, numSteps, ages, outs, count, accumulate); break;
+		default: interpolateSimd<4>(stepAges, invLengths, values, deltas, numSteps, ages, outs, count, accumulate); break;
+	}
+}
+#endif
+
+/// One load per component from the sample nearest to the age of every particle
+void lookupScalar(const float *samples, unsigned int numComponents, const float *ages, float *const *outs, unsigned int count, bool accumulate)
+{
+	for (unsigned int i = 0; i < count; i++)
+	{
+		const unsigned int index = CurveLut::index(ages[i]);
+		for (unsigned int c = 0; c < numComponents; c++)
+		{
+			const float value = samples[c * CurveLut::Resolution + index];
+			outs[c][i] = accumulate ? outs[c][i] + value : value;
+		}
+	}
+}
+
+#if SOA_WITH_AVX2
+/// Computes the indices of eight particles at once and gathers their samples, it matches `CurveLut::index()`
+void lookupGather(const float *samples, unsigned int numComponents, const float *ages, float *const *outs, unsigned int count, bool accumulate)
+{
+	const SimdFloat zero = _mm256_setzero_ps();
+	const SimdFloat one = simdSet(1.0f);
+	const SimdFloat scale = simdSet(static_cast<float>(CurveLut::Resolution - 1));
+	const SimdFloat half = simdSet(0.5f);
+	for (unsigned int i = 0; i < count; i += VectorWidth)
+	{
+		// The maximum returns its second operand when the age is not a number
+		const SimdFloat age = simdMin(_mm256_max_ps(simdLoad(ages + i), zero), one);
+		const __m256i index = _mm256_cvttps_epi32(simdAdd(simdMul(age, scale), half));
+		for (unsigned int c = 0; c < numComponents; c++)
+		{
+			const SimdFloat value = _mm256_i32gather_ps(samples + c * CurveLut::Resolution, index, sizeof(float));
+			simdStore(outs[c] + i, accumulate ? simdAdd(simdLoad(outs[c] + i), value) : value);
+		}
+	}
+}
+#endif
+
+}
+
+const unsigned int SoaParticleSystem::RangeAlignment = MaxSimdWidth;
+#if SOA_WITH_AVX2
+const unsigned int SoaParticleSystem::SimdWidth = 8;
+#elif SOA_WITH_SSE
+const unsigned int SoaParticleSystem::SimdWidth = 4;
+#else
+const unsigned int SoaParticleSystem::SimdWidth = 1;
+#endif
+
+///////////////////////////////////////////////////////////
+// CONSTRUCTORS and DESTRUCTOR
+///////////////////////////////////////////////////////////
+
+SoaParticleSystem::SoaParticleSystem(unsigned int capacity)
+    : capacity_(capacity), numAlive_(0), simdEnabled_(SimdWidth > 1), lutEnabled_(true)
+{
+	const unsigned int channelSize = roundUp(capacity, MaxSimdWidth) * sizeof(float);
+	const unsigned int bufferSize = channelSize * NUM_CHANNELS + ChannelAlignment;
+	buffer_ = nctl::makeUnique<unsigned char[]>(bufferSize);
+	memset(buffer_.get(), 0, bufferSize);
+
+	const uintptr_t address = reinterpret_cast<uintptr_t>(buffer_.get());
+	unsigned char *alignedBuffer = buffer_.get() + (ChannelAlignment - address % ChannelAlignment) % ChannelAlignment;
+	for (unsigned int i = 0; i < NUM_CHANNELS; i++)
+		channels_[i] = reinterpret_cast<float *>(alignedBuffer + i * channelSize);
+}
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+const char *SoaParticleSystem::simdName()
+{
+#if SOA_WITH_AVX2
+	return "AVX2";
+#elif SOA_WITH_SSE
+	return "SSE";
+#else
+	return "scalar";
+#endif
+}
+
+void SoaParticleSystem::setup(const LuaLoader::State::ParticleSystem &system)
+{
+	init_ = system.init;
+	random_.init(system.randomSeed);
+
+	colorCurve_.setSize(system.colorSteps.size(), 4);
+	for (unsigned int i = 0; i < system.colorSteps.size(); i++)
+	{
+		const LuaLoader::State::ColorStep &step = system.colorSteps[i];
+		colorCurve_.ages[i] = step.age;
+		colorCurve_.values[i] = step.color.r();
+		colorCurve_.values[colorCurve_.numSteps + i] = step.color.g();
+		colorCurve_.values[colorCurve_.numSteps * 2 + i] = step.color.b();
+		colorCurve_.values[colorCurve_.numSteps * 3 + i] = step.color.a();
+	}
+	colorCurve_.finalize(system.luts.color);
+
+	// The base scale multiplies every step value once instead of every particle at every update
+	sizeCurve_.setSize(system.sizeSteps.size(), 2);
+	for (unsigned int i = 0; i < system.sizeSteps.size(); i++)
+	{
+		const LuaLoader::State::SizeStep &step = system.sizeSteps[i];
+		sizeCurve_.ages[i] = step.age;
+		sizeCurve_.values[i] = system.sizeStepBaseScale.x * step.scale.x;
+		sizeCurve_.values[sizeCurve_.numSteps + i] = system.sizeStepBaseScale.y * step.scale.y;
+	}
+	sizeCurve_.finalize(system.luts.size);
+
+	rotationCurve_.setSize(system.rotationSteps.size(), 1);
+	for (unsigned int i = 0; i < system.rotationSteps.size(); i++)
+	{
+		rotationCurve_.ages[i] = system.rotationSteps[i].age;
+		rotationCurve_.values[i] = system.rotationSteps[i].angle;
+	}
+	rotationCurve_.finalize(system.luts.rotation);
+
+	positionCurve_.setSize(system.positionSteps.size(), 2);
+	for (unsigned int i = 0; i < system.positionSteps.size(); i++)
+	{
+		const LuaLoader::State::PositionStep &step = system.positionSteps[i];
+		positionCurve_.ages[i] = step.age;
+		positionCurve_.values[i] = step.position.x;
+		positionCurve_.values[positionCurve_.numSteps + i] = step.position.y;
+	}
+	positionCurve_.finalize(system.luts.position);
+
+	velocityCurve_.setSize(system.velocitySteps.size(), 2);
+	for (unsigned int i = 0; i < system.velocitySteps.size(); i++)
+	{
+		const LuaLoader::State::VelocityStep &step = system.velocitySteps[i];
+		velocityCurve_.ages[i] = step.age;
+		velocityCurve_.values[i] = step.velocity.x;
+		velocityCurve_.values[velocityCurve_.numSteps + i] = step.velocity.y;
+	}
+	velocityCurve_.finalize(system.luts.velocity);
+}
+
+void SoaParticleSystem::emitParticles(const nc::ParticleInitializer &init, const nc::Vector2f &emitterPosition)
+{
+	const unsigned int amount = random_.integer(init.rndAmount.x, init.rndAmount.y + 1);
+	for (unsigned int i = 0; i < amount && numAlive_ < capacity_; i++)
+	{
+		const unsigned int index = numAlive_++;
+		const float life = random_.real(init.rndLife.x, init.rndLife.y);
+		channels_[LIFE][index] = life;
+		channels_[INV_STARTING_LIFE][index] = (life > 0.0f) ? 1.0f / life : 0.0f;
+		channels_[NORMALIZED_AGE][index] = 0.0f;
+		channels_[POSITION_X][index] = emitterPosition.x + random_.real(init.rndPositionX.x, init.rndPositionX.y);
+		channels_[POSITION_Y][index] = emitterPosition.y + random_.real(init.rndPositionY.x, init.rndPositionY.y);
+		channels_[VELOCITY_X][index] = random_.real(init.rndVelocityX.x, init.rndVelocityX.y);
+		channels_[VELOCITY_Y][index] = random_.real(init.rndVelocityY.x, init.rndVelocityY.y);
+		// The emitter is never rotated, its rotation would be zero
+		channels_[ROTATION][index] = init.emitterRotation ? 0.0f : random_.real(init.rndRotation.x, init.rndRotation.y);
+		channels_[COLOR_R][index] = 1.0f;
+		channels_[COLOR_G][index] = 1.0f;
+		channels_[COLOR_B][index] = 1.0f;
+		channels_[COLOR_A][index] = 1.0f;
+		channels_[SCALE_X][index] = 1.0f;
+		channels_[SCALE_Y][index] = 1.0f;
+	}
+}
+
+void SoaParticleSystem::killParticles()
+{
+	numAlive_ = 0;
+}
+
+void SoaParticleSystem::update(float interval)
+{
+	if (numAlive_ == 0)
+		return;
+
+	// The padding lanes after the last alive particle are processed but never read
+	updateRange(interval, 0, paddedCount());
+	removeDeadParticles();
+}
+
+unsigned int SoaParticleSystem::paddedCount() const
+{
+	return roundUp(numAlive_, MaxSimdWidth);
+}
+
+void SoaParticleSystem::updateRange(float interval, unsigned int first, unsigned int count)
+{
+	const float *life = channels_[LIFE] + first;
+	const float *invStartingLife = channels_[INV_STARTING_LIFE] + first;
+	float *normalizedAge = channels_[NORMALIZED_AGE] + first;
+	for (unsigned int i = 0; i < count; i++)
+		normalizedAge[i] = 1.0f - life[i] * invStartingLife[i];
+
+	interpolate(colorCurve_, COLOR_R, false, first, count);
+	interpolate(sizeCurve_, SCALE_X, false, first, count);
+	interpolate(rotationCurve_, ROTATION, false, first, count);
+	// Like their `nc::ParticleAffector` counterparts, the position and velocity steps are added every update
+	interpolate(positionCurve_, POSITION_X, true, first, count);
+	interpolate(velocityCurve_, VELOCITY_X, true, first, count);
+
+	float *positionX = channels_[POSITION_X] + first;
+	float *positionY = channels_[POSITION_Y] + first;
+	const float *velocityX = channels_[VELOCITY_X] + first;
+	const float *velocityY = channels_[VELOCITY_Y] + first;
+	float *lifeLeft = channels_[LIFE] + first;
+	for (unsigned int i = 0; i < count; i++)
+	{
+		lifeLeft[i] -= interval;
+		positionX[i] += velocityX[i] * interval;
+		positionY[i] += velocityY[i] * interval;
+	}
+}
+
+void SoaParticleSystem::removeDeadParticles()
+{
+	// The last alive particle fills the hole, the order of the particles is not preserved
+	unsigned int i = 0;
+	while (i < numAlive_)
+	{
+		if (channels_[LIFE][i] > 0.0f)
+		{
+			i++;
+			continue;
+		}
+
+		numAlive_--;
+		for (unsigned int c = 0; c < NUM_CHANNELS; c++)
+			channels_[c][i] = channels_[c][numAlive_];
+		// Padding lanes keep finite values for the kernels
+		channels_[LIFE][numAlive_] = 0.0f;
+		channels_[VELOCITY_X][numAlive_] = 0.0f;
+		channels_[VELOCITY_Y][numAlive_] = 0.0f;
+	}
+}
+
+///////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+///////////////////////////////////////////////////////////
+
+void SoaParticleSystem::Curve::setSize(unsigned int steps, unsigned int components)
+{
+	numSteps = steps;
+	numComponents = components;
+	ages.clear();
+	invLengths.clear();
+	values.clear();
+	deltas.clear();
+	for (unsigned int i = 0; i < steps; i++)
+	{
+		ages.pushBack(0.0f);
+		invLengths.pushBack(0.0f);
+	}
+	for (unsigned int i = 0; i < steps * components; i++)
+	{
+		values.pushBack(0.0f);
+		deltas.pushBack(0.0f);
+	}
+}
+
+void SoaParticleSystem::Curve::finalize(const CurveLut &loadedLut)
+{
+	for (unsigned int i = 0; i < numSteps; i++)
+	{
+		const float length = (i + 1 < numSteps) ? ages[i + 1] - ages[i] : 0.0f;
+		invLengths[i] = (length > 0.0f) ? 1.0f / length : 0.0f;
+	}
+
+	for (unsigned int c = 0; c < numComponents; c++)
+	{
+		const float *componentValues = values.data() + c * numSteps;
+		float *componentDeltas = deltas.data() + c * numSteps;
+		for (unsigned int i = 0; i < numSteps; i++)
+			componentDeltas[i] = (i + 1 < numSteps) ? componentValues[i + 1] - componentValues[i] : 0.0f;
+	}
+
+	if (numSteps > 0 && loadedLut.numComponents() == numComponents)
+		lut = loadedLut;
+	else
+		lut.bake(ages.data(), values.data(), numSteps, numComponents);
+}
+
+void SoaParticleSystem::interpolate(const Curve &curve, Channel firstChannel, bool accumulate, unsigned int first, unsigned int count)
+{
+	if (curve.numSteps == 0)
+		return;
+
+	float *outs[MaxComponents];
+	for (unsigned int c = 0; c < curve.numComponents; c++)
+		outs[c] = channels_[firstChannel + c] + first;
+	const float *ages = channels_[NORMALIZED_AGE] + first;
+
+	if (lutEnabled_)
+	{
+#if SOA_WITH_AVX2
+		if (simdEnabled_)
+		{
+			lookupGather(curve.lut.data(0), curve.numComponents, ages, outs, count, accumulate);
+			return;
+		}
+#endif
+		lookupScalar(curve.lut.data(0), curve.numComponents, ages, outs, count, accumulate);
+		return;
+	}
+
+#if SOA_WITH_AVX2 || SOA_WITH_SSE
+	if (simdEnabled_)
+	{
+		interpolateSimd(curve.ages.data(), curve.invLengths.data(), curve.values.data(), curve.deltas.data(),
+		                curve.numSteps, curve.numComponents, ages, outs, count, accumulate);
+		return;
+	}
+#endif
+	interpolateScalar(curve.ages.data(), curve.invLengths.data(), curve.values.data(), curve.deltas.data(),
+	                  curve.numSteps, curve.numComponents, ages, outs, count, accumulate);
+}
+
+///////////////////////////////////////////////////////////
+// CONSTRUCTORS and DESTRUCTOR
+///////////////////////////////////////////////////////////
+
+SoaUpdateStage::SoaUpdateStage(JobPool &pool)
+    : pool_(pool), ranges_(64), systems_(nullptr), interval_(0.0f)
+{
+}
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+void SoaUpdateStage::update(SoaParticleSystem *const *systems, unsigned int numSystems, float interval)
+{
+	static_assert(RangeSize % MaxSimdWidth == 0, "Ranges must start on an aligned particle");
+
+	ranges_.clear();
+	for (unsigned int i = 0; i < numSystems; i++)
+	{
+		const unsigned int count = systems[i]->paddedCount();
+		for (unsigned int first = 0; first < count; first += RangeSize)
+			ranges_.pushBack({ systems[i], first, (count - first < RangeSize) ? count - first : RangeSize });
+	}
+
+	systems_ = systems;
+	interval_ = interval;
+	pool_.run(updateRangeJob, this, ranges_.size());
+	pool_.run(removeDeadParticlesJob, this, numSystems);
+}
+
+///////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+///////////////////////////////////////////////////////////
+
+void SoaUpdateStage::updateRangeJob(void *userData, unsigned int jobIndex)
+{
+	SoaUpdateStage *stage = static_cast<SoaUpdateStage *>(userData);
+	const Range &range = stage->ranges_[jobIndex];
+	range.system->updateRange(stage->interval_, range.first, range.count);
+}
+
+void SoaUpdateStage::removeDeadParticlesJob(void *userData, unsigned int jobIndex)
+{
+	SoaUpdateStage *stage = static_cast<SoaUpdateStage *>(userData);
+	stage->systems_[jobIndex]->removeDeadParticles();
+}
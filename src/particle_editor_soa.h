@@ -0,0 +1,156 @@
+#ifndef CLASS_SOAPARTICLESYSTEM
+#define CLASS_SOAPARTICLESYSTEM
+
+#include <nctl/Array.h>
+#include <nctl/UniquePtr.h>
+#include <ncine/Vector2.h>
+#include <ncine/ParticleInitializer.h>
+#include "particle_editor_lua.h"
+#include "particle_editor_lut.h"
+#include "particle_editor_jobpool.h"
+#include "particle_editor_random.h"
+
+/// A particle system that stores every particle property in a separate aligned array
+/*! Alive particles are kept at the beginning of the arrays. The affector kernels interpolate
+ *  the steps of four or eight particles at once with SSE or AVX2, or one at a time when
+ *  neither is available. It follows the update order of `nc::ParticleSystem` without rendering. */
+class SoaParticleSystem
+{
+  public:
+	/// Number of particles processed by one iteration of the vector kernels
+	static const unsigned int SimdWidth;
+	/// Name of the instruction set used by the vector kernels
+	static const char *simdName();
+	/// The first particle of a range passed to `updateRange()` must be a multiple of this value
+	static const unsigned int RangeAlignment;
+
+	explicit SoaParticleSystem(unsigned int capacity);
+
+	inline unsigned int capacity() const { return capacity_; }
+	inline unsigned int numAliveParticles() const { return numAlive_; }
+	inline bool isSimdEnabled() const { return simdEnabled_; }
+	/// Selects the vector kernels or the scalar ones, to compare them
+	inline void setSimdEnabled(bool simdEnabled) { simdEnabled_ = simdEnabled; }
+	inline bool isLutEnabled() const { return lutEnabled_; }
+	/// Evaluates the affectors with their baked curves or by interpolating their steps, to compare them
+	inline void setLutEnabled(bool lutEnabled) { lutEnabled_ = lutEnabled; }
+
+	/// Copies the steps, the base scale, the initializer and the random seed of a project particle system
+	/*! The curves loaded from a binary project are used when available, otherwise they are baked from the steps */
+	void setup(const LuaLoader::State::ParticleSystem &system);
+	inline const nc::ParticleInitializer &init() const { return init_; }
+	/// Emissions draw from this stream, restarting it repeats them
+	inline CounterRandom &random() { return random_; }
+
+	/// Emits particles around the emitter position until the arrays are full
+	void emitParticles(const nc::ParticleInitializer &init, const nc::Vector2f &emitterPosition);
+	void killParticles();
+	/// Applies the affectors, integrates velocities and removes the dead particles
+	void update(float interval);
+	/// Returns the number of elements the kernels process, alive particles rounded up to the range alignment
+	unsigned int paddedCount() const;
+	/// Applies the affectors and integrates velocities of a range of particles, ranges can be updated in parallel
+	void updateRange(float interval, unsigned int first, unsigned int count);
+	/// Removes the particles that died, it follows the update of all the ranges
+	void removeDeadParticles();
+
+	inline nc::Vector2f position(unsigned int index) const { return nc::Vector2f(channels_[POSITION_X][index], channels_[POSITION_Y][index]); }
+	inline float life(unsigned int index) const { return channels_[LIFE][index]; }
+	inline float rotation(unsigned int index) const { return channels_[ROTATION][index]; }
+
+  private:
+	enum Channel
+	{
+		POSITION_X,
+		POSITION_Y,
+		VELOCITY_X,
+		VELOCITY_Y,
+		LIFE,
+		INV_STARTING_LIFE,
+		NORMALIZED_AGE,
+		COLOR_R,
+		COLOR_G,
+		COLOR_B,
+		COLOR_A,
+		SCALE_X,
+		SCALE_Y,
+		ROTATION,
+		NUM_CHANNELS
+	};
+
+	/// The steps of an affector, stored as one array per value component
+	struct Curve
+	{
+		unsigned int numSteps = 0;
+		unsigned int numComponents = 1;
+		nctl::Array<float> ages;
+		/// Inverse of the distance from every step to the next one, zero for coincident steps
+		nctl::Array<float> invLengths;
+		/// The values of the first component of every step, followed by the second one and so on
+		nctl::Array<float> values;
+		/// The difference between every value and the next one
+		nctl::Array<float> deltas;
+		/// The steps sampled over the normalized age
+		CurveLut lut;
+
+		void setSize(unsigned int steps, unsigned int components);
+		/// Computes the inverse lengths and the deltas once all ages and values are set, then bakes or copies the curve
+		void finalize(const CurveLut &loadedLut);
+	};
+
+	unsigned int capacity_;
+	unsigned int numAlive_;
+	bool simdEnabled_;
+	bool lutEnabled_;
+	nc::ParticleInitializer init_;
+	CounterRandom random_;
+
+	/// A single allocation that holds all channels, each one starts on an aligned boundary
+	nctl::UniquePtr<unsigned char[]> buffer_;
+	float *channels_[NUM_CHANNELS];
+
+	Curve colorCurve_;
+	Curve sizeCurve_;
+	Curve rotationCurve_;
+	Curve positionCurve_;
+	Curve velocityCurve_;
+
+	/// Evaluates all components of a curve for a range of particles and writes them, or adds them, to consecutive channels
+	void interpolate(const Curve &curve, Channel firstChannel, bool accumulate, unsigned int first, unsigned int count);
+};
+
+/// Updates many structure of arrays particle systems on the threads of a job pool
+/*! Large systems are split in ranges of particles, each range being a job. Dead particles are
+ *  removed in a second batch, one job per system, after all ranges are updated. Emission is left
+ *  to the caller, before or after `update()`, so particles are created in the same order with any
+ *  number of threads and the results do not depend on it. */
+class SoaUpdateStage
+{
+  public:
+	/// Maximum number of particles updated by a single job
+	static const unsigned int RangeSize = 4096;
+
+	explicit SoaUpdateStage(JobPool &pool);
+
+	void update(SoaParticleSystem *const *systems, unsigned int numSystems, float interval);
+
+	inline unsigned int numRangeJobs() const { return ranges_.size(); }
+
+  private:
+	struct Range
+	{
+		SoaParticleSystem *system;
+		unsigned int first;
+		unsigned int count;
+	};
+
+	JobPool &pool_;
+	nctl::Array<Range> ranges_;
+	SoaParticleSystem *const *systems_;
+	float interval_;
+
+	static void updateRangeJob(void *userData, unsigned int jobIndex);
+	static void removeDeadParticlesJob(void *userData, unsigned int jobIndex);
+};
+
+#endif
@@ -0,0 +1,281 @@
+#ifndef CLASS_STEPCURVES
+#define CLASS_STEPCURVES
+
+#include <cstdint>
+#include <cstring>
+#include <nctl/Array.h>
+#include <nctl/HashMap.h>
+#include <nctl/UniquePtr.h>
+#include <ncine/ParticleAffectors.h>
+#include "particle_editor_hashmaps.h"
+
+namespace nc = ncine;
+
+namespace StepHash {
+
+const uint64_t Offset = 0xcbf29ce484222325ull;
+const uint64_t Prime = 0x100000001b3ull;
+
+/// FNV-1a hash of a block of memory, continuing from the specified hash
+inline uint64_t hashBytes(const void *data, unsigned int numBytes, uint64_t hash)
+{
+	const unsigned char *bytes = static_cast<const unsigned char *>(data);
+	for (unsigned int i = 0; i < numBytes; i++)
+	{
+		hash ^= bytes[i];
+		hash *= Prime;
+	}
+	return hash;
+}
+
+}
+
+/// Immutable step curves shared by the affectors of the particle systems
+/*! Every curve is an affector of the engine that is never attached to a system, it has a content hash
+ *  and a reference count of the particle systems using it. Curves with the same steps are stored once. */
+template <class T>
+class StepCurves
+{
+  public:
+	StepCurves();
+
+	inline unsigned int size() const { return entries_.size(); }
+	/// Returns the total number of references, more than the size when some curves are shared
+	unsigned int numReferences() const;
+
+	/// Stores a curve and acquires it, unless a curve with the same steps is already stored and acquired instead
+	T *share(nctl::UniquePtr<T> curve);
+	/// Increments the reference count of a curve
+	void acquire(const T *curve);
+	/// Decrements the reference count of a curve, it is destroyed when it reaches zero
+	void release(const T *curve);
+	/// Returns a curve with the same steps that only the caller references, so that it can be edited
+	/*! The reference to the shared curve is released and the one to the returned curve acquired. */
+	T *detach(T *curve);
+
+  private:
+	struct Entry
+	{
+		nctl::UniquePtr<T> curve;
+		uint64_t hash = 0;
+		unsigned int refCount = 0;
+		/// False if the curve might have been edited after the hash was computed
+		bool hashed = false;
+	};
+
+	nctl::Array<Entry> entries_;
+	nctl::HashMap<const T *, unsigned int> curveIndices_;
+	/// The index of a hashed curve for every hash, a colliding curve with different steps is not indexed
+	nctl::HashMap<uint64_t, unsigned int> hashIndices_;
+
+	unsigned int add(nctl::UniquePtr<T> curve);
+	void removeAt(unsigned int index);
+	void unhash(unsigned int index);
+};
+
+/// The affector of a particle system that applies the steps of a shared curve
+/*! The engine owns the affectors of a system, this one keeps a reference to its curve until destroyed. */
+template <class T>
+class SharedAffector : public T
+{
+  public:
+	/// The curve should have already been acquired for this affector
+	SharedAffector(StepCurves<T> &curves, T *curve)
+	    : curves_(curves), curve_(curve) {}
+	~SharedAffector() override { curves_.release(curve_); }
+
+	void affect(nc::Particle *particle, float normalizedAge) override { curve_->affect(particle, normalizedAge); }
+
+	inline T *curve() const { return curve_; }
+	/// Returns the curve after making it editable, it is copied if other systems share it
+	inline T *edit() { curve_ = curves_.detach(curve_); return curve_; }
+	/// Replaces the curve with a new one, that is shared if another curve has the same steps
+	inline T *replace(nctl::UniquePtr<T> curve)
+	{
+		curves_.release(curve_);
+		curve_ = curves_.share(nctl::move(curve));
+		return curve_;
+	}
+
+  private:
+	StepCurves<T> &curves_;
+	T *curve_;
+};
+
+///////////////////////////////////////////////////////////
+// STEPS of every affector type
+///////////////////////////////////////////////////////////
+
+/// The steps are plain floating point values, they are hashed and compared as memory
+template <class T>
+inline uint64_t hashSteps(const T &curve)
+{
+	return StepHash::hashBytes(curve.steps().data(), curve.steps().size() * sizeof(curve.steps()[0]), StepHash::Offset);
+}
+
+inline uint64_t hashSteps(const nc::SizeAffector &curve)
+{
+	const nc::Vector2f baseScale = curve.baseScale();
+	const uint64_t hash = StepHash::hashBytes(baseScale.data(), sizeof(nc::Vector2f), StepHash::Offset);
+	return StepHash::hashBytes(curve.steps().data(), curve.steps().size() * sizeof(curve.steps()[0]), hash);
+}
+
+template <class T>
+inline bool sameSteps(const T &first, const T &second)
+{
+	return first.steps().size() == second.steps().size() && (first.steps().isEmpty() ||
+	       memcmp(first.steps().data(), second.steps().data(), first.steps().size() * sizeof(first.steps()[0])) == 0);
+}
+
+inline bool sameSteps(const nc::SizeAffector &first, const nc::SizeAffector &second)
+{
+	const nc::Vector2f firstScale = first.baseScale();
+	const nc::Vector2f secondScale = second.baseScale();
+	return firstScale.x == secondScale.x && firstScale.y == secondScale.y &&
+	       sameSteps<nc::SizeAffector>(first, second);
+}
+
+template <class T>
+inline void copySteps(const T &src, T &dest)
+{
+	for (unsigned int i = 0; i < src.steps().size(); i++)
+		dest.steps()[i] = src.steps()[i];
+}
+
+inline void copySteps(const nc::SizeAffector &src, nc::SizeAffector &dest)
+{
+	dest.setBaseScale(src.baseScale());
+	copySteps<nc::SizeAffector>(src, dest);
+}
+
+///////////////////////////////////////////////////////////
+// CONSTRUCTORS and DESTRUCTOR
+///////////////////////////////////////////////////////////
+
+template <class T>
+StepCurves<T>::StepCurves()
+    : entries_(8), curveIndices_(16), hashIndices_(16)
+{
+}
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+template <class T>
+unsigned int StepCurves<T>::numReferences() const
+{
+	unsigned int numReferences = 0;
+	for (unsigned int i = 0; i < entries_.size(); i++)
+		numReferences += entries_[i].refCount;
+	return numReferences;
+}
+
+template <class T>
+T *StepCurves<T>::share(nctl::UniquePtr<T> curve)
+{
+	const uint64_t hash = hashSteps(*curve);
+	const unsigned int *hashIndex = hashIndices_.find(hash);
+	if (hashIndex != nullptr && sameSteps(*entries_[*hashIndex].curve, *curve))
+	{
+		entries_[*hashIndex].refCount++;
+		return entries_[*hashIndex].curve.get();
+	}
+	const bool isHashFree = (hashIndex == nullptr);
+
+	const unsigned int index = add(nctl::move(curve));
+	Entry &entry = entries_[index];
+	entry.hash = hash;
+	entry.refCount = 1;
+	if (isHashFree)
+	{
+		entry.hashed = true;
+		hashIndices_.insert(hash, index);
+	}
+	return entry.curve.get();
+}
+
+template <class T>
+void StepCurves<T>::acquire(const T *curve)
+{
+	const unsigned int *index = curveIndices_.find(curve);
+	FATAL_ASSERT(index != nullptr);
+	entries_[*index].refCount++;
+}
+
+template <class T>
+void StepCurves<T>::release(const T *curve)
+{
+	const unsigned int *index = curveIndices_.find(curve);
+	FATAL_ASSERT(index != nullptr);
+	FATAL_ASSERT(entries_[*index].refCount > 0);
+	if (--entries_[*index].refCount == 0)
+		removeAt(*index);
+}
+
+template <class T>
+T *StepCurves<T>::detach(T *curve)
+{
+	const unsigned int *index = curveIndices_.find(curve);
+	FATAL_ASSERT(index != nullptr);
+	if (entries_[*index].refCount == 1)
+	{
+		// The only user can edit the curve in place, but its hash will not match anymore
+		unhash(*index);
+		return curve;
+	}
+
+	entries_[*index].refCount--;
+	nctl::UniquePtr<T> copy = nctl::makeUnique<T>();
+	copySteps(*curve, *copy);
+	const unsigned int copyIndex = add(nctl::move(copy));
+	entries_[copyIndex].refCount = 1;
+	return entries_[copyIndex].curve.get();
+}
+
+///////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+///////////////////////////////////////////////////////////
+
+template <class T>
+unsigned int StepCurves<T>::add(nctl::UniquePtr<T> curve)
+{
+	HashMaps::reserve(curveIndices_, entries_.size() + 1);
+	HashMaps::reserve(hashIndices_, entries_.size() + 1);
+
+	const unsigned int index = entries_.size();
+	curveIndices_.insert(curve.get(), index);
+	entries_.emplaceBack();
+	entries_.back().curve = nctl::move(curve);
+	return index;
+}
+
+/*! The last curve takes the place of the removed one */
+template <class T>
+void StepCurves<T>::removeAt(unsigned int index)
+{
+	unhash(index);
+	curveIndices_.remove(entries_[index].curve.get());
+
+	const unsigned int lastIndex = entries_.size() - 1;
+	if (index != lastIndex)
+	{
+		entries_[index] = nctl::move(entries_[lastIndex]);
+		curveIndices_[entries_[index].curve.get()] = index;
+		if (entries_[index].hashed)
+			hashIndices_[entries_[index].hash] = index;
+	}
+	entries_.setSize(lastIndex);
+}
+
+template <class T>
+void StepCurves<T>::unhash(unsigned int index)
+{
+	if (entries_[index].hashed)
+	{
+		hashIndices_.remove(entries_[index].hash);
+		entries_[index].hashed = false;
+	}
+}
+
+#endif
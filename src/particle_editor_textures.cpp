@@ -0,0 +1,114 @@
+#include "particle_editor_textures.h"
+#include "particle_editor_hashmaps.h"
+#include <ncine/Texture.h>
+
+namespace {
+
+const unsigned int InitialCapacity = 32;
+
+}
+
+///////////////////////////////////////////////////////////
+// CONSTRUCTORS and DESTRUCTOR
+///////////////////////////////////////////////////////////
+
+TextureRegistry::TextureRegistry()
+    : textures_(4), names_(4), refCounts_(4),
+      nameIndices_(InitialCapacity), textureIndices_(InitialCapacity)
+{
+}
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+unsigned int TextureRegistry::indexOf(const nctl::String &name) const
+{
+	const unsigned int *index = nameIndices_.find(name);
+	return (index != nullptr) ? *index : InvalidIndex;
+}
+
+unsigned int TextureRegistry::indexOf(const nc::Texture *texture) const
+{
+	const unsigned int *index = textureIndices_.find(texture);
+	return (index != nullptr) ? *index : InvalidIndex;
+}
+
+unsigned int TextureRegistry::add(const nctl::String &name, nctl::UniquePtr<nc::Texture> texture)
+{
+	FATAL_ASSERT(indexOf(name) == InvalidIndex);
+
+	HashMaps::reserve(nameIndices_, textures_.size() + 1);
+	HashMaps::reserve(textureIndices_, textures_.size() + 1);
+
+	const unsigned int index = textures_.size();
+	nameIndices_.insert(name, index);
+	textureIndices_.insert(texture.get(), index);
+
+	textures_.pushBack(nctl::move(texture));
+	names_.pushBack(name);
+	refCounts_.pushBack(0);
+
+	return index;
+}
+
+nctl::UniquePtr<nc::Texture> TextureRegistry::remove(unsigned int index)
+{
+	FATAL_ASSERT(index < textures_.size());
+
+	nameIndices_.remove(names_[index]);
+	textureIndices_.remove(textures_[index].get());
+	nctl::UniquePtr<nc::Texture> texture = nctl::move(textures_[index]);
+
+	for (unsigned int i = index; i < textures_.size() - 1; i++)
+	{
+		textures_[i] = nctl::move(textures_[i + 1]);
+		names_[i] = names_[i + 1];
+		refCounts_[i] = refCounts_[i + 1];
+	}
+	textures_.setSize(textures_.size() - 1);
+	names_.setSize(names_.size() - 1);
+	refCounts_.setSize(refCounts_.size() - 1);
+
+	updateIndices(index);
+	return texture;
+}
+
+void TextureRegistry::clear(nctl::Array<nctl::UniquePtr<nc::Texture>> &removedTextures)
+{
+	for (unsigned int i = 0; i < textures_.size(); i++)
+		removedTextures.pushBack(nctl::move(textures_[i]));
+	textures_.clear();
+	names_.clear();
+	refCounts_.clear();
+
+	nameIndices_.clear();
+	textureIndices_.clear();
+}
+
+void TextureRegistry::acquire(const nc::Texture *texture)
+{
+	const unsigned int index = indexOf(texture);
+	if (index != InvalidIndex)
+		refCounts_[index]++;
+}
+
+void TextureRegistry::release(const nc::Texture *texture)
+{
+	const unsigned int index = indexOf(texture);
+	if (index != InvalidIndex && refCounts_[index] > 0)
+		refCounts_[index]--;
+}
+
+///////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+///////////////////////////////////////////////////////////
+
+void TextureRegistry::updateIndices(unsigned int firstIndex)
+{
+	for (unsigned int i = firstIndex; i < textures_.size(); i++)
+	{
+		nameIndices_[names_[i]] = i;
+		textureIndices_[textures_[i].get()] = i;
+	}
+}
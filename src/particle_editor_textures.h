@@ -0,0 +1,65 @@
+#ifndef CLASS_TEXTUREREGISTRY
+#define CLASS_TEXTUREREGISTRY
+
+#include <nctl/Array.h>
+#include <nctl/HashMap.h>
+#include <nctl/String.h>
+#include <nctl/UniquePtr.h>
+
+namespace ncine {
+
+class Texture;
+
+}
+
+namespace nc = ncine;
+
+/// The list of loaded textures, indexed by name and by pointer
+/*! Textures keep the order in which they have been added, as the GUI refers to them by index.
+ *  Every texture has a reference count of the particle systems using it. */
+class TextureRegistry
+{
+  public:
+	static const unsigned int InvalidIndex = ~0u;
+
+	TextureRegistry();
+
+	inline unsigned int size() const { return textures_.size(); }
+	inline bool isEmpty() const { return textures_.isEmpty(); }
+
+	inline nc::Texture *texture(unsigned int index) const { return textures_[index].get(); }
+	inline const nctl::String &name(unsigned int index) const { return names_[index]; }
+	inline unsigned int refCount(unsigned int index) const { return refCounts_[index]; }
+	/// Returns true if at least one particle system is using the texture
+	inline bool isInUse(unsigned int index) const { return refCounts_[index] > 0; }
+
+	/// Returns the index of the texture with the specified name or `InvalidIndex`
+	unsigned int indexOf(const nctl::String &name) const;
+	/// Returns the index of the texture or `InvalidIndex`
+	unsigned int indexOf(const nc::Texture *texture) const;
+
+	/// Appends a texture and returns its index, names are expected to be unique
+	unsigned int add(const nctl::String &name, nctl::UniquePtr<nc::Texture> texture);
+	/// Removes a texture and returns it, the following textures move back by one index
+	nctl::UniquePtr<nc::Texture> remove(unsigned int index);
+	/// Moves all textures to the specified array to delay their destruction
+	void clear(nctl::Array<nctl::UniquePtr<nc::Texture>> &removedTextures);
+
+	/// Increments the reference count of a texture, null pointers are ignored
+	void acquire(const nc::Texture *texture);
+	/// Decrements the reference count of a texture, null pointers are ignored
+	void release(const nc::Texture *texture);
+
+  private:
+	nctl::Array<nctl::UniquePtr<nc::Texture>> textures_;
+	nctl::Array<nctl::String> names_;
+	nctl::Array<unsigned int> refCounts_;
+
+	nctl::StringHashMap<unsigned int> nameIndices_;
+	nctl::HashMap<const nc::Texture *, unsigned int> textureIndices_;
+
+	/// Updates the hash map entries of all the textures from the specified index to the end
+	void updateIndices(unsigned int firstIndex);
+};
+
+#endif
@@ -0,0 +1,136 @@
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+#include "particle_editor_writer.h"
+#include <ncine/IFile.h>
+
+///////////////////////////////////////////////////////////
+// CONSTRUCTORS and DESTRUCTOR
+///////////////////////////////////////////////////////////
+
+BufferedWriter::BufferedWriter(const char *filename)
+    : bufferLength_(0), bytesWritten_(0), closed_(false), failed_(false)
+#ifdef __EMSCRIPTEN__
+      , filename_(filename)
+#endif
+{
+#ifndef __EMSCRIPTEN__
+	fileHandle_ = nc::IFile::createFileHandle(filename);
+	fileHandle_->open(nc::IFile::OpenMode::WRITE | nc::IFile::OpenMode::BINARY);
+	failed_ = (fileHandle_->isOpened() == false);
+#endif
+}
+
+BufferedWriter::~BufferedWriter()
+{
+	close();
+}
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+bool BufferedWriter::isOpened() const
+{
+#ifndef __EMSCRIPTEN__
+	return (closed_ == false && fileHandle_->isOpened());
+#else
+	return (closed_ == false);
+#endif
+}
+
+void BufferedWriter::write(const void *data, unsigned long bytes)
+{
+	const char *src = static_cast<const char *>(data);
+	while (bytes > 0)
+	{
+		if (bufferLength_ == ChunkSize)
+			flush();
+
+		const unsigned long available = ChunkSize - bufferLength_;
+		const unsigned long amount = (bytes < available) ? bytes : available;
+		memcpy(buffer_ + bufferLength_, src, amount);
+		bufferLength_ += amount;
+		src += amount;
+		bytes -= amount;
+	}
+}
+
+BufferedWriter &BufferedWriter::append(const char *string)
+{
+	write(string, strlen(string));
+	return *this;
+}
+
+BufferedWriter &BufferedWriter::formatAppend(const char *fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	const int available = static_cast<int>(ChunkSize - bufferLength_);
+	const int length = vsnprintf(buffer_ + bufferLength_, available, fmt, args);
+	va_end(args);
+
+	if (length < 0)
+		return *this;
+	else if (length < available)
+	{
+		bufferLength_ += length;
+		return *this;
+	}
+
+	// The formatted string did not fit in the remaining space
+	flush();
+	if (length < static_cast<int>(ChunkSize))
+	{
+		va_start(args, fmt);
+		vsnprintf(buffer_, ChunkSize, fmt, args);
+		va_end(args);
+		bufferLength_ = length;
+	}
+	else
+	{
+		nctl::UniquePtr<char[]> longString = nctl::makeUnique<char[]>(length + 1);
+		va_start(args, fmt);
+		vsnprintf(longString.get(), length + 1, fmt, args);
+		va_end(args);
+		write(longString.get(), length);
+	}
+
+	return *this;
+}
+
+bool BufferedWriter::close()
+{
+	if (closed_)
+		return (failed_ == false);
+
+	flush();
+#ifndef __EMSCRIPTEN__
+	fileHandle_->close();
+#else
+	localFile_.save(filename_.data());
+#endif
+	closed_ = true;
+
+	return (failed_ == false);
+}
+
+///////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+///////////////////////////////////////////////////////////
+
+void BufferedWriter::flush()
+{
+	if (bufferLength_ == 0)
+		return;
+
+#ifndef __EMSCRIPTEN__
+	if (fileHandle_->isOpened() == false || fileHandle_->write(buffer_, bufferLength_) != bufferLength_)
+		failed_ = true;
+#else
+	localFile_.write(buffer_, bufferLength_);
+#endif
+	bytesWritten_ += bufferLength_;
+	bufferLength_ = 0;
+}
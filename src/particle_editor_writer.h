@@ -0,0 +1,62 @@
+#ifndef CLASS_BUFFEREDWRITER
+#define CLASS_BUFFEREDWRITER
+
+#include <nctl/UniquePtr.h>
+#include <nctl/String.h>
+
+#ifdef __EMSCRIPTEN__
+	#include <ncine/EmscriptenLocalFile.h>
+#endif
+
+namespace ncine {
+
+class IFile;
+
+}
+
+namespace nc = ncine;
+
+/// A file writer that accumulates data in a fixed-size buffer and flushes it in chunks
+/*! The interface mirrors the appending functions of `nctl::String` so that it can replace one */
+class BufferedWriter
+{
+  public:
+	static const unsigned int ChunkSize = 4096;
+
+	explicit BufferedWriter(const char *filename);
+	~BufferedWriter();
+
+	bool isOpened() const;
+	inline unsigned long bytesWritten() const { return bytesWritten_; }
+
+	void write(const void *data, unsigned long bytes);
+	BufferedWriter &append(const char *string);
+	BufferedWriter &formatAppend(const char *fmt, ...);
+
+	/// Flushes the remaining data and closes the file, returns false if the file was not opened or not all data was written
+	bool close();
+
+  private:
+	char buffer_[ChunkSize];
+	unsigned int bufferLength_;
+	unsigned long bytesWritten_;
+	bool closed_;
+	/// True if the file could not be opened or a flush wrote less than the buffered data
+	bool failed_;
+
+#ifndef __EMSCRIPTEN__
+	nctl::UniquePtr<nc::IFile> fileHandle_;
+#else
+	nc::EmscriptenLocalFile localFile_;
+	nctl::String filename_;
+#endif
+
+	void flush();
+
+	/// Deleted copy constructor
+	BufferedWriter(const BufferedWriter &) = delete;
+	/// Deleted assignment operator
+	BufferedWriter &operator=(const BufferedWriter &) = delete;
+};
+
+#endif
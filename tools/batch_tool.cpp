@@ -0,0 +1,379 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "particle_editor_lua.h"
+#include <nctl/Atomic.h>
+#include <ncine/config.h>
+#include <ncine/TimeStamp.h>
+#include <ncine/FileSystem.h>
+
+#if NCINE_WITH_THREADS
+	#include <ncine/Thread.h>
+#endif
+
+/// A command line tool that validates and converts all the project files in a directory
+/*! It does not create an application, a window or a graphics context.
+ *  Usage: batch_tool <directory> [--threads n] [--textures dir] [--resave | --convert lua|ncpb] [--output dir] */
+
+namespace {
+
+const unsigned int MaxWorkers = 32;
+
+struct Options
+{
+	const char *directory = nullptr;
+	unsigned int numWorkers = 0;
+	const char *texturesPath = nullptr;
+	bool resave = false;
+	/// The extension of converted files, without the dot
+	const char *convertExtension = nullptr;
+	const char *outputPath = nullptr;
+};
+
+struct FileResult
+{
+	nctl::String path = nctl::String(LuaLoader::MaxFilenameLength);
+	/// The path relative to the scanned directory
+	nctl::String relativePath = nctl::String(LuaLoader::MaxFilenameLength);
+	nctl::String savedPath = nctl::String(LuaLoader::MaxFilenameLength);
+
+	bool loaded = false;
+	LuaLoader::LoadMethod loadMethod = LuaLoader::LoadMethod::LUA;
+	unsigned int numSystems = 0;
+	unsigned int numIssues = 0;
+	nctl::String firstIssue = nctl::String(LuaLoader::MaxFilenameLength);
+	bool saved = false;
+
+	float loadTime = 0.0f;
+	float saveTime = 0.0f;
+};
+
+struct Worker
+{
+	const Options *options = nullptr;
+	nctl::Array<FileResult> *results = nullptr;
+	nctl::Atomic32 *nextFile = nullptr;
+	LuaLoader loader;
+#if NCINE_WITH_THREADS
+	nc::Thread thread;
+#endif
+};
+
+void printUsage(const char *executable)
+{
+	printf("Usage: %s <directory> [options]\n\n", executable);
+	printf("Loads, validates and optionally saves again every project file in a directory and its subdirectories.\n\n");
+	printf("  --threads <n>          number of worker threads, the default is the number of processors\n");
+	printf("  --textures <dir>       checks that the textures used by the projects exist in the directory\n");
+	printf("  --resave               saves every valid project again in its own format\n");
+	printf("  --convert <lua|%s>   saves every valid project in the specified format\n", LuaLoader::BinaryExtension);
+	printf("  --output <dir>         writes saved projects in the directory instead of next to the originals\n");
+}
+
+bool parseOptions(int argc, char **argv, Options &options)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		const bool hasValue = (i + 1 < argc);
+		if (strcmp(argv[i], "--threads") == 0 && hasValue)
+			options.numWorkers = static_cast<unsigned int>(atoi(argv[++i]));
+		else if (strcmp(argv[i], "--textures") == 0 && hasValue)
+			options.texturesPath = argv[++i];
+		else if (strcmp(argv[i], "--resave") == 0)
+			options.resave = true;
+		else if (strcmp(argv[i], "--convert") == 0 && hasValue)
+		{
+			options.convertExtension = argv[++i];
+			if (strcmp(options.convertExtension, "lua") != 0 && strcmp(options.convertExtension, LuaLoader::BinaryExtension) != 0)
+				return false;
+		}
+		else if (strcmp(argv[i], "--output") == 0 && hasValue)
+			options.outputPath = argv[++i];
+		else if (argv[i][0] != '-' && options.directory == nullptr)
+			options.directory = argv[i];
+		else
+			return false;
+	}
+
+	if (options.resave && options.convertExtension != nullptr)
+		return false;
+	return (options.directory != nullptr);
+}
+
+bool isProjectFile(const char *filename)
+{
+	return nc::fs::hasExtension(filename, "lua") || LuaLoader::isBinaryProject(filename);
+}
+
+void collectFiles(const char *rootPath, const nctl::String &relativeDir, nctl::Array<FileResult> &results)
+{
+	const nctl::String dirPath = relativeDir.isEmpty() ? nctl::String(rootPath) : nc::fs::joinPath(rootPath, relativeDir);
+	nc::fs::Directory dir(dirPath.data());
+
+	const char *entry = dir.readNext();
+	while (entry != nullptr)
+	{
+		if (strcmp(entry, ".") != 0 && strcmp(entry, "..") != 0)
+		{
+			const nctl::String relativePath = relativeDir.isEmpty() ? nctl::String(entry) : nc::fs::joinPath(relativeDir, entry);
+			const nctl::String path = nc::fs::joinPath(rootPath, relativePath);
+			if (nc::fs::isDirectory(path.data()))
+				collectFiles(rootPath, relativePath, results);
+			else if (isProjectFile(entry))
+			{
+				results.emplaceBack();
+				results.back().path = path;
+				results.back().relativePath = relativePath;
+			}
+		}
+		entry = dir.readNext();
+	}
+	dir.close();
+}
+
+/// Records an issue, only the first one is described
+void addIssue(FileResult &result, const char *description, unsigned int systemIndex)
+{
+	if (result.numIssues == 0)
+		result.firstIssue.format("system #%u: %s", systemIndex, description);
+	result.numIssues++;
+}
+
+template <class Step>
+bool areStepsSorted(const nctl::Array<Step> &steps)
+{
+	for (unsigned int i = 0; i < steps.size(); i++)
+	{
+		if (steps[i].age < 0.0f || steps[i].age > 1.0f)
+			return false;
+		if (i > 0 && steps[i].age < steps[i - 1].age)
+			return false;
+	}
+	return true;
+}
+
+void validate(const LuaLoader::State &state, const Options &options, FileResult &result)
+{
+	if (state.systems.isEmpty())
+	{
+		result.firstIssue = "no particle systems";
+		result.numIssues++;
+	}
+
+	nctl::String texturePath(LuaLoader::MaxFilenameLength);
+	for (unsigned int i = 0; i < state.systems.size(); i++)
+	{
+		const LuaLoader::State::ParticleSystem &s = state.systems[i];
+
+		if (s.numParticles <= 0)
+			addIssue(result, "no particles", i);
+		if (s.textureName.isEmpty())
+			addIssue(result, "no texture name", i);
+		else if (options.texturesPath != nullptr)
+		{
+			texturePath = nc::fs::joinPath(options.texturesPath, s.textureName);
+			if (nc::fs::isReadableFile(texturePath.data()) == false)
+				addIssue(result, "texture not found", i);
+		}
+		if (s.texRect.w <= 0 || s.texRect.h <= 0)
+			addIssue(result, "empty texture rectangle", i);
+
+		if (areStepsSorted(s.colorSteps) == false || areStepsSorted(s.sizeSteps) == false ||
+		    areStepsSorted(s.rotationSteps) == false || areStepsSorted(s.positionSteps) == false ||
+		    areStepsSorted(s.velocitySteps) == false)
+			addIssue(result, "step ages are not sorted between 0 and 1", i);
+
+		if (s.init.rndAmount.x < 0 || s.init.rndAmount.x > s.init.rndAmount.y)
+			addIssue(result, "invalid amount range", i);
+		if (s.init.rndLife.x <= 0.0f || s.init.rndLife.x > s.init.rndLife.y)
+			addIssue(result, "invalid life range", i);
+		if (s.emitDelay < 0.0f)
+			addIssue(result, "negative emission delay", i);
+	}
+}
+
+/// Creates a directory and all its missing parents
+void createDirs(const nctl::String &path)
+{
+	if (path.isEmpty() || nc::fs::isDirectory(path.data()))
+		return;
+
+	const nctl::String parentPath = nc::fs::dirName(path.data());
+	if (parentPath != path)
+		createDirs(parentPath);
+	nc::fs::createDir(path.data());
+}
+
+void replaceExtension(nctl::String &path, const char *extension)
+{
+	const char *dot = strrchr(path.data(), '.');
+	if (dot != nullptr && strchr(dot, '/') == nullptr && strchr(dot, '\\') == nullptr)
+		path.setLength(static_cast<unsigned int>(dot - path.data()));
+	path.formatAppend(".%s", extension);
+}
+
+void processFile(Worker &worker, FileResult &result)
+{
+	const Options &options = *worker.options;
+
+	LuaLoader::State state;
+	const nc::TimeStamp loadStartTime = nc::TimeStamp::now();
+	result.loaded = worker.loader.load(result.path.data(), state);
+	result.loadTime = loadStartTime.millisecondsSince();
+	result.loadMethod = worker.loader.statistics().lastLoadMethod;
+	if (result.loaded == false)
+		return;
+
+	result.numSystems = state.systems.size();
+	validate(state, options, result);
+	if (result.numIssues > 0 || (options.resave == false && options.convertExtension == nullptr))
+		return;
+
+	result.savedPath = (options.outputPath != nullptr) ? nc::fs::joinPath(options.outputPath, result.relativePath) : result.path;
+	if (options.convertExtension != nullptr)
+		replaceExtension(result.savedPath, options.convertExtension);
+
+	const nc::TimeStamp saveStartTime = nc::TimeStamp::now();
+	result.saved = worker.loader.save(result.savedPath.data(), state);
+	result.saveTime = saveStartTime.millisecondsSince();
+}
+
+void workerFunction(void *arg)
+{
+	Worker &worker = *static_cast<Worker *>(arg);
+	const int32_t numFiles = static_cast<int32_t>(worker.results->size());
+
+	int32_t index = worker.nextFile->fetchAdd(1);
+	while (index < numFiles)
+	{
+		processFile(worker, (*worker.results)[index]);
+		index = worker.nextFile->fetchAdd(1);
+	}
+}
+
+const char *loadMethodName(LuaLoader::LoadMethod method)
+{
+	switch (method)
+	{
+		case LuaLoader::LoadMethod::BINARY: return "binary";
+		case LuaLoader::LoadMethod::PARSER: return "parser";
+		case LuaLoader::LoadMethod::LUA: return "Lua";
+	}
+	return "";
+}
+
+}
+
+int main(int argc, char **argv)
+{
+	Options options;
+	if (parseOptions(argc, argv, options) == false)
+	{
+		printUsage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (nc::fs::isDirectory(options.directory) == false)
+	{
+		printf("\"%s\" is not a directory\n", options.directory);
+		return EXIT_FAILURE;
+	}
+
+	nctl::Array<FileResult> results(64);
+	collectFiles(options.directory, nctl::String(), results);
+	if (results.isEmpty())
+	{
+		printf("No project files found in \"%s\"\n", options.directory);
+		return EXIT_SUCCESS;
+	}
+
+	if (options.outputPath != nullptr)
+	{
+		// Output subdirectories are created in advance, workers only write files
+		for (const FileResult &result : results)
+			createDirs(nc::fs::dirName(nc::fs::joinPath(options.outputPath, result.relativePath).data()));
+	}
+
+#if NCINE_WITH_THREADS
+	unsigned int numWorkers = (options.numWorkers > 0) ? options.numWorkers : nc::Thread::numProcessors();
+#else
+	unsigned int numWorkers = 1;
+#endif
+	if (numWorkers > MaxWorkers)
+		numWorkers = MaxWorkers;
+	if (numWorkers > results.size())
+		numWorkers = results.size();
+	if (numWorkers == 0)
+		numWorkers = 1;
+
+	nctl::Atomic32 nextFile(0);
+	nctl::UniquePtr<Worker[]> workers = nctl::makeUnique<Worker[]>(numWorkers);
+	for (unsigned int i = 0; i < numWorkers; i++)
+	{
+		workers[i].options = &options;
+		workers[i].results = &results;
+		workers[i].nextFile = &nextFile;
+		// Lua states are created on the main thread
+		workers[i].loader.createState();
+	}
+
+	const nc::TimeStamp startTime = nc::TimeStamp::now();
+#if NCINE_WITH_THREADS
+	for (unsigned int i = 1; i < numWorkers; i++)
+		workers[i].thread.run(workerFunction, &workers[i]);
+	workerFunction(&workers[0]);
+	for (unsigned int i = 1; i < numWorkers; i++)
+		workers[i].thread.join();
+#else
+	workerFunction(&workers[0]);
+#endif
+	const float totalTime = startTime.millisecondsSince();
+
+	unsigned int numNotLoaded = 0;
+	unsigned int numInvalid = 0;
+	unsigned int numSaved = 0;
+	unsigned int numNotSaved = 0;
+	float workTime = 0.0f;
+
+	printf("%-40s %-7s %7s %10s %10s  %s\n", "File", "Method", "Systems", "Load ms", "Save ms", "Result");
+	for (const FileResult &result : results)
+	{
+		workTime += result.loadTime + result.saveTime;
+		printf("%-40s %-7s %7u %10.3f ", result.relativePath.data(), loadMethodName(result.loadMethod), result.numSystems, result.loadTime);
+		if (result.saved)
+			printf("%10.3f  ", result.saveTime);
+		else
+			printf("%10s  ", "-");
+
+		if (result.loaded == false)
+		{
+			printf("cannot be loaded\n");
+			numNotLoaded++;
+		}
+		else if (result.numIssues > 0)
+		{
+			printf("%u issues, %s\n", result.numIssues, result.firstIssue.data());
+			numInvalid++;
+		}
+		else if (result.saved)
+		{
+			printf("saved to \"%s\"\n", result.savedPath.data());
+			numSaved++;
+		}
+		else if (result.savedPath.isEmpty() == false)
+		{
+			printf("cannot be saved to \"%s\"\n", result.savedPath.data());
+			numNotSaved++;
+		}
+		else
+			printf("ok\n");
+	}
+
+	printf("\n%u files: %u valid, %u invalid, %u not loaded, %u saved, %u not saved\n", results.size(),
+	       results.size() - numInvalid - numNotLoaded, numInvalid, numNotLoaded, numSaved, numNotSaved);
+	printf("%.2f ms with %u threads (%.2f ms of work, %.2fx speedup)\n", totalTime, numWorkers, workTime,
+	       (totalTime > 0.0f) ? workTime / totalTime : 1.0f);
+
+	return (numNotLoaded > 0 || numInvalid > 0 || numNotSaved > 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}